@@ -239,6 +239,7 @@ Player::init_logfile()
     }
 
     dbglogfile.setLogFilename(rcfile.getDebugLog());
+    dbglogfile.setAsync(rcfile.useAsyncLog());
 
     // If logging verbosity was already assigned (from command line) to a
     // non-zero level, leave it intact. Otherwise, use verbosity level from
@@ -312,6 +313,7 @@ Player::init_gui()
 
     _gui->setAudioDump(_audioDump);
     _gui->setMaxAdvances(_maxAdvances);
+    _gui->setMaxFrameSkip(RcInitFile::getDefaultInstance().getMaxFrameSkip());
 
 #ifdef GNASH_FPS_DEBUG
     if (_fpsDebugTime) {
@@ -0,0 +1,718 @@
+// benchmovies.cpp: write the movies of the gnash-bench suite and checks
+//
+//   Copyright (C) 2012 Free Software Foundation, Inc
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+// Usage: benchmovies [-c] <directory>
+//
+// Each movie has two frames whose actions do a fixed amount of work, so
+// that every heart-beat of "gnash-bench -B" runs them once (the actions
+// of a single frame movie only run once). They are
+// built here rather than shipped, as there is no ActionScript compiler
+// in the tree.
+//
+// With -c, the check movies are written instead. They have a single
+// frame that traces "PASSED: <name>" or "FAILED: <name>: <result>" for
+// each result it compares with its reference value, then "DONE".
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <initializer_list>
+#include <iostream>
+#include <string>
+
+namespace {
+
+/// Action codes used by the movies.
+enum ActionCode
+{
+    ACTION_NOT = 0x12,
+    ACTION_POP = 0x17,
+    ACTION_TRACE = 0x26,
+    ACTION_GETVARIABLE = 0x1C,
+    ACTION_SETVARIABLE = 0x1D,
+    ACTION_NEWOBJECT = 0x40,
+    ACTION_INITARRAY = 0x42,
+    ACTION_ADD2 = 0x47,
+    ACTION_LESS2 = 0x48,
+    ACTION_EQUALS2 = 0x49,
+    ACTION_PUSHDUP = 0x4C,
+    ACTION_STACKSWAP = 0x4D,
+    ACTION_GETMEMBER = 0x4E,
+    ACTION_INCREMENT = 0x50,
+    ACTION_CALLMETHOD = 0x52,
+    ACTION_NEWMETHOD = 0x53,
+    ACTION_PUSHDATA = 0x96,
+    ACTION_BRANCHALWAYS = 0x99,
+    ACTION_BRANCHIFTRUE = 0x9D
+};
+
+void
+putU16(std::string& out, std::uint16_t v)
+{
+    out += static_cast<char>(v & 0xff);
+    out += static_cast<char>(v >> 8);
+}
+
+void
+putU32(std::string& out, std::uint32_t v)
+{
+    putU16(out, v & 0xffff);
+    putU16(out, v >> 16);
+}
+
+/// An action block, built one action at a time.
+class Actions
+{
+public:
+
+    /// Append an action without arguments.
+    Actions& op(ActionCode code) {
+        flush();
+        _code += static_cast<char>(code);
+        return *this;
+    }
+
+    /// Append a string to the current PushData action.
+    Actions& push(const std::string& s) {
+        _push += '\0';
+        _push += s;
+        _push += '\0';
+        return *this;
+    }
+
+    /// Append an integer to the current PushData action.
+    Actions& push(std::int32_t n) {
+        _push += '\7';
+        putU32(_push, static_cast<std::uint32_t>(n));
+        return *this;
+    }
+
+    /// Append a number to the current PushData action.
+    Actions& push(double d) {
+        std::uint64_t bits;
+        std::memcpy(&bits, &d, sizeof bits);
+        // The high word comes first.
+        _push += '\6';
+        putU32(_push, bits >> 32);
+        putU32(_push, bits & 0xffffffff);
+        return *this;
+    }
+
+    /// Append a boolean to the current PushData action.
+    Actions& pushBool(bool b) {
+        _push += '\5';
+        _push += static_cast<char>(b);
+        return *this;
+    }
+
+    /// Append undefined to the current PushData action.
+    Actions& pushUndefined() {
+        _push += '\3';
+        return *this;
+    }
+
+    /// Append the actions of another block.
+    Actions& append(Actions& other) {
+        flush();
+        _code += other.code();
+        return *this;
+    }
+
+    /// Pop a condition and run pass if it is true, else fail.
+    Actions& ifElse(Actions& pass, Actions& fail) {
+        const std::string& p = pass.code();
+        const std::string& f = fail.code();
+        branch(ACTION_BRANCHIFTRUE, f.size() + 5);
+        _code += f;
+        branch(ACTION_BRANCHALWAYS, p.size());
+        _code += p;
+        return *this;
+    }
+
+    /// Run body only while the variable is undefined.
+    Actions& once(const std::string& var, Actions& body) {
+        push(var).op(ACTION_GETVARIABLE).pushUndefined()
+            .op(ACTION_EQUALS2).op(ACTION_NOT);
+        const std::string& b = body.code();
+        branch(ACTION_BRANCHIFTRUE, b.size());
+        _code += b;
+        return *this;
+    }
+
+    /// Run body while the variable is less than limit, then increment it.
+    Actions& loop(const std::string& var, std::int32_t limit, Actions& body) {
+        body.push(var).push(var).op(ACTION_GETVARIABLE)
+            .op(ACTION_INCREMENT).op(ACTION_SETVARIABLE);
+
+        Actions cond;
+        cond.push(var).op(ACTION_GETVARIABLE).push(limit)
+            .op(ACTION_LESS2).op(ACTION_NOT);
+
+        // The branch skips the body and the jump back.
+        const std::string& b = body.code();
+        cond.branch(ACTION_BRANCHIFTRUE, b.size() + 5);
+        const std::int32_t back = -static_cast<std::int32_t>(
+                cond.code().size() + b.size() + 5);
+        cond._code += b;
+        cond.branch(ACTION_BRANCHALWAYS, back);
+
+        push(var).push(0).op(ACTION_SETVARIABLE);
+        _code += cond.code();
+        return *this;
+    }
+
+    /// The encoded actions.
+    const std::string& code() {
+        flush();
+        return _code;
+    }
+
+private:
+
+    /// End the current PushData action, if any.
+    void flush() {
+        if (_push.empty()) return;
+        _code += static_cast<char>(ACTION_PUSHDATA);
+        putU16(_code, _push.size());
+        _code += _push;
+        _push.clear();
+    }
+
+    void branch(ActionCode code, std::int32_t offset) {
+        flush();
+        _code += static_cast<char>(code);
+        putU16(_code, 2);
+        putU16(_code, static_cast<std::uint16_t>(offset));
+    }
+
+    std::string _code;
+    std::string _push;
+};
+
+void
+putTag(std::string& out, int code, const std::string& data)
+{
+    if (data.size() < 63) {
+        putU16(out, (code << 6) | data.size());
+        out += data;
+        return;
+    }
+    putU16(out, (code << 6) | 63);
+    putU32(out, data.size());
+    out += data;
+}
+
+/// Write an uncompressed SWF 8 movie running the actions on each frame.
+bool
+writeMovie(const std::string& path, Actions& actions, int frames = 2)
+{
+    // A 200x200 stage: a RECT of 15-bit fields, padded to 9 bytes.
+    static const char stage[] = "\x78\x00\x01\xf4\x00\x00\x07\xd0\x00";
+
+    std::string body(stage, sizeof stage - 1);
+    putU16(body, 12 << 8);
+    putU16(body, frames);
+    putTag(body, 9, std::string("\xff\xff\xff", 3));
+    for (int i = 0; i < frames; ++i) {
+        putTag(body, 12, actions.code() + '\0');
+        putTag(body, 1, std::string());
+    }
+    putTag(body, 0, std::string());
+
+    std::string swf("FWS\x08", 4);
+    putU32(swf, 8 + body.size());
+    swf += body;
+
+    std::ofstream f(path.c_str(), std::ios::binary);
+    f << swf;
+    if (!f) {
+        std::cerr << "benchmovies: cannot write " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+/// Stack-heavy bytecode: pushes, arithmetic, swaps and small arrays.
+//
+/// This mostly copies as_values on and off the stack, so it shows the
+/// cost of the value layout (see GNASH_COMPACT_AS_VALUE).
+void
+stackMovie(Actions& a)
+{
+    Actions body;
+    body.push(1).push(2).push(3).push(4).push(5).push(6).push(7).push(8);
+    for (int i = 0; i < 7; ++i) body.op(ACTION_ADD2);
+    body.op(ACTION_PUSHDUP).op(ACTION_ADD2);
+    body.push("stack").op(ACTION_STACKSWAP).op(ACTION_SETVARIABLE);
+
+    body.push("a").push("b").op(ACTION_ADD2);
+    body.push("c").op(ACTION_STACKSWAP).op(ACTION_ADD2).op(ACTION_POP);
+
+    body.push("x").push("y").push("z").push(3).op(ACTION_INITARRAY);
+    body.push("length").op(ACTION_GETMEMBER).op(ACTION_POP);
+
+    a.loop("i", 2000, body);
+}
+
+/// Parsing a large XML document.
+//
+/// The document has 1024 items of attributes, an entity and text
+/// nodes, about 85kB, and is built once by doubling an item.
+void
+xmlMovie(Actions& a)
+{
+    Actions twice;
+    twice.push("s").push("s").op(ACTION_GETVARIABLE)
+        .push("s").op(ACTION_GETVARIABLE).op(ACTION_ADD2)
+        .op(ACTION_SETVARIABLE);
+
+    Actions build;
+    build.push("s").push("<item id=\"42\" name=\"a &amp; b\">"
+            "<title>Some text</title><value>3.14</value></item>")
+        .op(ACTION_SETVARIABLE);
+    build.loop("j", 10, twice);
+    build.push("s").push("<root>").push("s").op(ACTION_GETVARIABLE)
+        .op(ACTION_ADD2).push("</root>").op(ACTION_ADD2)
+        .op(ACTION_SETVARIABLE);
+
+    a.once("s", build);
+
+    a.push("x").push("s").op(ACTION_GETVARIABLE).push(1).push("XML")
+        .op(ACTION_NEWOBJECT).op(ACTION_SETVARIABLE);
+    a.push("x").op(ACTION_GETVARIABLE).push("firstChild")
+        .op(ACTION_GETMEMBER).push("childNodes").op(ACTION_GETMEMBER)
+        .push("length").op(ACTION_GETMEMBER).op(ACTION_POP);
+}
+
+/// Push a new flash.<package>.<name>, constructed with the nargs
+/// arguments pushed before, last one first.
+void
+construct(Actions& a, const std::string& package, const std::string& name,
+        int nargs)
+{
+    a.push(nargs).push("flash").op(ACTION_GETVARIABLE).push(package)
+        .op(ACTION_GETMEMBER).push(name).op(ACTION_NEWMETHOD);
+}
+
+/// Call a method of the object in a variable with the nargs arguments
+/// pushed before, last one first, and push the result.
+void
+call(Actions& a, const std::string& var, const std::string& method,
+        int nargs)
+{
+    a.push(nargs).push(var).op(ACTION_GETVARIABLE).push(method)
+        .op(ACTION_CALLMETHOD);
+}
+
+/// The ActionScript number of an ARGB colour, as returned by getPixel32.
+std::int32_t
+argb(std::uint32_t c)
+{
+    return static_cast<std::int32_t>(c);
+}
+
+void
+pushRect(Actions& a, int x, int y, int w, int h)
+{
+    a.push(h).push(w).push(y).push(x);
+    construct(a, "geom", "Rectangle", 4);
+}
+
+void
+pushPoint(Actions& a, int x, int y)
+{
+    a.push(y).push(x);
+    construct(a, "geom", "Point", 2);
+}
+
+/// Set a variable to a new BitmapData.
+void
+bitmap(Actions& a, const std::string& var, int w, int h, bool transparent,
+        std::uint32_t fill)
+{
+    a.push(var).push(argb(fill)).pushBool(transparent).push(h).push(w);
+    construct(a, "display", "BitmapData", 4);
+    a.op(ACTION_SETVARIABLE);
+}
+
+void
+setPixel32(Actions& a, const std::string& var, int x, int y,
+        std::uint32_t c)
+{
+    a.push(argb(c)).push(y).push(x);
+    call(a, var, "setPixel32", 3);
+    a.op(ACTION_POP);
+}
+
+/// Push the pixels of a row of a BitmapData, as a string of the values
+/// returned by getPixel32 separated by commas.
+void
+pushRow(Actions& a, const std::string& var, int y, int w)
+{
+    a.push("");
+    for (int x = 0; x < w; ++x) {
+        if (x) a.push(",").op(ACTION_ADD2);
+        a.push(y).push(x);
+        call(a, var, "getPixel32", 2);
+        a.op(ACTION_ADD2);
+    }
+}
+
+/// The string pushed by pushRow() for these colours.
+std::string
+row(std::initializer_list<std::uint32_t> colours)
+{
+    std::string s;
+    for (std::uint32_t c : colours) {
+        if (!s.empty()) s += ',';
+        s += std::to_string(argb(c));
+    }
+    return s;
+}
+
+/// Push "x,y,width,height" of the Rectangle in a variable.
+void
+pushRectString(Actions& a, const std::string& var)
+{
+    a.push("");
+    const char* const members[] = { "x", "y", "width", "height" };
+    for (int i = 0; i < 4; ++i) {
+        if (i) a.push(",").op(ACTION_ADD2);
+        a.push(var).op(ACTION_GETVARIABLE).push(members[i])
+            .op(ACTION_GETMEMBER).op(ACTION_ADD2);
+    }
+}
+
+/// Pop a result and trace whether, as a string, it is the expected one.
+void
+check(Actions& a, const std::string& name, const std::string& expected)
+{
+    a.push("").op(ACTION_ADD2);
+    a.push("result").op(ACTION_STACKSWAP).op(ACTION_SETVARIABLE);
+
+    Actions pass;
+    pass.push("PASSED: " + name).op(ACTION_TRACE);
+
+    Actions fail;
+    fail.push("FAILED: " + name + ": ").push("result")
+        .op(ACTION_GETVARIABLE).op(ACTION_ADD2).op(ACTION_TRACE);
+
+    a.push("result").op(ACTION_GETVARIABLE).push(expected)
+        .op(ACTION_EQUALS2).ifElse(pass, fail);
+}
+
+/// The BitmapData pixel operations on small bitmaps.
+//
+/// The reference values are those of the Flash documentation, except
+/// for pixelDissolve, whose pattern differs: only the number of pixels
+/// dissolved is checked, and that the areas are not overrun.
+void
+bitmapDataMovie(Actions& a)
+{
+    // colorTransform of the left pixel only.
+    bitmap(a, "ct", 2, 1, false, 0x804020);
+    a.push(0).push(255).push(0).push(16).push(1).push(0).push(1).push(0.5);
+    construct(a, "geom", "ColorTransform", 8);
+    pushRect(a, 0, 0, 1, 1);
+    call(a, "ct", "colorTransform", 2);
+    a.op(ACTION_POP);
+    pushRow(a, "ct", 0, 2);
+    check(a, "colorTransform", row({ 0xff5040ff, 0xff804020 }));
+
+    // merge: (source * mult + dest * (256 - mult)) / 256.
+    bitmap(a, "md", 1, 1, false, 0x000000);
+    bitmap(a, "ms", 1, 1, false, 0xffffff);
+    a.push(256).push(256).push(0).push(128);
+    pushPoint(a, 0, 0);
+    pushRect(a, 0, 0, 1, 1);
+    a.push("ms").op(ACTION_GETVARIABLE);
+    call(a, "md", "merge", 7);
+    a.op(ACTION_POP);
+    pushRow(a, "md", 0, 1);
+    check(a, "merge", row({ 0xff7f00ff }));
+
+    // threshold: only the blue channel is tested, and the pixels that
+    // fail keep the destination colour.
+    bitmap(a, "ts", 3, 1, false, 0x000000);
+    setPixel32(a, "ts", 0, 0, 0xff000010);
+    setPixel32(a, "ts", 1, 0, 0xff000080);
+    setPixel32(a, "ts", 2, 0, 0xff0000f0);
+    bitmap(a, "td", 3, 1, false, 0x123456);
+    a.pushBool(false).push(0xff).push(argb(0xffff0000)).push(0x80)
+        .push(">");
+    pushPoint(a, 0, 0);
+    pushRect(a, 0, 0, 3, 1);
+    a.push("ts").op(ACTION_GETVARIABLE);
+    call(a, "td", "threshold", 8);
+    check(a, "threshold count", "1");
+    pushRow(a, "td", 0, 3);
+    check(a, "threshold", row({ 0xff123456, 0xff123456, 0xffff0000 }));
+
+    // paletteMap: the red value 0x10 maps to 0x100, which is added to
+    // the unchanged green, blue and alpha.
+    bitmap(a, "ps", 1, 1, false, 0x102030);
+    bitmap(a, "pd", 1, 1, false, 0x000000);
+    a.push(0x100);
+    for (int i = 0; i < 16; ++i) a.push(0);
+    a.push(17).op(ACTION_INITARRAY);
+    pushPoint(a, 0, 0);
+    pushRect(a, 0, 0, 1, 1);
+    a.push("ps").op(ACTION_GETVARIABLE);
+    call(a, "pd", "paletteMap", 4);
+    a.op(ACTION_POP);
+    pushRow(a, "pd", 0, 1);
+    check(a, "paletteMap", row({ 0xff002130 }));
+
+    // pixelDissolve of a bitmap into itself fills the pixels, here all
+    // of an area of one or two pixels at the bottom or right edge.
+    bitmap(a, "d1", 1, 1, false, 0x0000ff);
+    a.push(argb(0xffff0000)).push(1).push(0);
+    pushPoint(a, 0, 0);
+    pushRect(a, 0, 0, 1, 1);
+    a.push("d1").op(ACTION_GETVARIABLE);
+    call(a, "d1", "pixelDissolve", 6);
+    a.op(ACTION_POP);
+    pushRow(a, "d1", 0, 1);
+    check(a, "pixelDissolve 1x1", row({ 0xffff0000 }));
+
+    bitmap(a, "d2", 2, 2, false, 0x0000ff);
+    a.push(argb(0xffff0000)).push(2).push(1);
+    pushPoint(a, 0, 1);
+    pushRect(a, 0, 1, 2, 1);
+    a.push("d2").op(ACTION_GETVARIABLE);
+    call(a, "d2", "pixelDissolve", 6);
+    a.op(ACTION_POP);
+    pushRow(a, "d2", 0, 2);
+    check(a, "pixelDissolve 2x1 top", row({ 0xff0000ff, 0xff0000ff }));
+    pushRow(a, "d2", 1, 2);
+    check(a, "pixelDissolve 2x1", row({ 0xffff0000, 0xffff0000 }));
+
+    bitmap(a, "d3", 2, 2, false, 0x0000ff);
+    a.push(argb(0xffff0000)).push(2).push(1);
+    pushPoint(a, 1, 0);
+    pushRect(a, 1, 0, 1, 2);
+    a.push("d3").op(ACTION_GETVARIABLE);
+    call(a, "d3", "pixelDissolve", 6);
+    a.op(ACTION_POP);
+    pushRow(a, "d3", 0, 2);
+    a.push(",").op(ACTION_ADD2);
+    pushRow(a, "d3", 1, 2);
+    a.op(ACTION_ADD2);
+    check(a, "pixelDissolve 1x2", row({ 0xff0000ff, 0xffff0000,
+                0xff0000ff, 0xffff0000 }));
+
+    // Passing the returned seed dissolves other pixels; the red pixels
+    // are counted by a threshold that leaves them unchanged.
+    bitmap(a, "ds", 4, 4, false, 0xff0000);
+    bitmap(a, "dd", 4, 4, false, 0x0000ff);
+    Actions count;
+    count.push(-1).push(argb(0xffff0000)).push(argb(0xffff0000))
+        .push("==");
+    pushPoint(count, 0, 0);
+    pushRect(count, 0, 0, 4, 4);
+    count.push("dd").op(ACTION_GETVARIABLE);
+    call(count, "dd", "threshold", 7);
+
+    a.push("seed").push(8).push(0);
+    pushPoint(a, 0, 0);
+    pushRect(a, 0, 0, 4, 4);
+    a.push("ds").op(ACTION_GETVARIABLE);
+    call(a, "dd", "pixelDissolve", 5);
+    a.op(ACTION_SETVARIABLE);
+    a.append(count);
+    check(a, "pixelDissolve count", "8");
+    a.push(8).push("seed").op(ACTION_GETVARIABLE);
+    pushPoint(a, 0, 0);
+    pushRect(a, 0, 0, 4, 4);
+    a.push("ds").op(ACTION_GETVARIABLE);
+    call(a, "dd", "pixelDissolve", 5);
+    a.op(ACTION_POP);
+    a.append(count);
+    check(a, "pixelDissolve seed", "16");
+
+    // scroll keeps the pixels that are not scrolled over.
+    bitmap(a, "sh", 3, 1, false, 0x000000);
+    setPixel32(a, "sh", 0, 0, 0xff000011);
+    setPixel32(a, "sh", 1, 0, 0xff000022);
+    setPixel32(a, "sh", 2, 0, 0xff000033);
+    a.push(0).push(1);
+    call(a, "sh", "scroll", 2);
+    a.op(ACTION_POP);
+    pushRow(a, "sh", 0, 3);
+    check(a, "scroll right", row({ 0xff000011, 0xff000011, 0xff000022 }));
+
+    bitmap(a, "sv", 1, 3, false, 0x000000);
+    setPixel32(a, "sv", 0, 0, 0xff000011);
+    setPixel32(a, "sv", 0, 1, 0xff000022);
+    setPixel32(a, "sv", 0, 2, 0xff000033);
+    a.push(-1).push(0);
+    call(a, "sv", "scroll", 2);
+    a.op(ACTION_POP);
+    pushRow(a, "sv", 0, 1);
+    a.push(",").op(ACTION_ADD2);
+    pushRow(a, "sv", 1, 1);
+    a.op(ACTION_ADD2).push(",").op(ACTION_ADD2);
+    pushRow(a, "sv", 2, 1);
+    a.op(ACTION_ADD2);
+    check(a, "scroll up", row({ 0xff000022, 0xff000033, 0xff000033 }));
+
+    // compare returns 0 for equal bitmaps, -3 or -4 for different sizes
+    // and else a bitmap of the differences.
+    bitmap(a, "ca", 2, 1, false, 0x102030);
+    bitmap(a, "cb", 2, 1, false, 0x102030);
+    a.push("cb").op(ACTION_GETVARIABLE);
+    call(a, "ca", "compare", 1);
+    check(a, "compare equal", "0");
+
+    setPixel32(a, "cb", 1, 0, 0xff0f2040);
+    a.push("cd");
+    a.push("cb").op(ACTION_GETVARIABLE);
+    call(a, "ca", "compare", 1);
+    a.op(ACTION_SETVARIABLE);
+    pushRow(a, "cd", 0, 2);
+    check(a, "compare", row({ 0x00000000, 0xff0100f0 }));
+
+    bitmap(a, "cw", 3, 1, false, 0x102030);
+    a.push("cw").op(ACTION_GETVARIABLE);
+    call(a, "ca", "compare", 1);
+    check(a, "compare width", "-3");
+
+    bitmap(a, "ch", 2, 2, false, 0x102030);
+    a.push("ch").op(ACTION_GETVARIABLE);
+    call(a, "ca", "compare", 1);
+    check(a, "compare height", "-4");
+
+    bitmap(a, "co", 1, 1, true, 0xff000000);
+    bitmap(a, "ct0", 1, 1, true, 0x00000000);
+    a.push("cx");
+    a.push("ct0").op(ACTION_GETVARIABLE);
+    call(a, "co", "compare", 1);
+    a.op(ACTION_SETVARIABLE);
+    pushRow(a, "cx", 0, 1);
+    check(a, "compare alpha", row({ 0xffffffff }));
+
+    // getColorBoundsRect of the red pixels, of the pixels that are not
+    // white, and of a colour that is not found.
+    bitmap(a, "gb", 4, 4, false, 0xffffff);
+    setPixel32(a, "gb", 1, 1, 0xffff0000);
+    setPixel32(a, "gb", 2, 3, 0xffff0000);
+    a.push("bounds").pushBool(true).push(argb(0xffff0000)).push(-1);
+    call(a, "gb", "getColorBoundsRect", 3);
+    a.op(ACTION_SETVARIABLE);
+    pushRectString(a, "bounds");
+    check(a, "getColorBoundsRect", "1,1,2,3");
+
+    a.push("bounds").pushBool(false).push(-1).push(-1);
+    call(a, "gb", "getColorBoundsRect", 3);
+    a.op(ACTION_SETVARIABLE);
+    pushRectString(a, "bounds");
+    check(a, "getColorBoundsRect not", "1,1,2,3");
+
+    a.push("bounds").pushBool(true).push(argb(0xff00ff00)).push(-1);
+    call(a, "gb", "getColorBoundsRect", 3);
+    a.op(ACTION_SETVARIABLE);
+    pushRectString(a, "bounds");
+    check(a, "getColorBoundsRect none", "0,0,0,0");
+
+    // hitTest against a Point, a Rectangle and a BitmapData, with a
+    // single opaque pixel in the middle.
+    bitmap(a, "ht", 3, 3, true, 0x00000000);
+    setPixel32(a, "ht", 1, 1, 0xff000000);
+
+    pushPoint(a, 1, 1);
+    a.push(255);
+    pushPoint(a, 0, 0);
+    call(a, "ht", "hitTest", 3);
+    check(a, "hitTest point", "true");
+
+    pushPoint(a, 0, 0);
+    a.push(255);
+    pushPoint(a, 0, 0);
+    call(a, "ht", "hitTest", 3);
+    check(a, "hitTest point miss", "false");
+
+    pushPoint(a, 11, 11);
+    a.push(255);
+    pushPoint(a, 10, 10);
+    call(a, "ht", "hitTest", 3);
+    check(a, "hitTest offset", "true");
+
+    pushRect(a, 0, 0, 1, 3);
+    a.push(1);
+    pushPoint(a, 0, 0);
+    call(a, "ht", "hitTest", 3);
+    check(a, "hitTest rectangle miss", "false");
+
+    pushRect(a, 0, 0, 2, 2);
+    a.push(1);
+    pushPoint(a, 0, 0);
+    call(a, "ht", "hitTest", 3);
+    check(a, "hitTest rectangle", "true");
+
+    bitmap(a, "hb", 1, 1, true, 0xff000000);
+    a.push(255);
+    pushPoint(a, 1, 1);
+    a.push("hb").op(ACTION_GETVARIABLE).push(255);
+    pushPoint(a, 0, 0);
+    call(a, "ht", "hitTest", 5);
+    check(a, "hitTest bitmap", "true");
+
+    a.push(255);
+    pushPoint(a, 2, 2);
+    a.push("hb").op(ACTION_GETVARIABLE).push(255);
+    pushPoint(a, 0, 0);
+    call(a, "ht", "hitTest", 5);
+    check(a, "hitTest bitmap miss", "false");
+
+    a.push("DONE").op(ACTION_TRACE);
+}
+
+}
+
+int
+main(int argc, char** argv)
+{
+    const bool checks = argc == 3 && !std::strcmp(argv[1], "-c");
+    if (argc != 2 && !checks) {
+        std::cerr << "Usage: " << argv[0] << " [-c] <directory>"
+            << std::endl;
+        return EXIT_FAILURE;
+    }
+    const std::string dir(argv[argc - 1]);
+
+    if (checks) {
+        Actions bitmapData;
+        bitmapDataMovie(bitmapData);
+        return writeMovie(dir + "/bitmapdata.swf", bitmapData, 1) ?
+            EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    Actions stack;
+    stackMovie(stack);
+
+    Actions xml;
+    xmlMovie(xml);
+
+    if (!writeMovie(dir + "/stack.swf", stack) ||
+            !writeMovie(dir + "/xml.swf", xml)) {
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
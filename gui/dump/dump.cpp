@@ -36,11 +36,16 @@
 #include <iostream>
 #include <string>
 #include <fstream>
+#include <sstream>
+#include <chrono>
+#include <algorithm>
 #include <boost/algorithm/string/split.hpp>
 #include <boost/algorithm/string/classification.hpp>
 #include <boost/lexical_cast.hpp>
 #include <csignal>
 #include <cstdlib>
+#include <zlib.h>
+#include <sys/resource.h>
 
 #ifndef HAVE_UNISTD_H
 #error Dump gui requires unistd.h
@@ -62,6 +67,10 @@
 #include "as_environment.h"
 #include "as_value.h"
 #include "Movie.h"
+#include "GnashKey.h"
+#include "GC.h"
+#include "MovieFactory.h"
+#include "MovieLibrary.h"
 
 namespace gnash {
 
@@ -94,7 +103,11 @@ DumpGui::DumpGui(unsigned long xid, float scale, bool loop, RunResources& r)
     _lastVideoFrameDump(0), // this will be computed
     _sleepUS(0),
     _started(false),
-    _startTime(0)
+    _startTime(0),
+    _nextInput(0),
+    _benchFrames(0),
+    _benchAdvances(0),
+    _runCRC(crc32(0L, Z_NULL, 0))
 {
     if (loop) {
         std::cerr << "# WARNING:  Gnash was told to loop the movie\n";
@@ -121,7 +134,7 @@ DumpGui::init(int argc, char **argv[])
     optind = 0;
     opterr = 0;
     int c;
-    while ((c = getopt(argc, *argv, "D:S:T:")) != -1) {
+    while ((c = getopt(argc, *argv, "D:S:T:B:I:")) != -1) {
         if (c == 'D') {
             // Terminate if no filename is given.
             if (!optarg) {
@@ -159,9 +172,31 @@ DumpGui::init(int argc, char **argv[])
             // we take milliseconds
             _startTrigger = optarg;
         }
+        else if (c == 'B') {
+            // Terminate if no frame count is given.
+            if (!optarg) {
+                std::cerr << 
+                    _("# FATAL:  No frame count given with -B argument.\n");
+                return false;
+            }      
+            _benchFrames = std::strtoul(optarg, nullptr, 10);
+        }
+        else if (c == 'I') {
+            // Terminate if no filename is given.
+            if (!optarg) {
+                std::cerr << 
+                    _("# FATAL:  No filename given with -I argument.\n");
+                return false;
+            }      
+            _inputScript = optarg;
+        }
     }
     opterr = origopterr;
 
+    if (!_inputScript.empty() && !loadInputScript()) {
+        return false;
+    }
+
     std::signal(SIGINT, terminate_signal);
     std::signal(SIGTERM, terminate_signal);
 
@@ -203,21 +238,35 @@ DumpGui::run()
     //
     unsigned int clockAdvance = _interval;
 
-    const bool doDisplay = _fileStream.is_open();
+    // Benchmarks always render, so that rendering is measured and
+    // the frames can be checksummed.
+    const bool doDisplay = _fileStream.is_open() || _benchFrames;
 
     terminate_request = false;
 
     _startTime = _clock.elapsed();
 
+    // Wall-clock time spent advancing and rendering, in microseconds.
+    std::uint64_t benchTime = 0;
+    unsigned int advances = 0;
+
     while (!terminate_request) {
 
         _clock.advance(clockAdvance); 
 
+        sendInput(advances++);
+
+        const std::chrono::steady_clock::time_point beat =
+            std::chrono::steady_clock::now();
+
         // advance movie now
         advanceMovie(doDisplay);
 
         if (_started) {
 
+            benchTime += std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - beat).count();
+
             writeSamples();
 
             // Dump a video frame if it's time for it or no frame
@@ -232,6 +281,12 @@ DumpGui::run()
             if (_timeout && _clock.elapsed() >= _timeout) {
                 break;
             }
+
+            if (_benchFrames) {
+                _runCRC = crc32(_runCRC, _offscreenbuf.get(),
+                        _offscreenbuf_size);
+                if (++_benchAdvances >= _benchFrames) break;
+            }
         }
 
         if (_sleepUS) gnashSleep(_sleepUS);
@@ -263,6 +318,8 @@ DumpGui::run()
 
     std::cout << "TIME=" << total_time << std::endl;
     std::cout << "FPS_ACTUAL=" << _fileOutputFPS << std::endl;
+
+    if (_benchFrames) writeBenchReport(benchTime);
     
     // In this Gui, quit() does not exit, but it is necessary to catch the
     // last frame for screenshots.
@@ -270,6 +327,131 @@ DumpGui::run()
     return true;
 }
 
+void
+DumpGui::writeBenchReport(std::uint64_t wallTimeUS)
+{
+    movie_root& mr = *getStage();
+    const GC::Stats& gc = mr.gc().stats();
+    const std::uint64_t actions = mr.getVM().actionCount();
+    const MovieLibrary::Stats lib = MovieFactory::movieLibrary.stats();
+
+    // The buffer still holds the last rendered frame.
+    const std::uint32_t frameCRC = crc32(crc32(0L, Z_NULL, 0),
+            _offscreenbuf.get(), _offscreenbuf_size);
+
+    // ru_maxrss is in kilobytes on Linux.
+    struct rusage usage;
+    const long peakRSS = getrusage(RUSAGE_SELF, &usage) ? 0 : usage.ru_maxrss;
+
+    const double seconds = wallTimeUS / 1000000.0;
+
+    std::cout << "# Benchmark results\n" <<
+        "BENCH_FRAMES=" << _benchAdvances << "\n" <<
+        "BENCH_TIME_MS=" << wallTimeUS / 1000 << "\n" <<
+        "BENCH_FPS=" << (seconds ? _benchAdvances / seconds : 0) << "\n" <<
+        "BENCH_ACTIONS=" << actions << "\n" <<
+        "BENCH_ACTIONS_PER_SEC=" << (seconds ? actions / seconds : 0) << "\n" <<
+        "BENCH_PEAK_RSS_KB=" << peakRSS << "\n" <<
+        "BENCH_GC_RUNS=" << gc.runs << "\n" <<
+        "BENCH_GC_COLLECTED=" << gc.collected << "\n" <<
+        "BENCH_GC_TOTAL_US=" << gc.totalTime << "\n" <<
+        "BENCH_GC_MAX_US=" << gc.maxTime << "\n" <<
+        "BENCH_LIBRARY_HITS=" << lib.urlHits + lib.contentHits << "\n" <<
+        "BENCH_LIBRARY_MISSES=" << lib.misses << "\n" <<
+        "BENCH_LIBRARY_KB=" << lib.bytes / 1024 << "\n" <<
+        std::hex <<
+        "BENCH_FRAME_CRC32=" << frameCRC << "\n" <<
+        "BENCH_RUN_CRC32=" << _runCRC << std::dec << std::endl;
+}
+
+bool
+DumpGui::loadInputScript()
+{
+    std::ifstream in(_inputScript.c_str());
+    if (!in) {
+        std::cerr << "# FATAL:  Unable to read input script '"
+            << _inputScript << "'" << std::endl;
+        return false;
+    }
+
+    // Each line is "<heart-beat> <event> [<args>]", where the event is
+    // one of "key <code> down|up", "move <x> <y>", "press" and
+    // "release". Everything after a '#' is ignored.
+    std::string line;
+    size_t lineno = 0;
+    while (std::getline(in, line)) {
+        ++lineno;
+        const std::string::size_type comment = line.find('#');
+        if (comment != std::string::npos) line.erase(comment);
+
+        std::istringstream is(line);
+        InputEvent ev;
+        std::string type;
+        if (!(is >> ev.advance >> type)) continue;
+
+        ev.x = ev.y = 0;
+        bool ok = true;
+        if (type == "key") {
+            std::string state;
+            ok = (is >> ev.x >> state) && ev.x > 0 && ev.x < key::KEYCOUNT &&
+                (state == "down" || state == "up");
+            ev.type = state == "down" ? InputEvent::KEY_DOWN :
+                InputEvent::KEY_UP;
+        }
+        else if (type == "move") {
+            ok = static_cast<bool>(is >> ev.x >> ev.y);
+            ev.type = InputEvent::MOUSE_MOVE;
+        }
+        else if (type == "press") {
+            ev.type = InputEvent::MOUSE_PRESS;
+        }
+        else if (type == "release") {
+            ev.type = InputEvent::MOUSE_RELEASE;
+        }
+        else ok = false;
+
+        if (!ok) {
+            std::cerr << "# WARNING:  Ignoring malformed line " << lineno
+                << " of input script '" << _inputScript << "'\n";
+            continue;
+        }
+        _inputEvents.push_back(ev);
+    }
+
+    // Keep the file order for events sent at the same heart-beat.
+    std::stable_sort(_inputEvents.begin(), _inputEvents.end(),
+        [](const InputEvent& a, const InputEvent& b) {
+            return a.advance < b.advance;
+        });
+
+    log_debug("DumpGui: %d scripted input events", _inputEvents.size());
+    return true;
+}
+
+void
+DumpGui::sendInput(unsigned int advance)
+{
+    while (_nextInput < _inputEvents.size() &&
+            _inputEvents[_nextInput].advance <= advance) {
+
+        const InputEvent& ev = _inputEvents[_nextInput++];
+        switch (ev.type) {
+            case InputEvent::KEY_DOWN:
+            case InputEvent::KEY_UP:
+                notify_key_event(static_cast<key::code>(ev.x), 0,
+                        ev.type == InputEvent::KEY_DOWN);
+                break;
+            case InputEvent::MOUSE_MOVE:
+                notifyMouseMove(ev.x, ev.y);
+                break;
+            case InputEvent::MOUSE_PRESS:
+            case InputEvent::MOUSE_RELEASE:
+                notifyMouseClick(ev.type == InputEvent::MOUSE_PRESS);
+                break;
+        }
+    }
+}
+
 void
 DumpGui::setTimeout(unsigned int timeout)
 {
@@ -29,6 +29,8 @@
 
 #include <string>
 #include <fstream>
+#include <vector>
+#include <cstdint>
 
 namespace gnash {
     namespace sound {
@@ -73,6 +75,9 @@ class DSOEXPORT DumpGui : public Gui
     void writeFrame();
     void writeSamples();
 
+    /// Print the results of a benchmark run in sh-sourceable format
+    void writeBenchReport(std::uint64_t wallTimeUS);
+
     virtual VirtualClock& getClock() { return _clock; }
 
 private:
@@ -113,6 +118,39 @@ private:
 
     size_t _startTime;
 
+    /// A scripted input event, sent before the given heart-beat
+    struct InputEvent
+    {
+        enum Type {
+            KEY_DOWN,
+            KEY_UP,
+            MOUSE_MOVE,
+            MOUSE_PRESS,
+            MOUSE_RELEASE
+        };
+
+        unsigned int advance;
+        Type type;
+        int x;      // key code for key events
+        int y;
+    };
+
+    /// Read the scripted input file given with -I
+    //
+    /// @return false if the file could not be read.
+    bool loadInputScript();
+
+    /// Send the scripted input events due at the given heart-beat
+    void sendInput(unsigned int advance);
+
+    std::string _inputScript;          /* path to scripted input file */
+    std::vector<InputEvent> _inputEvents;
+    size_t _nextInput;                 /* next input event to send */
+
+    unsigned int _benchFrames;         /* heart-beats to run, 0 if no bench */
+    unsigned int _benchAdvances;       /* heart-beats run so far */
+    std::uint32_t _runCRC;             /* checksum of all frames */
+
 };
 
 // end of namespace gnash 
@@ -0,0 +1,58 @@
+#!/bin/sh
+#
+# gnash-bench.sh: run every movie of a directory headlessly and print
+# the benchmark results as CSV, one line per movie.
+#
+#   Copyright (C) 2012 Free Software Foundation, Inc
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+#
+# Usage: gnash-bench.sh <directory> [<frames>]
+#
+# The player is the one built with "make -f Makefile.bench"; set
+# GNASH_BENCH to use another one. A movie.swf.input file next to a
+# movie is used as its scripted input (see README).
+
+dir="$1"
+frames="${2:-600}"
+bench="${GNASH_BENCH:-./gnash-bench}"
+
+if test -z "$dir" || test ! -d "$dir"; then
+    echo "Usage: $0 <directory> [<frames>]" >&2
+    exit 1
+fi
+
+echo "movie,frames,time_ms,fps,actions,actions_per_sec,peak_rss_kb,gc_runs,gc_collected,gc_total_us,gc_max_us,frame_crc32,run_crc32"
+
+for movie in "$dir"/*.swf; do
+    test -f "$movie" || continue
+
+    input=""
+    if test -f "$movie.input"; then
+        input="-I $movie.input"
+    fi
+
+    # The results are printed in sh-sourceable format.
+    results=`"$bench" "$movie" -B "$frames" $input 2>/dev/null | grep '^BENCH_'`
+    if test -z "$results"; then
+        echo "# $movie: no results" >&2
+        continue
+    fi
+
+    (
+        eval "$results"
+        echo "`basename "$movie"`,$BENCH_FRAMES,$BENCH_TIME_MS,$BENCH_FPS,$BENCH_ACTIONS,$BENCH_ACTIONS_PER_SEC,$BENCH_PEAK_RSS_KB,$BENCH_GC_RUNS,$BENCH_GC_COLLECTED,$BENCH_GC_TOTAL_US,$BENCH_GC_MAX_US,$BENCH_FRAME_CRC32,$BENCH_RUN_CRC32"
+    )
+done
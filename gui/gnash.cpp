@@ -496,6 +496,10 @@ getSupportedOptions(gnash::Player& p)
         _("Number of milliseconds to sleep between advances"))
     (",T", po::value<string>(),
         _("Trigger expression to start dumping"))
+    (",B", po::value<string>(),
+        _("Benchmark: number of heart-beats to run before reporting"))
+    (",I", po::value<string>(),
+        _("Scripted input file"))
     ;
 
     desc.add(dumpOpts);
@@ -33,12 +33,15 @@
 #include "sound_handler.h"
 #include "movie_root.h"
 #include "VM.h"
+#include "SharedObject_as.h"
 #include "DisplayObject.h"
 #include "GnashEnums.h"
 #include "RunResources.h"
 #include "StreamProvider.h"
 #include "ScreenShotter.h"
 #include "Movie.h"
+#include "MovieFactory.h"
+#include "FrameTimes.h"
 
 #ifdef GNASH_FPS_DEBUG
 #include "ClockTime.h"
@@ -100,6 +103,7 @@ Gui::Gui(RunResources& r) :
     _mouseShown(true),
     _maxAdvances(0),
     _advances(0),
+    _maxFrameSkip(0),
     _xscale(1.0f),
     _yscale(1.0f),
     _xoffset(0),
@@ -144,6 +148,7 @@ Gui::Gui(unsigned long xid, float scale, bool loop, RunResources& r)
     _mouseShown(true),
     _maxAdvances(0),
     _advances(0),
+    _maxFrameSkip(0),
     _xscale(scale),
     _yscale(scale),
     _xoffset(0), // TODO: x and y offset will need update !
@@ -186,6 +191,10 @@ Gui::~Gui()
                   << fps_counter_total << "/" << frames_dropped << std::endl;
     }
 #endif
+
+#ifdef GNASH_FRAME_TIMES
+    FrameTimes::getDefaultInstance().dump();
+#endif
 }
     
 void
@@ -220,7 +229,13 @@ Gui::quit()
         Display dis(*this, *_stage);
         _screenShotter->last(*_renderer, &dis);
     }
-    
+
+    // Some GUIs quit with exit(), which never destroys the VM, so the
+    // SharedObjects must be on disk before quitUI(). The prefetcher
+    // must not be adding to the movie library while exit() destroys it.
+    if (_stage) _stage->getVM().getSharedObjectLibrary().clear();
+    MovieFactory::stopPrefetching();
+
     quitUI();
 }
 
@@ -914,6 +929,9 @@ Gui::start()
     // to properly update stageMatrix if scaling is given  
     resize_view(_width, _height); 
 
+    // allow the timeline to catch up on the frames we skip
+    _stage->setMaxLateFrames(_maxFrameSkip);
+
     // @todo since we registered the sound handler, shouldn't we know
     //       already what it is ?!
 #ifdef USE_SOUND
@@ -943,6 +961,10 @@ Gui::advanceMovie(bool doDisplay)
         start();
     }
 
+#ifdef GNASH_FRAME_TIMES
+    FrameTimes::getDefaultInstance().beginFrame();
+#endif
+
     Display dis(*this, *_stage);
     gnash::movie_root* m = _stage;
     
@@ -967,7 +989,7 @@ Gui::advanceMovie(bool doDisplay)
 #ifdef GNASH_FPS_DEBUG
     // will be a no-op if fps_timer_interval is zero
     if (advanced) {
-        fpsCounterTick();
+        fpsCounterTick(!doDisplay);
     }
 #endif
     
@@ -1001,6 +1023,24 @@ Gui::advanceMovie(bool doDisplay)
 	return advanced;
 }
 
+unsigned int
+Gui::skipLateFrames()
+{
+    if (!_maxFrameSkip || !_started || isStopped()) {
+        return 0;
+    }
+
+    unsigned int skipped = 0;
+
+    // Leave the last due frame to be rendered by the caller.
+    while (skipped < _maxFrameSkip && _stage->framesDue() > 1) {
+        if (!advanceMovie(false)) break;
+        ++skipped;
+    }
+
+    return skipped;
+}
+
 void
 Gui::setScreenShotter(std::unique_ptr<ScreenShotter> ss)
 {
@@ -1166,12 +1206,13 @@ Gui::getMovieInfo() const
 
 #ifdef GNASH_FPS_DEBUG
 void 
-Gui::fpsCounterTick()
+Gui::fpsCounterTick(bool dropped)
 {
 
-  // increment this *before* the early return so that
+  // increment these *before* the early return so that
   // frame count on exit is still valid
   ++fps_counter_total;
+  if (dropped) ++frames_dropped;
 
   if (! fps_timer_interval) {
       return;
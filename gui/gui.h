@@ -264,6 +264,18 @@ public:
     ///
     bool advanceMovie(bool doDisplay = true);
 
+    /// Advance the movie without rendering while it is more than one
+    /// frame late.
+    //
+    /// To be called by the main loop when it is behind schedule, before
+    /// advanceMovie(). At most the number of frames set by
+    /// setMaxFrameSkip() are skipped, so that the display is still
+    /// updated on slow hardware.
+    ///
+    /// @return the number of frames advanced without rendering.
+    ///
+    unsigned int skipLateFrames();
+
     /// Convenience static wrapper around advanceMovie for callbacks happiness.
     //
     /// NOTE: this function always return TRUE, for historical reasons.
@@ -350,6 +362,11 @@ public:
 
     /// Set the maximum number of frame advances before Gnash exits.
     void setMaxAdvances(unsigned long ul) { if (ul) _maxAdvances = ul; }
+
+    /// Set the maximum number of consecutive frames not rendered when late.
+    //
+    /// 0 disables frame skipping.
+    void setMaxFrameSkip(unsigned int n) { _maxFrameSkip = n; }
     
     void showUpdatedRegions(bool x) { _showUpdatedRegions = x; }
     bool showUpdatedRegions() const { return _showUpdatedRegions; }
@@ -521,6 +538,9 @@ protected:
     /// Counter to keep track of frame advances
     unsigned long _advances;
 
+    /// Maximum number of consecutive frames skipped when late.
+    unsigned int _maxFrameSkip;
+
     /// Name of a file to dump audio to
     std::string _audioDump;
 
@@ -579,7 +599,10 @@ private:
     //
     /// Based on fps-timer_interval. See setFpsTimerInterval.
     ///
-    void fpsCounterTick();
+    /// @param dropped
+    ///     True if the frame was not rendered.
+    ///
+    void fpsCounterTick(bool dropped);
 
 #endif // def GNASH_FPS_DEBUG
 
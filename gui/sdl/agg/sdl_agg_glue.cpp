@@ -22,6 +22,7 @@
 #include "log.h"
 #include "Renderer.h"
 #include "Renderer_agg.h"
+#include "FrameTimes.h"
 #include <cerrno>
 #include <ostream>
 
@@ -284,6 +285,8 @@ int firstime = 0;
 void
 SdlAggGlue::render(int minx, int miny, int maxx, int maxy)
 {
+    GNASH_FRAME_PHASE(BLIT);
+
     // Update only the invalidated rectangle
    // SDL_BlitSurface(_sdl_surface, nullptr, _screen, nullptr);
    
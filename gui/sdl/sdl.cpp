@@ -21,6 +21,7 @@
 #include "gnashconfig.h"
 #endif
 
+#include <algorithm>
 #include <cstdio>
 
 #include "log.h"
@@ -28,6 +29,8 @@
 #include "Range2d.h" // for Intersection of inv bounds
 #include "Renderer.h" // for setInvalidatedRegions
 #include "RunResources.h"
+#include "movie_root.h"
+#include "FrameTimes.h"
 
 extern int internal_width, internal_height, hw_width, hw_height;
 int mouse_mode = 0;
@@ -40,6 +43,13 @@ using namespace std;
 namespace gnash 
 {
 
+namespace {
+
+/// The shortest wait for an interval timer, in milliseconds.
+const int minTimerDelay = 10;
+
+}
+
 SDLGui::SDLGui(unsigned long xid, float scale, bool loop, RunResources& r)
  : Gui(xid, scale, loop, r),
    _timeout(0),
@@ -127,6 +137,13 @@ SDLGui::run()
             }
             case SDL_KEYDOWN:
             {
+#ifdef GNASH_FRAME_TIMES
+                if (event.key.keysym.sym == SDLK_F12)
+                {
+                    FrameTimes::getDefaultInstance().dump();
+                    break;
+                }
+#endif
 				if (mouse_mode == 0)
 				{
 					if (event.key.keysym.sym == SDLK_TAB)
@@ -186,15 +203,43 @@ SDLGui::run()
             }
         }
 
-        // Wait until real time catches up with movie time.
-        int delay = movie_time - SDL_GetTicks();
+        // Wait until real time catches up with movie time, or until
+        // the next interval timer expires if that comes first.
+        const int delay = movie_time - SDL_GetTicks();
+        movie_root* m = getStage();
+        const int timer_delay = m ? m->timeToNextTimer() : -1;
+        if (timer_delay >= 0 && std::max(timer_delay, minTimerDelay) < delay)
+        {
+            // Only run the timers; whatever they change is rendered
+            // with the next frame. Due or very short intervals still
+            // sleep a little rather than spin.
+            SDL_Delay(std::max(timer_delay, minTimerDelay));
+            advanceMovie(false);
+            continue;
+        }
+        unsigned int skipped = 0;
         if (delay > 0)
         {
             SDL_Delay(delay);
         }
+        else
+        {
+            // We're late: skip rendering of the frames we can't afford,
+            // so the timeline keeps up with real time.
+            skipped = skipLateFrames();
+        }
 
         advanceMovie();
-        movie_time += _interval;        // Time next frame should be displayed
+
+        // Time next frame should be displayed, after the skipped ones.
+        // If we're still more than a frame behind, start again from now
+        // rather than rendering the backlog without waiting.
+        movie_time += (skipped + 1) * _interval;
+        const Uint32 now = SDL_GetTicks();
+        if (movie_time + _interval < now)
+        {
+            movie_time = now + _interval;
+        }
     }
     return false;
 }
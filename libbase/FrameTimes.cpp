@@ -0,0 +1,179 @@
+// FrameTimes.cpp:  Per-frame timing of the player's main phases, for Gnash.
+//
+//   Copyright (C) 2005, 2006, 2007, 2008, 2009, 2010, 2011, 2012
+//   Free Software Foundation, Inc
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+//
+
+#include "FrameTimes.h"
+
+#include <chrono>
+#include <fstream>
+#include <ostream>
+#include <algorithm>
+#include <limits>
+
+#include "log.h"
+
+namespace gnash {
+
+FrameTimes&
+FrameTimes::getDefaultInstance()
+{
+    static FrameTimes ft;
+    return ft;
+}
+
+FrameTimes::FrameTimes()
+    :
+    _frames(capacity),
+    _next(0),
+    _count(0),
+    _total(0)
+{
+}
+
+std::uint64_t
+FrameTimes::now()
+{
+    using namespace std::chrono;
+    return duration_cast<microseconds>(
+            steady_clock::now().time_since_epoch()).count();
+}
+
+const char*
+FrameTimes::phaseName(Phase p)
+{
+    switch (p) {
+        case ADVANCE_LIVE_CHARS:
+            return "advanceLiveChars";
+        case PROCESS_ACTION_QUEUE:
+            return "processActionQueue";
+        case EXECUTE_TIMERS:
+            return "executeTimers";
+        case CLEANUP_AND_COLLECT:
+            return "cleanupAndCollect";
+        case INVALIDATED_BOUNDS:
+            return "add_invalidated_bounds";
+        case DISPLAY:
+            return "display";
+        case RASTERIZE:
+            return "rasterize";
+        case BLIT:
+            return "blit";
+        default:
+            return "unknown";
+    }
+}
+
+void
+FrameTimes::beginFrame()
+{
+    Frame& f = _frames[_next];
+    f.start = now();
+    std::fill_n(f.duration, PHASE_COUNT, 0);
+    std::fill_n(f.offset, PHASE_COUNT,
+            std::numeric_limits<std::uint32_t>::max());
+
+    _next = (_next + 1) % capacity;
+    if (_count < capacity) ++_count;
+    ++_total;
+}
+
+void
+FrameTimes::add(Phase p, std::uint64_t start, std::uint64_t end)
+{
+    // Nothing is recorded before the first frame.
+    if (!_count) return;
+
+    Frame& f = _frames[(_next + capacity - 1) % capacity];
+    f.duration[p] += end - start;
+
+    if (f.offset[p] == std::numeric_limits<std::uint32_t>::max()) {
+        f.offset[p] = start > f.start ? start - f.start : 0;
+    }
+}
+
+void
+FrameTimes::dumpCSV(std::ostream& os) const
+{
+    os << "frame,start_us";
+    for (size_t p = 0; p < PHASE_COUNT; ++p) {
+        os << "," << phaseName(static_cast<Phase>(p)) << "_us";
+    }
+    os << "\n";
+
+    const std::uint64_t first = _total - _count;
+    for (size_t i = 0; i < _count; ++i) {
+        const Frame& f = frame(i);
+        os << first + i << "," << f.start;
+        for (size_t p = 0; p < PHASE_COUNT; ++p) {
+            os << "," << f.duration[p];
+        }
+        os << "\n";
+    }
+}
+
+void
+FrameTimes::dumpTrace(std::ostream& os) const
+{
+    // Each phase is reported once per frame, starting at its first
+    // occurrence and lasting the accumulated time.
+    os << "{\"traceEvents\":[";
+
+    bool first = true;
+    const std::uint64_t firstFrame = _total - _count;
+    for (size_t i = 0; i < _count; ++i) {
+        const Frame& f = frame(i);
+        os << (first ? "\n" : ",\n")
+           << "{\"name\":\"frame " << firstFrame + i << "\",\"ph\":\"i\","
+           << "\"s\":\"p\",\"pid\":1,\"tid\":1,\"ts\":" << f.start << "}";
+        first = false;
+
+        for (size_t p = 0; p < PHASE_COUNT; ++p) {
+            if (!f.duration[p]) continue;
+            os << ",\n{\"name\":\"" << phaseName(static_cast<Phase>(p))
+               << "\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":"
+               << f.start + f.offset[p] << ",\"dur\":" << f.duration[p]
+               << "}";
+        }
+    }
+    os << "\n]}\n";
+}
+
+bool
+FrameTimes::dump(const std::string& prefix) const
+{
+    const std::string csvName = prefix + ".csv";
+    std::ofstream csv(csvName.c_str());
+    if (csv) dumpCSV(csv);
+
+    const std::string traceName = prefix + ".json";
+    std::ofstream trace(traceName.c_str());
+    if (trace) dumpTrace(trace);
+
+    if (!csv || !trace) {
+        log_error(_("Could not write frame times to %s and %s"),
+                csvName, traceName);
+        return false;
+    }
+
+    log_debug("Wrote times of %d frames to %s and %s", _count, csvName,
+            traceName);
+    return true;
+}
+
+} // namespace gnash
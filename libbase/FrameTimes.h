@@ -0,0 +1,158 @@
+// FrameTimes.h:  Per-frame timing of the player's main phases, for Gnash.
+//
+//   Copyright (C) 2005, 2006, 2007, 2008, 2009, 2010, 2011, 2012
+//   Free Software Foundation, Inc
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+//
+
+#ifndef GNASH_FRAMETIMES_H
+#define GNASH_FRAMETIMES_H
+
+#include "dsodefs.h" // for DSOEXPORT
+
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+#include <boost/noncopyable.hpp>
+
+/// Time the enclosing scope as the given FrameTimes::Phase.
+//
+/// This compiles to nothing unless GNASH_FRAME_TIMES is defined
+/// (make FRAME_TIMES=YES).
+#ifdef GNASH_FRAME_TIMES
+# define GNASH_FRAME_PHASE(phase) \
+    gnash::FrameTimes::Scope frameTimesScope_(gnash::FrameTimes::phase)
+#else
+# define GNASH_FRAME_PHASE(phase)
+#endif
+
+namespace gnash {
+
+/// Records how long each phase of the last frames took.
+//
+/// Frames are kept in a ring buffer, so only the most recent ones are
+/// available. Each frame holds the accumulated time spent in every
+/// phase, in microseconds of a monotonic clock. Phases can nest:
+/// RASTERIZE is part of DISPLAY.
+///
+/// The records can be dumped as CSV or in the Chrome trace event
+/// format (chrome://tracing, Perfetto).
+class DSOEXPORT FrameTimes : boost::noncopyable
+{
+public:
+
+    enum Phase {
+        ADVANCE_LIVE_CHARS,
+        PROCESS_ACTION_QUEUE,
+        EXECUTE_TIMERS,
+        CLEANUP_AND_COLLECT,
+        INVALIDATED_BOUNDS,
+        DISPLAY,
+        RASTERIZE,
+        BLIT,
+        PHASE_COUNT
+    };
+
+    /// Time a phase for as long as the Scope exists.
+    class Scope : boost::noncopyable
+    {
+    public:
+        explicit Scope(Phase p)
+            :
+            _phase(p),
+            _start(FrameTimes::now())
+        {}
+
+        ~Scope() {
+            FrameTimes::getDefaultInstance().add(_phase, _start,
+                    FrameTimes::now());
+        }
+
+    private:
+        const Phase _phase;
+        const std::uint64_t _start;
+    };
+
+    /// Return the FrameTimes instance used by the player.
+    static FrameTimes& getDefaultInstance();
+
+    /// Return the current time of a monotonic clock, in microseconds.
+    static std::uint64_t now();
+
+    /// Return the name of a phase, as used in dumps.
+    static const char* phaseName(Phase p);
+
+    /// Start recording a new frame, overwriting the oldest if full.
+    void beginFrame();
+
+    /// Add time spent in a phase to the current frame.
+    void add(Phase p, std::uint64_t start, std::uint64_t end);
+
+    /// Number of frames currently recorded.
+    size_t size() const { return _count; }
+
+    /// Write a line per frame, with a column per phase.
+    void dumpCSV(std::ostream& os) const;
+
+    /// Write the frames as Chrome trace events (JSON).
+    void dumpTrace(std::ostream& os) const;
+
+    /// Write both dumps to files named from the given prefix.
+    //
+    /// @param prefix   The files written are prefix.csv and prefix.json.
+    /// @return         false if any of the files could not be written.
+    bool dump(const std::string& prefix = "gnash-frametimes") const;
+
+private:
+
+    /// Number of frames kept.
+    static const size_t capacity = 1024;
+
+    struct Frame
+    {
+        /// Frame start time, in microseconds.
+        std::uint64_t start;
+
+        /// Time spent in each phase, in microseconds.
+        std::uint32_t duration[PHASE_COUNT];
+
+        /// Offset of the first occurrence of each phase from start.
+        std::uint32_t offset[PHASE_COUNT];
+    };
+
+    FrameTimes();
+
+    /// Return the index-th oldest frame.
+    const Frame& frame(size_t index) const {
+        return _frames[(_next + capacity - _count + index) % capacity];
+    }
+
+    std::vector<Frame> _frames;
+
+    /// Ring buffer slot of the next frame.
+    size_t _next;
+
+    /// Number of frames recorded, at most capacity.
+    size_t _count;
+
+    /// Total number of frames begun, used to number them.
+    std::uint64_t _total;
+};
+
+} // namespace gnash
+
+#endif // GNASH_FRAMETIMES_H
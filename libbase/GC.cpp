@@ -20,6 +20,8 @@
 #include "GC.h"
 
 #include <cstdlib>
+#include <chrono>
+#include <algorithm>
 
 #include "utility.h" // for typeName()
 #include "GnashAlgorithm.h"
@@ -117,14 +119,24 @@ GC::runCycle()
             _lastResCount, _resListSize);
 #endif // GNASH_GC_DEBUG
 
+    const std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+
     // Mark all resources as reachable
     markReachable();
 
     // clean unreachable resources, and mark the others as reachable again
-    cleanUnreachable();
+    _stats.collected += cleanUnreachable();
 
     _lastResCount = _resListSize;
 
+    const std::uint64_t elapsed =
+        std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - start).count();
+    ++_stats.runs;
+    _stats.totalTime += elapsed;
+    _stats.maxTime = std::max(_stats.maxTime, elapsed);
+
 }
 
 void
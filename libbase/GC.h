@@ -29,6 +29,7 @@
 //   
 //#define GNASH_GC_DEBUG 1
 
+#include <cstdint>
 #include <forward_list>
 #include <map>
 #include <string>
@@ -259,6 +260,27 @@ public:
 
     typedef std::map<std::string, unsigned int> CollectablesCount;
 
+    /// Statistics about the collection cycles run so far
+    struct Stats
+    {
+        Stats() : runs(0), collected(0), totalTime(0), maxTime(0) {}
+
+        /// Number of collection cycles run.
+        size_t runs;
+
+        /// Number of resources deleted.
+        size_t collected;
+
+        /// Total time spent collecting, in microseconds.
+        std::uint64_t totalTime;
+
+        /// Duration of the longest cycle, in microseconds.
+        std::uint64_t maxTime;
+    };
+
+    /// Return statistics about the collection cycles run so far
+    const Stats& stats() const { return _stats; }
+
     /// Count collectables
     void countCollectables(CollectablesCount& count) const;
 
@@ -297,6 +319,9 @@ private:
     /// collect() call.
     ResList::size_type _lastResCount;
 
+    /// Collection cycle statistics
+    Stats _stats;
+
 #ifdef GNASH_GC_DEBUG 
     /// Number of times the collector runs (stats/profiling)
     size_t _collectorRuns;
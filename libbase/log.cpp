@@ -21,6 +21,7 @@
 #include "log.h"
 
 #include <ctime> 
+#include <cstdio>
 #include <cctype> 
 #include <cstring> 
 #include <iostream>
@@ -31,6 +32,9 @@
 #include <string>
 #include <thread>
 #include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <vector>
 #include <boost/format.hpp>
 
 #include <unistd.h> // for getpid
@@ -73,6 +77,8 @@ hexify(const unsigned char *p, size_t length, bool ascii)
 
 }
 
+int logVerbosity = 0;
+
 LogFile&
 LogFile::getDefaultInstance()
 {
@@ -88,12 +94,16 @@ namespace {
     struct Timestamp {
         std::uint64_t startTicks;
         std::map<std::thread::id, int> threadMap;
+        std::mutex mutex;
         Timestamp() : startTicks(clocktime::getTicks()) {}
     };
 
     std::ostream& operator<< (std::ostream& o, Timestamp& t)
     {
         std::thread::id tid = std::this_thread::get_id();
+
+        // Messages are stamped by the logging threads themselves.
+        std::lock_guard<std::mutex> lock(t.mutex);
         int& htid = t.threadMap[tid];
         if (!htid) {
             htid = t.threadMap.size();
@@ -112,6 +122,157 @@ namespace {
 
 }
 
+/// Writes the messages queued by LogFile::log() from its own thread.
+//
+/// The queue is a fixed ring of entries whose strings are swapped in
+/// and out, so a message is only moved while the lock is held and the
+/// entries keep their buffers from one use to the next.
+class LogFile::Writer
+{
+public:
+
+    explicit Writer(LogFile& log)
+        :
+        _log(log),
+        _ring(capacity),
+        _head(0),
+        _size(0),
+        _writing(false),
+        _flushing(0),
+        _done(false),
+        _thread(&Writer::run, this)
+    {
+    }
+
+    /// Write all queued messages and stop the thread.
+    ~Writer()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _done = true;
+        }
+        _ready.notify_one();
+        _thread.join();
+    }
+
+    /// Queue a message, waiting for room if the ring is full.
+    void push(std::string& stamp, std::string& msg)
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _space.wait(lock, [this] { return _size < capacity; });
+
+        Entry& e = _ring[(_head + _size) % capacity];
+        e.stamp.swap(stamp);
+        e.msg.swap(msg);
+        ++_size;
+        if (_size == 1 || _size == capacity / 2) _ready.notify_one();
+    }
+
+    /// Wait until the writer is done with all queued messages.
+    void flush()
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        ++_flushing;
+        _ready.notify_one();
+        _space.wait(lock, [this] { return !_size && !_writing; });
+        --_flushing;
+    }
+
+private:
+
+    struct Entry
+    {
+        std::string stamp;
+        std::string msg;
+    };
+
+    void run()
+    {
+        std::vector<Entry> batch;
+
+        std::unique_lock<std::mutex> lock(_mutex);
+        for (;;) {
+            _ready.wait(lock, [this] { return _size || _done; });
+
+            // Give a burst of messages the time to arrive, so that they
+            // are written together rather than waking us one by one.
+            _ready.wait_for(lock, batchDelay, [this] {
+                return _size >= capacity / 2 || _flushing || _done;
+            });
+            if (!_size) break;
+
+            // Take everything queued so far, then write it unlocked.
+            batch.resize(_size);
+            for (Entry& e : batch) {
+                Entry& queued = _ring[_head];
+                e.stamp.swap(queued.stamp);
+                e.msg.swap(queued.msg);
+                _head = (_head + 1) % capacity;
+            }
+            _size = 0;
+            _writing = true;
+            _space.notify_all();
+            lock.unlock();
+
+            // The gui may be using std::cout at the same time, which
+            // is not synchronized with stdio, so use stdout.
+            _console.clear();
+            {
+                std::lock_guard<std::mutex> io(_log._ioMutex);
+                for (const Entry& e : batch) {
+                    _log.write(e.stamp, e.msg, _console);
+                }
+            }
+            if (!_console.empty()) {
+                std::fwrite(_console.data(), 1, _console.size(), stdout);
+                std::fflush(stdout);
+            }
+
+            lock.lock();
+            _writing = false;
+            _space.notify_all();
+        }
+    }
+
+    static const size_t capacity = 1024;
+
+    static constexpr std::chrono::milliseconds batchDelay{10};
+
+    LogFile& _log;
+
+    std::mutex _mutex;
+
+    /// Signalled when messages are queued or the writer should stop.
+    std::condition_variable _ready;
+
+    /// Signalled when the writer has taken or written messages.
+    std::condition_variable _space;
+
+    std::vector<Entry> _ring;
+
+    /// The stdout output of the batch being written.
+    std::string _console;
+
+    /// The index of the oldest queued message.
+    size_t _head;
+
+    /// The number of queued messages.
+    size_t _size;
+
+    /// Whether a batch taken from the ring is being written.
+    bool _writing;
+
+    /// The number of threads waiting in flush().
+    int _flushing;
+
+    bool _done;
+
+    /// Started last, once everything it uses is initialized.
+    std::thread _thread;
+};
+
+constexpr std::chrono::milliseconds LogFile::Writer::batchDelay;
+
 // boost format functions to process the objects
 // created by our hundreds of templates 
 
@@ -129,203 +290,256 @@ processLog_trace(const boost::format& fmt)
 void
 processLog_debug(const boost::format& fmt)
 {
- /*   if (dbglogfile.getVerbosity() < LogFile::LOG_DEBUG) return;
+    if (dbglogfile.getVerbosity() < LogFile::LOG_DEBUG) return;
     dbglogfile.log(N_("DEBUG"), fmt.str());
     // Print messages to the Android log, where they can be retrieved with
     // logcat.    
 #ifdef __ANDROID__
     __android_log_print(ANDROID_LOG_DEBUG, "Gnash", fmt.str().c_str());
-#endif   */ 
+#endif    
 }
 
 void
 processLog_abc(const boost::format& fmt)
 {
- /*   if (dbglogfile.getVerbosity() < LogFile::LOG_EXTRA) return;
+    if (dbglogfile.getVerbosity() < LogFile::LOG_EXTRA) return;
     dbglogfile.log(N_("ABC"), fmt.str());
     // Print messages to the Android log, where they can be retrieved with
     // logcat.    
 #ifdef __ANDROID__
     __android_log_print(ANDROID_LOG_VERBOSE, "Gnash", fmt.str().c_str());
-#endif    */
+#endif    
 }
 
 void
 processLog_parse(const boost::format& fmt)
 {
-  /*  dbglogfile.log(fmt.str());
+    dbglogfile.log(fmt.str());
     // Print messages to the Android log, where they can be retrieved with
     // logcat.    
 #ifdef __ANDROID__
     __android_log_print(ANDROID_LOG_VERBOSE, "Gnash", fmt.str().c_str());
-#endif  */  
+#endif    
 }
 
 void
 processLog_network(const boost::format& fmt)
 {
-   /* dbglogfile.log(N_("NETWORK"), fmt.str());
+    dbglogfile.log(N_("NETWORK"), fmt.str());
     // Print messages to the Android log, where they can be retrieved with
     // logcat.    
 #ifdef __ANDROID__
     __android_log_print(ANDROID_LOG_DEBUG, "Gnash", fmt.str().c_str());
-#endif */   
+#endif    
 }
 
 void
 processLog_error(const boost::format& fmt)
 {
-   /* dbglogfile.log(N_("ERROR"), fmt.str());
+    dbglogfile.log(N_("ERROR"), fmt.str());
     // Print messages to the Android log, where they can be retrieved with
     // logcat.    
 #ifdef __ANDROID__
     __android_log_print(ANDROID_LOG_ERROR, "Gnash", fmt.str().c_str());
-#endif  */ 
+#endif    
 }
 
 void
 processLog_unimpl(const boost::format& fmt)
 {
-    /*dbglogfile.log(N_("UNIMPLEMENTED"), fmt.str());
+    dbglogfile.log(N_("UNIMPLEMENTED"), fmt.str());
     // Print messages to the Android log, where they can be retrieved with
     // logcat.    
 #ifdef __ANDROID__
     __android_log_print(ANDROID_LOG_WARN, "Gnash", fmt.str().c_str());
-#endif  */  
+#endif    
 }
 
 void
 processLog_security(const boost::format& fmt)
 {
-   /* dbglogfile.log(N_("SECURITY"), fmt.str());
+    dbglogfile.log(N_("SECURITY"), fmt.str());
     // Print messages to the Android log, where they can be retrieved with
     // logcat.    
 #ifdef __ANDROID__
     __android_log_print(ANDROID_LOG_WARN, "Gnash", fmt.str().c_str());
-#endif*/    
+#endif    
 }
 
 void
 processLog_swferror(const boost::format& fmt)
 {
-    /*dbglogfile.log(N_("MALFORMED SWF"), fmt.str());
+    dbglogfile.log(N_("MALFORMED SWF"), fmt.str());
     // Print messages to the Android log, where they can be retrieved with
     // logcat.    
 #ifdef __ANDROID__
     __android_log_print(ANDROID_LOG_WARN, "Gnash", fmt.str().c_str());
-#endif */   
+#endif    
 }
 
 void
 processLog_aserror(const boost::format& fmt)
 {
-   /* dbglogfile.log(N_("ACTIONSCRIPT ERROR"), fmt.str());
+    dbglogfile.log(N_("ACTIONSCRIPT ERROR"), fmt.str());
     // Print messages to the Android log, where they can be retrieved with
     // logcat.    
 #ifdef __ANDROID__
     __android_log_print(ANDROID_LOG_WARN, "Gnash", fmt.str().c_str());
-#endif */   
+#endif    
 }
 
 void
 processLog_action(const boost::format& fmt)
 {
-   /* bool stamp = dbglogfile.getStamp();
+    bool stamp = dbglogfile.getStamp();
     dbglogfile.setStamp(false);
     dbglogfile.log(fmt.str());
-    dbglogfile.setStamp(stamp);*/
+    dbglogfile.setStamp(stamp);
 }
 
 void
 LogFile::log(const std::string& msg)
 {
-   /* std::lock_guard<std::mutex> lock(_ioMutex);
+    if ( !logVerbosity ) return; // nothing to do if not verbose
+
+    std::string stamp;
+    if (_stamp) {
+        std::ostringstream ss;
+        ss << timestamp;
+        stamp = ss.str();
+    }
+
+    if (_async) {
+        std::string queued(msg);
+        writer().push(stamp, queued);
+        return;
+    }
 
-    if ( !_verbose ) return; // nothing to do if not verbose
+    std::string console;
+    std::lock_guard<std::mutex> lock(_ioMutex);
+    write(stamp, msg, console);
+    if (!console.empty()) cout << console << std::flush;
+}
 
+void
+LogFile::log(const std::string& label, const std::string& msg)
+{
+    log(label + ": " + msg);
+}
+
+void
+LogFile::write(const std::string& stamp, const std::string& msg,
+        std::string& console)
+{
     if (openLogIfNeeded()) {
-        if (_stamp) {
-            _outstream << timestamp << ": " << msg << "\n";
+        if (!stamp.empty()) {
+            _outstream << stamp << ": " << msg << "\n";
         } else {
             _outstream << msg << "\n";
         }
     }
     else {
         // log to stdout
-        if (_stamp) {
-            cout << timestamp << " " << msg << endl;
-        } else {
-            cout << msg << endl;
+        if (!stamp.empty()) {
+            console.append(stamp).append(" ");
         }
+        console.append(msg).append("\n");
     }
     
     if (_listener) {
         (*_listener)(msg);
-    }*/
+    }
 }
 
-inline void
-LogFile::log(const std::string& label, const std::string& msg)
+void
+LogFile::setLogFilename(const std::string& fname)
 {
-    //log(label + ": " + msg);
+    closeLog();
+    std::lock_guard<std::mutex> lock(_ioMutex);
+    _logFilename = fname;
 }
 
 void
-LogFile::setLogFilename(const std::string& fname)
+LogFile::setWriteDisk(bool use)
 {
-   /* closeLog();
-    _logFilename = fname;*/
+    if (!use) closeLog();
+    std::lock_guard<std::mutex> lock(_ioMutex);
+    _write = use;
 }
 
 void
-LogFile::setWriteDisk(bool use)
+LogFile::setAsync(bool b)
+{
+    _async = b;
+
+    // Resetting the writer writes out what it still has queued. It is
+    // only started by the first message logged.
+    if (!b) {
+        std::lock_guard<std::mutex> lock(_writerMutex);
+        _writer.reset();
+    }
+}
+
+LogFile::Writer&
+LogFile::writer()
 {
-  /*  if (!use) closeLog();
-    _write = use;*/
+    std::lock_guard<std::mutex> lock(_writerMutex);
+    if (!_writer) _writer.reset(new Writer(*this));
+    return *_writer;
+}
+
+void
+LogFile::flush()
+{
+    Writer* w;
+    {
+        std::lock_guard<std::mutex> lock(_writerMutex);
+        w = _writer.get();
+    }
+    if (w) w->flush();
 }
 
 // Default constructor
 LogFile::LogFile()
     :
-    _verbose(0),
     _actiondump(false),
     _network(false),
     _parserdump(false),
     _state(CLOSED),
     _stamp(true),
     _write(false),
-    _listener(nullptr)
+    _listener(nullptr),
+    _async(false)
 {
 }
 
 LogFile::~LogFile()
 {
+    _writer.reset();
     if (_state == OPEN) closeLog();
 }
 
 bool
 LogFile::openLogIfNeeded()
 {
-   /* if (_state != CLOSED) return true;
+    if (_state != CLOSED) return true;
     if (!_write) return false;
 
     if (_logFilename.empty()) _logFilename = DEFAULT_LOGFILE;
 
     // TODO: expand ~ to getenv("HOME") !!
 
-    return openLog(_logFilename);*/
-    return false;
+    return openLog(_logFilename);
 }
 
 bool
 LogFile::openLog(const std::string& filespec)
 {
 
-   /* // NOTE:
+    // NOTE:
     // don't need to lock the mutex here, as this method
     // is intended to be called only by openLogIfNeeded,
-    // which in turn is called by operator<< which is called
-    // by the public log_xxx functions that log themselves
+    // which in turn is called by write() with the mutex held
 
     if (_state != CLOSED) {
     cout << "Closing previously opened stream" << endl;
@@ -343,7 +557,7 @@ LogFile::openLog(const std::string& filespec)
     }       
 
     _filespec = filespec;
-    _state = OPEN;*/
+    _state = OPEN;
 
     return true;
 }
@@ -351,13 +565,16 @@ LogFile::openLog(const std::string& filespec)
 bool
 LogFile::closeLog()
 {
-   /* std::lock_guard<std::mutex> lock(_ioMutex);
+    // Queued messages go to the file being closed.
+    flush();
+
+    std::lock_guard<std::mutex> lock(_ioMutex);
 
     if (_state == OPEN) {
         _outstream.flush();
         _outstream.close();
     }
-    _state = CLOSED;*/
+    _state = CLOSED;
 
     return true;
 }
@@ -365,13 +582,13 @@ LogFile::closeLog()
 bool
 LogFile::removeLog()
 {
-    /*if (_state == OPEN) {
+    if (_state == OPEN) {
         _outstream.close();
     }
 
     // Ignore the error, we don't care
     unlink(_filespec.c_str());
-    _filespec.clear();*/
+    _filespec.clear();
 
     return true;
 }
@@ -382,4 +599,3 @@ LogFile::removeLog()
 // mode: C++
 // indent-tabs-mode: nil
 // End:
-
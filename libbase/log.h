@@ -27,6 +27,7 @@
 #include "dsodefs.h" // for DSOEXPORT
 
 #include <fstream>
+#include <memory>
 #include <mutex>
 #include <boost/format.hpp>
 
@@ -59,6 +60,12 @@
 
 namespace gnash {
 
+/// The verbosity of the default LogFile.
+//
+/// LogFile stores its level here so that logEnabled() can check it
+/// inline, without fetching the singleton first.
+DSOEXPORT extern int logVerbosity;
+
 // This is a basic file logging class
 class DSOEXPORT LogFile
 {
@@ -121,15 +128,15 @@ public:
 
     // accessors for the verbose level
     void setVerbosity() {
-        ++_verbose;
+        ++logVerbosity;
     }
 
     void setVerbosity(int x) {
-        _verbose = x;
+        logVerbosity = x;
     }
 
     int getVerbosity() const {
-        return _verbose;
+        return logVerbosity;
     }
     
     void setActionDump(int x) {
@@ -171,11 +178,46 @@ public:
         return _write;
     }
     
+    /// Set whether messages are written by a background thread
+    //
+    /// When enabled, log() only queues the (timestamped) message and
+    /// returns; a writer thread does the file or stdout output and calls
+    /// the listener. The queue is bounded, so a thread logging faster
+    /// than the writer can write waits for room. The thread is started
+    /// by the first message actually logged, so a silent player never
+    /// runs it.
+    ///
+    /// Not thread-safe: call it during initialization, before other
+    /// threads log. Disabling writes out the queued messages first.
+    void setAsync(bool b);
+
+    bool getAsync() const {
+        return _async;
+    }
+
+    /// Wait until all queued messages have been written.
+    //
+    /// Does nothing when the log is synchronous.
+    void flush();
+
     typedef void (*logListener)(const std::string& s);
     
     void registerLogCallback(logListener l) { _listener = l; }
 
 private:
+
+    class Writer;
+
+    /// Write a message to the log file and notify the listener
+    //
+    /// The caller must hold _ioMutex.
+    ///
+    /// @param stamp    The timestamp of the message, empty if none.
+    /// @param msg      The message.
+    /// @param console  The line is appended to this instead if there is
+    ///                 no log file; the caller prints it to stdout.
+    void write(const std::string& stamp, const std::string& msg,
+            std::string& console);
     
     /// Open the specified file to write logs on disk
     //
@@ -206,9 +248,6 @@ private:
     /// Stream to write to stdout.
     std::ofstream _outstream;
 
-    /// How much output is required: 2 or more gives debug output.
-    int _verbose;
-
     /// Whether to dump all SWF actions
     bool _actiondump;
 
@@ -232,6 +271,18 @@ private:
     
     logListener _listener;
 
+    /// Return the background writer, starting it if needed.
+    Writer& writer();
+
+    /// Whether messages are written by a background thread.
+    bool _async;
+
+    /// Protects _writer while it is started.
+    std::mutex _writerMutex;
+
+    /// The background writer, once an asynchronous log has been used.
+    std::unique_ptr<Writer> _writer;
+
 };
 
 DSOEXPORT void processLog_network(const boost::format& fmt);
@@ -246,6 +297,16 @@ DSOEXPORT void processLog_swferror(const boost::format& fmt);
 DSOEXPORT void processLog_aserror(const boost::format& fmt);
 DSOEXPORT void processLog_abc(const boost::format& fmt);
 
+/// Whether messages of the given level are logged at all.
+//
+/// The log_* functions check this before formatting anything, so a
+/// disabled message costs a single comparison.
+inline bool
+logEnabled(LogFile::LogLevel level)
+{
+    return logVerbosity >= level;
+}
+
 template <typename FuncType>
 inline void
 log_impl(boost::format& fmt, FuncType func)
@@ -255,7 +316,8 @@ log_impl(boost::format& fmt, FuncType func)
 
 template<typename FuncType, typename Arg, typename... Args>
 inline void
-log_impl(boost::format& fmt, FuncType processFunc, Arg arg, Args... args)
+log_impl(boost::format& fmt, FuncType processFunc, const Arg& arg,
+        const Args&... args)
 {
     fmt % arg;
     log_impl(fmt, processFunc, args...);
@@ -263,7 +325,7 @@ log_impl(boost::format& fmt, FuncType processFunc, Arg arg, Args... args)
 
 template<typename StringType, typename FuncType, typename... Args>
 inline void
-log_impl(StringType msg, FuncType func, Args... args)
+log_impl(StringType msg, FuncType func, const Args&... args)
 {
     boost::format fmt(msg);
     using namespace boost::io;
@@ -274,68 +336,79 @@ log_impl(StringType msg, FuncType func, Args... args)
 }
 
 template<typename StringType, typename... Args>
-inline void log_network(StringType msg, Args... args)
+inline void log_network(StringType msg, const Args&... args)
 {
+    if (!logEnabled(LogFile::LOG_NORMAL)) return;
     log_impl(msg, processLog_network, args...);
 }
 
 template<typename StringType, typename... Args>
-inline void log_error(StringType msg, Args... args)
+inline void log_error(StringType msg, const Args&... args)
 {
+    if (!logEnabled(LogFile::LOG_NORMAL)) return;
     log_impl(msg, processLog_error, args...);
 }
 
 template<typename StringType, typename... Args>
-inline void log_unimpl(StringType msg, Args... args)
+inline void log_unimpl(StringType msg, const Args&... args)
 {
+    if (!logEnabled(LogFile::LOG_NORMAL)) return;
     log_impl(msg, processLog_unimpl, args...);
 }
 
 template<typename StringType, typename... Args>
-inline void log_trace(StringType msg, Args... args)
+inline void log_trace(StringType msg, const Args&... args)
 {
+    if (!logEnabled(LogFile::LOG_NORMAL)) return;
     log_impl(msg, processLog_trace, args...);
 }
 
 template<typename StringType, typename... Args>
-inline void log_debug(StringType msg, Args... args)
+inline void log_debug(StringType msg, const Args&... args)
 {
+    if (!logEnabled(LogFile::LOG_DEBUG)) return;
     log_impl(msg, processLog_debug, args...);
 }
 
 template<typename StringType, typename... Args>
-inline void log_action(StringType msg, Args... args)
+inline void log_action(StringType msg, const Args&... args)
 {
+    if (!logEnabled(LogFile::LOG_NORMAL)) return;
     log_impl(msg, processLog_action, args...);
 }
 
 template<typename StringType, typename... Args>
-inline void log_parse(StringType msg, Args... args)
+inline void log_parse(StringType msg, const Args&... args)
 {
+    if (!logEnabled(LogFile::LOG_NORMAL)) return;
     log_impl(msg, processLog_parse, args...);
 }
 
 template<typename StringType, typename... Args>
-inline void log_security(StringType msg, Args... args)
+inline void log_security(StringType msg, const Args&... args)
 {
+    if (!logEnabled(LogFile::LOG_NORMAL)) return;
     log_impl(msg, processLog_security, args...);
 }
 
 template<typename StringType, typename... Args>
-inline void log_swferror(StringType msg, Args... args)
+inline void log_swferror(StringType msg, const Args&... args)
 {
+    if (!logEnabled(LogFile::LOG_NORMAL)) return;
     log_impl(msg, processLog_swferror, args...);
 }
 
 template<typename StringType, typename... Args>
-inline void log_aserror(StringType msg, Args... args)
+inline void log_aserror(StringType msg, const Args&... args)
 {
+    if (!logEnabled(LogFile::LOG_NORMAL)) return;
     log_impl(msg, processLog_aserror, args...);
 }
 
 template<typename StringType, typename... Args>
-inline void log_abc(StringType msg, Args... args)
+inline void log_abc(StringType msg, const Args&... args)
 {
+    if (!logEnabled(LogFile::LOG_EXTRA)) return;
     log_impl(msg, processLog_abc, args...);
 }
 
@@ -393,15 +466,13 @@ DSOEXPORT std::string hexify(const unsigned char *bytes, size_t length,
 #endif
 
 #if VERBOSE_ASCODING_ERRORS
-// TODO: check if it's worth to check verbosity level too...
-#define IF_VERBOSE_ASCODING_ERRORS(x) { if ( gnash::RcInitFile::getDefaultInstance().showASCodingErrors() ) { x; } }
+#define IF_VERBOSE_ASCODING_ERRORS(x) { if ( gnash::logEnabled(gnash::LogFile::LOG_NORMAL) && gnash::RcInitFile::getDefaultInstance().showASCodingErrors() ) { x; } }
 #else
 #define IF_VERBOSE_ASCODING_ERRORS(x)
 #endif
 
 #if VERBOSE_MALFORMED_SWF
-// TODO: check if it's worth to check verbosity level too... 
-#define IF_VERBOSE_MALFORMED_SWF(x) { if ( gnash::RcInitFile::getDefaultInstance().showMalformedSWFErrors() ) { x; } }
+#define IF_VERBOSE_MALFORMED_SWF(x) { if ( gnash::logEnabled(gnash::LogFile::LOG_NORMAL) && gnash::RcInitFile::getDefaultInstance().showMalformedSWFErrors() ) { x; } }
 #else
 #define IF_VERBOSE_MALFORMED_SWF(x)
 #endif
@@ -70,7 +70,10 @@ RcInitFile::getDefaultInstance()
 RcInitFile::RcInitFile()
         :
     _delay(0),
+    _maxFrameSkip(3),
     _movieLibraryLimit(8),
+    _movieLibraryBudget(8192),
+    _prefetchBudget(0),
     _debug(false),
     _debugger(false),
     _verbosity(-1),
@@ -94,6 +97,7 @@ RcInitFile::RcInitFile()
     _localhostOnly(false),
     _log("gnash-dbg.log"),
     _writeLog(false),
+    _asyncLog(true),
     _sound(true),
     _pluginSound(true),
     _extensionsEnabled(false),
@@ -103,6 +107,7 @@ RcInitFile::RcInitFile()
     _solsandbox(DEFAULT_SOL_SAFEDIR),
     _solreadonly(false),
     _sollocaldomain(false),
+    _sollazydecode(true),
     _lcdisabled(false),
     _lctrace(true),
     // TODO: give a  default value, and let 0 mean "disabled" -- 0
@@ -548,6 +553,8 @@ RcInitFile::parseFile(const std::string& filespec)
                  extractSetting(_parserDump, "parserDump", variable, value)
             ||
                  extractSetting(_writeLog, "writelog", variable, value)
+            ||
+                 extractSetting(_asyncLog, "asyncLog", variable, value)
             ||
                  extractSetting(_popups, "popupMessages", variable, value)
             ||
@@ -574,6 +581,9 @@ RcInitFile::parseFile(const std::string& filespec)
             ||
                  extractSetting(_sollocaldomain, "solLocalDomain", variable,
                            value)
+            ||
+                 extractSetting(_sollazydecode, "SOLLazyDecode", variable,
+                           value)
             ||
 		 extractSetting(_lcdisabled, "LocalConnection", variable,
                            value)
@@ -583,8 +593,16 @@ RcInitFile::parseFile(const std::string& filespec)
             ||
                  extractNumber(_movieLibraryLimit, "movieLibraryLimit",
                          variable, value)
+            ||
+                 extractNumber(_movieLibraryBudget, "movieLibraryBudget",
+                         variable, value)
+            ||
+                 extractNumber(_prefetchBudget, "prefetchBudget",
+                         variable, value)
             ||
                  extractNumber(_delay, "delay", variable, value)
+            ||
+                 extractNumber(_maxFrameSkip, "maxFrameSkip", variable, value)
             ||
                  extractNumber(_verbosity, "verbosity", variable, value)
             ||
@@ -759,6 +777,7 @@ RcInitFile::updateFile(const std::string& filespec)
     cmd << "actionDump " << _actionDump << endl <<
     cmd << "parserDump " << _parserDump << endl <<
     cmd << "writeLog " << _writeLog << endl <<
+    cmd << "asyncLog " << _asyncLog << endl <<
     cmd << "sound " << _sound << endl <<
     cmd << "popupMessages " << _popups << endl <<
     cmd << "pluginSound " << _pluginSound << endl <<
@@ -769,11 +788,15 @@ RcInitFile::updateFile(const std::string& filespec)
     cmd << "startStopped " << _startStopped << endl <<
     cmd << "streamsTimeout " << _streamsTimeout << endl <<
     cmd << "movieLibraryLimit " << _movieLibraryLimit << endl <<
+    cmd << "movieLibraryBudget " << _movieLibraryBudget << endl <<
+    cmd << "prefetchBudget " << _prefetchBudget << endl <<
     cmd << "quality " << _quality << endl <<    
     cmd << "delay " << _delay << endl <<
+    cmd << "maxFrameSkip " << _maxFrameSkip << endl <<
     cmd << "verbosity " << _verbosity << endl <<
     cmd << "solReadOnly " << _solreadonly << endl <<
     cmd << "solLocalDomain " << _sollocaldomain << endl <<
+    cmd << "SOLLazyDecode " << _sollazydecode << endl <<
     cmd << "SOLSafeDir " << _solsandbox << endl <<
     cmd << "localConnection " << _lcdisabled << endl <<
     cmd << "LCTrace " << _lctrace << endl <<
@@ -892,6 +915,7 @@ RcInitFile::dump()
     
     cerr << endl << "Dump RcInitFile:" << endl;
     cerr << "\tTimer interupt delay value: " << _delay << endl;
+    cerr << "\tMax frames skipped when late: " << _maxFrameSkip << endl;
     cerr << "\tFlash debugger: "
          << ((_debugger)?"enabled":"disabled") << endl;
     cerr << "\tVerbosity Level: " << _verbosity << endl;
@@ -911,6 +935,8 @@ RcInitFile::dump()
          << ((_localhostOnly)?"enabled":"disabled") << endl;
     cerr << "\tWrite Debug Log To Disk: "
          << ((_writeLog)?"enabled":"disabled") << endl;
+    cerr << "\tWrite Debug Log In Background: "
+         << ((_asyncLog)?"enabled":"disabled") << endl;
     cerr << "\tAllow insecure SSL connections: "
          << ((_insecureSSL)?"yes":"no") << endl;
     cerr << "\tEnable sound: "
@@ -80,9 +80,15 @@ public:
     bool useWriteLog() const { return _writeLog; }
     void useWriteLog(bool value);
 
+    bool useAsyncLog() const { return _asyncLog; }
+    void useAsyncLog(bool value) { _asyncLog = value; }
+
     int getTimerDelay() const { return _delay; }
     void setTimerDelay(int x) { _delay = x; }
 
+    int getMaxFrameSkip() const { return _maxFrameSkip; }
+    void setMaxFrameSkip(int x) { _maxFrameSkip = x; }
+
     bool showASCodingErrors() const { return _verboseASCodingErrors; }
     void showASCodingErrors(bool value);
 
@@ -95,6 +101,15 @@ public:
     int getMovieLibraryLimit() const { return _movieLibraryLimit; }
     void setMovieLibraryLimit(int value) { _movieLibraryLimit = value; }
 
+    /// Approximate size in kilobytes of the movies the library may hold
+    int getMovieLibraryBudget() const { return _movieLibraryBudget; }
+    void setMovieLibraryBudget(int value) { _movieLibraryBudget = value; }
+
+    /// Kilobytes of movies and media files to load before they are
+    /// requested, 0 to never prefetch
+    int getPrefetchBudget() const { return _prefetchBudget; }
+    void setPrefetchBudget(int value) { _prefetchBudget = value; }
+
     bool enableExtensions() const { return _extensionsEnabled; }
 
     /// Return true if user is willing to start the gui in "stop" mode
@@ -277,6 +292,10 @@ public:
     bool getSOLReadOnly() const { return _solreadonly; }
     
     void setSOLReadOnly(bool x) { _solreadonly = x; }
+
+    bool getSOLLazyDecode() const { return _sollazydecode; }
+
+    void setSOLLazyDecode(bool x) { _sollazydecode = x; }
     
     bool getLocalConnection() const { return _lcdisabled; }
     
@@ -444,9 +463,18 @@ protected:
     /// The timer delay
     std::uint32_t  _delay;
 
+    /// Max number of consecutive frames not rendered when running late
+    std::uint32_t  _maxFrameSkip;
+
     /// Max number of movie clips to store in the library      
     std::uint32_t  _movieLibraryLimit;
 
+    /// Approximate size in kilobytes of the movie clips in the library
+    std::uint32_t  _movieLibraryBudget;
+
+    /// Kilobytes of files to prefetch, 0 to disable prefetching
+    std::uint32_t  _prefetchBudget;
+
     /// Enable debugging of this class
     bool _debug;
 
@@ -517,6 +545,9 @@ protected:
     
     /// Enable writing the debug log to disk
     bool _writeLog;
+
+    /// Write the debug log from a background thread
+    bool _asyncLog;
     
     /// The root path for the streaming server        
     std::string _wwwroot;
@@ -553,6 +584,9 @@ protected:
     /// Whether SOL files can be written
     bool _solreadonly;
     bool _sollocaldomain;
+
+    /// Whether objects in SOL files are only decoded when first read
+    bool _sollazydecode;
     
     // Disable local connection
     bool _lcdisabled;
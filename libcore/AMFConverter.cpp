@@ -19,6 +19,8 @@
 #include "AMFConverter.h"
 
 #include <map>
+#include <memory>
+#include <cassert>
 
 #include "SimpleBuffer.h"
 #include "AMF.h"
@@ -295,6 +297,339 @@ Writer::writeData(const std::uint8_t* data, size_t length)
     _buf.append(data, length);
 }
 
+/// The state shared by a lazy Reader and the members it has not decoded.
+//
+/// Objects are numbered for references in the order in which they appear
+/// in the buffer, whether they have been decoded or only skipped.
+class Reader::Lazy : public std::enable_shared_from_this<Reader::Lazy>
+{
+public:
+
+    explicit Lazy(std::shared_ptr<const SimpleBuffer> data)
+        :
+        _data(std::move(data))
+    {}
+
+    const std::uint8_t* begin() const { return _data->data(); }
+
+    const std::uint8_t* end() const { return begin() + _data->size(); }
+
+    /// The number of objects found so far.
+    size_t size() const { return _offsets.size(); }
+
+    /// Record the position of an object when it is first found.
+    void found(size_t index, const std::uint8_t* pos) {
+        if (index < _offsets.size()) return;
+        assert(index == _offsets.size());
+        _offsets.push_back(pos - begin());
+        _objects.push_back(nullptr);
+    }
+
+    /// Return a decoded object, or 0 if it has not been decoded.
+    as_object* object(size_t index) const {
+        return index < _objects.size() ? _objects[index] : nullptr;
+    }
+
+    void setObject(size_t index, as_object* obj) {
+        assert(index < _objects.size());
+        _objects[index] = obj;
+    }
+
+    /// Return an object, decoding it first if necessary.
+    as_value read(size_t index, Global_as& gl) {
+        assert(index < _offsets.size());
+        as_object* obj = _objects[index];
+        if (obj) return as_value(obj);
+
+        const std::uint8_t* pos = begin() + _offsets[index];
+        Reader rd(pos, shared_from_this(), index, gl);
+        as_value val;
+        if (!rd(val)) {
+            log_error(_("AMF: could not decode object %d"), index + 1);
+        }
+        return val;
+    }
+
+    /// Decoded objects can still be referenced by members decoded later.
+    void markReachableResources() const {
+        for (as_object* obj : _objects) {
+            if (obj) obj->setReachable();
+        }
+    }
+
+private:
+
+    const std::shared_ptr<const SimpleBuffer> _data;
+
+    /// The offset of each object found in the buffer.
+    std::vector<size_t> _offsets;
+
+    /// The decoded objects.
+    std::vector<as_object*> _objects;
+};
+
+/// A destructive getter that decodes the value of an object member.
+class Reader::LazyMember : public as_function
+{
+public:
+
+    LazyMember(Global_as& gl, std::shared_ptr<Lazy> lazy, size_t index)
+        :
+        as_function(gl),
+        _lazy(std::move(lazy)),
+        _index(index)
+    {}
+
+    bool isBuiltin() { return true; }
+
+    virtual as_value call(const fn_call& fn) {
+        return _lazy->read(_index, getGlobal(fn));
+    }
+
+protected:
+
+    virtual void markReachableResources() const {
+        _lazy->markReachableResources();
+        as_function::markReachableResources();
+    }
+
+private:
+
+    const std::shared_ptr<Lazy> _lazy;
+
+    const size_t _index;
+};
+
+namespace {
+
+/// Objects encoded in fewer bytes are not decoded lazily.
+const size_t minLazySize = 256;
+
+/// Skip a string with a length field of the given number of bytes.
+void
+skipString(const std::uint8_t*& pos, const std::uint8_t* end,
+        size_t lengthBytes)
+{
+    if (static_cast<size_t>(end - pos) < lengthBytes) {
+        throw AMFException(_("Read past _end of buffer for string length"));
+    }
+    const std::uint32_t len = lengthBytes == 2 ?
+        readNetworkShort(pos) : readNetworkLong(pos);
+    pos += lengthBytes;
+
+    if (static_cast<size_t>(end - pos) < len) {
+        throw AMFException(_("Read past _end of buffer for string type"));
+    }
+    pos += len;
+}
+
+}
+
+Reader::Reader(const std::uint8_t*& pos,
+        std::shared_ptr<const SimpleBuffer> data, Global_as& gl)
+    :
+    _pos(pos),
+    _end(data->data() + data->size()),
+    _global(gl),
+    _lazy(std::make_shared<Lazy>(data)),
+    _nextIndex(0)
+{
+}
+
+Reader::Reader(const std::uint8_t*& pos, std::shared_ptr<Lazy> lazy,
+        size_t index, Global_as& gl)
+    :
+    _pos(pos),
+    _end(lazy->end()),
+    _global(gl),
+    _lazy(std::move(lazy)),
+    _nextIndex(index)
+{
+}
+
+bool
+Reader::readMember(as_object& obj, const ObjectURI& uri)
+{
+    // Objects are skipped and only decoded when the member is read.
+    if (_lazy && _pos != _end && (*_pos == OBJECT_AMF0 ||
+                *_pos == ECMA_ARRAY_AMF0 || *_pos == STRICT_ARRAY_AMF0)) {
+
+        const std::uint8_t* start = _pos;
+        const size_t index = _nextIndex;
+        try {
+            skip();
+        }
+        catch (const AMFException& e) {
+            log_error(_("AMF parsing error: %s"), e.what());
+            return false;
+        }
+
+        // It may already have been decoded for a reference. A repeated
+        // member replaces the earlier one.
+        as_object* decoded = _lazy->object(index);
+        if (decoded || obj.getOwnProperty(uri)) {
+            obj.set_member(uri, decoded ? as_value(decoded) :
+                    _lazy->read(index, _global));
+            return true;
+        }
+
+        // A placeholder costs about as much as decoding a small object.
+        if (static_cast<size_t>(_pos - start) >= minLazySize) {
+            obj.init_destructive_property(uri,
+                    *new LazyMember(_global, _lazy, index), 0);
+            return true;
+        }
+        _pos = start;
+        _nextIndex = index;
+    }
+
+    as_value val;
+    if (!operator()(val)) return false;
+    obj.set_member(uri, val);
+    return true;
+}
+
+void
+Reader::addReference(as_object* obj)
+{
+    if (!_lazy) {
+        _objectRefs.push_back(obj);
+        return;
+    }
+    _lazy->setObject(_nextIndex++, obj);
+}
+
+bool
+Reader::alreadyDecoded(as_value& val)
+{
+    if (!_lazy) return false;
+
+    // The type has been read.
+    const std::uint8_t* start = _pos - 1;
+    _lazy->found(_nextIndex, start);
+
+    as_object* obj = _lazy->object(_nextIndex);
+    if (!obj) return false;
+
+    _pos = start;
+    skip();
+    val = obj;
+    return true;
+}
+
+void
+Reader::skip()
+{
+    if (_pos == _end) {
+        throw AMFException(_("Read past _end of buffer for type"));
+    }
+
+    const std::uint8_t* start = _pos;
+    const Type t = static_cast<Type>(*_pos);
+    ++_pos;
+
+    switch (t) {
+
+        default:
+            throw AMFException(_("Unknown AMF type"));
+
+        case NUMBER_AMF0:
+            readNumber(_pos, _end);
+            return;
+
+        case BOOLEAN_AMF0:
+            readBoolean(_pos, _end);
+            return;
+
+        case STRING_AMF0:
+            skipString(_pos, _end, 2);
+            return;
+
+        case LONG_STRING_AMF0:
+        case XML_OBJECT_AMF0:
+            skipString(_pos, _end, 4);
+            return;
+
+        case UNSUPPORTED_AMF0:
+        case UNDEFINED_AMF0:
+        case NULL_AMF0:
+            return;
+
+        case REFERENCE_AMF0:
+        {
+            if (_end - _pos < 2) {
+                throw AMFException("Read past _end of buffer for reference "
+                        "index");
+            }
+            const std::uint16_t si = readNetworkShort(_pos);
+            _pos += 2;
+            if (si < 1 || si > _lazy->size()) {
+                throw AMFException("Reference to invalid object reference");
+            }
+            return;
+        }
+
+        case DATE_AMF0:
+            readNumber(_pos, _end);
+            if (_end - _pos < 2) {
+                throw AMFException("premature _end of input reading "
+                            "timezone from Date type");
+            }
+            _pos += 2;
+            return;
+
+        case OBJECT_AMF0:
+            _lazy->found(_nextIndex++, start);
+            for (;;) {
+                const bool last = _end - _pos >= 2 && !readNetworkShort(_pos);
+                skipString(_pos, _end, 2);
+                if (last) {
+                    // AMF0 has a redundant "object _end" byte
+                    if (_pos < _end) ++_pos;
+                    return;
+                }
+                skip();
+            }
+
+        case ECMA_ARRAY_AMF0:
+        {
+            _lazy->found(_nextIndex++, start);
+            if (_end - _pos < 4) {
+                throw AMFException(_("Read past _end of buffer for array "
+                            "length"));
+            }
+            _pos += 4;
+
+            // The same malformed arrays as in readArray() are accepted.
+            while (_end - _pos >= 2) {
+                const std::uint16_t strlen = readNetworkShort(_pos);
+                _pos += 2;
+                if (!strlen) {
+                    if (_pos < _end) ++_pos;
+                    return;
+                }
+                if (_end - _pos < strlen) return;
+                _pos += strlen;
+                skip();
+            }
+            return;
+        }
+
+        case STRICT_ARRAY_AMF0:
+        {
+            _lazy->found(_nextIndex++, start);
+            if (_end - _pos < 4) {
+                throw AMFException(_("Read past _end of buffer for strict "
+                            "array length"));
+            }
+            const std::uint32_t li = readNetworkLong(_pos);
+            _pos += 4;
+            for (size_t i = 0; i < li; ++i) skip();
+            return;
+        }
+    }
+}
+
 bool
 Reader::operator()(as_value& val, Type t)
 {
@@ -352,15 +687,15 @@ Reader::operator()(as_value& val, Type t)
                 return true;
             
             case OBJECT_AMF0:
-                val = readObject();
+                if (!alreadyDecoded(val)) val = readObject();
                 return true;
             
             case ECMA_ARRAY_AMF0:
-                val = readArray();
+                if (!alreadyDecoded(val)) val = readArray();
                 return true;
             
             case STRICT_ARRAY_AMF0:
-                val = readStrictArray();
+                if (!alreadyDecoded(val)) val = readStrictArray();
                 return true;
             
             case DATE_AMF0:
@@ -415,7 +750,7 @@ Reader::readStrictArray()
 #endif
     
     as_object* array = _global.createArray();
-    _objectRefs.push_back(array);
+    addReference(array);
 
     as_value arrayElement;
     for (size_t i = 0; i < li; ++i) {
@@ -446,7 +781,7 @@ Reader::readArray()
     _pos += 4;
     
     as_object* array = _global.createArray();
-    _objectRefs.push_back(array);
+    addReference(array);
 
     // the count specifies array size, so to have that even if none
     // of the members are indexed
@@ -518,7 +853,7 @@ Reader::readObject()
     log_debug("amf0 starting read of OBJECT");
 #endif
 
-    _objectRefs.push_back(obj);
+    addReference(obj);
 
     as_value tmp;
     std::string keyString;
@@ -542,10 +877,9 @@ Reader::readObject()
             return as_value(obj);
         }
 
-        if (!operator()(tmp)) {
+        if (!readMember(*obj, getURI(vm, keyString))) {
             throw AMFException("Unable to read object member");
         }
-        obj->set_member(getURI(vm, keyString), tmp);
     }
 }
 
@@ -562,11 +896,13 @@ Reader::readReference()
 #ifdef GNASH_DEBUG_AMF_DESERIALIZE
     log_debug("readAMF0: reference #%d", si);
 #endif
-    if (si < 1 || si > _objectRefs.size()) {
+    const size_t known = _lazy ? _lazy->size() : _objectRefs.size();
+    if (si < 1 || si > known) {
         log_error(_("readAMF0: invalid reference to object %d (%d known "
-                  "objects)"), si, _objectRefs.size());
+                  "objects)"), si, known);
         throw AMFException("Reference to invalid object reference");
     }
+    if (_lazy) return _lazy->read(si - 1, _global);
     return as_value(_objectRefs[si - 1]);
 }
 
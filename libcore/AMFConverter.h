@@ -21,6 +21,7 @@
 #define GNASH_AMFCONVERTER_H
 
 #include <map>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -32,6 +33,7 @@ namespace gnash {
     class as_value;
     class SimpleBuffer;
     class Global_as;
+    struct ObjectURI;
 }
 
 namespace gnash {
@@ -136,9 +138,24 @@ public:
         :
         _pos(pos),
         _end(end),
-        _global(gl)
+        _global(gl),
+        _nextIndex(0)
     {}
 
+    /// Construct a Reader that decodes object members lazily.
+    //
+    /// Members of anonymous objects whose values are objects or arrays
+    /// are only decoded when they are first read, after which they are
+    /// normal properties. Enumerating the values of an object decodes all
+    /// of its members.
+    //
+    /// @param pos      The read position in data.
+    /// @param data     The complete AMF buffer. It is kept until no more
+    ///                 members can be decoded from it.
+    /// @param gl       A global reference for creating objects.
+    Reader(const std::uint8_t*& pos, std::shared_ptr<const SimpleBuffer> data,
+            Global_as& gl);
+
     /// Create a type from current position in the AMF buffer.
     //
     /// @param val      An as_value to be created from the AMF data.
@@ -148,8 +165,27 @@ public:
     ///                 the read succeeded and the as_value is valid.
     bool operator()(as_value& val, Type t = NOTYPE);
 
+    /// Read a value from the current position into a member of an object.
+    //
+    /// For a lazy Reader, an object value is only decoded once the member
+    /// is read.
+    //
+    /// @return         false if this read failed for any reason. The member
+    ///                 is then not set.
+    bool readMember(as_object& obj, const ObjectURI& uri);
+
 private:
 
+    /// The state shared by a lazy Reader and the members it has not decoded.
+    class Lazy;
+
+    /// A placeholder for a member that has not been decoded.
+    class LazyMember;
+
+    /// Construct a lazy Reader for an object found by another one.
+    Reader(const std::uint8_t*& pos, std::shared_ptr<Lazy> lazy,
+            size_t index, Global_as& gl);
+
     /// Read an XML type.
     as_value readXML();
 
@@ -168,6 +204,17 @@ private:
     /// Read a strict array object type.
     as_value readStrictArray();
 
+    /// Register a newly created object for references.
+    void addReference(as_object* obj);
+
+    /// Return an object that was decoded out of order, skipping it.
+    //
+    /// A lazy Reader decodes objects when a reference needs them.
+    bool alreadyDecoded(as_value& val);
+
+    /// Skip a value, only registering the objects it contains.
+    void skip();
+
     /// Object references.
     std::vector<as_object*> _objectRefs;
 
@@ -180,6 +227,12 @@ private:
     /// For creating objects if necessary.
     Global_as& _global;
 
+    /// Only set for a lazy Reader.
+    std::shared_ptr<Lazy> _lazy;
+
+    /// The reference index of the next object in a lazy Reader.
+    size_t _nextIndex;
+
 };
 
 } // namespace amf
@@ -120,17 +120,36 @@ Bitmap::display(Renderer& renderer, const Transform& base)
 
     _shape.display(renderer, xform);
     clear_invalidated();
+    _changedArea.setNull();
+}
+
+void
+Bitmap::omit_display()
+{
+    clear_invalidated();
+    _changedArea.setNull();
 }
 
 void
 Bitmap::add_invalidated_bounds(InvalidatedRanges& ranges, bool force)
 {
-    if (!force && !invalidated()) return;
+    if (!force && !invalidated() && _changedArea.isNull()) return;
 
     ranges.add(m_old_invalidated_ranges);
 
     SWFRect bounds;
-    bounds.expand_to_transformed_rect(getWorldMatrix(*this), getBounds()); 
+    if (force || invalidated()) {
+        bounds.expand_to_transformed_rect(getWorldMatrix(*this), getBounds()); 
+    }
+    else {
+        // Only some pixels changed. They are extended by one pixel, which
+        // smoothing may reach.
+        const SWFRect area(pixelsToTwips(_changedArea.getMinX() - 1),
+                pixelsToTwips(_changedArea.getMinY() - 1),
+                pixelsToTwips(_changedArea.getMaxX() + 2),
+                pixelsToTwips(_changedArea.getMaxY() + 2));
+        bounds.expand_to_transformed_rect(getWorldMatrix(*this), area);
+    }
     ranges.add(bounds.getRange());
 
 }
@@ -146,6 +165,18 @@ Bitmap::update()
 {
     /// Nothing to do for disposed bitmaps.
     if (!_bitmapData) return;
+
+    // If only some pixels changed, the Bitmap need not be invalidated
+    // as a whole.
+    DisplayObject* p = parent();
+    if (p && !_bitmapData->disposed()) {
+        const geometry::Range2d<int>& changed = _bitmapData->changedArea();
+        if (!changed.isNull()) {
+            _changedArea.expandTo(changed);
+            p->set_child_invalidated(this);
+            return;
+        }
+    }
     
     set_invalidated();
 
@@ -68,6 +68,8 @@ public:
     /// Display this Bitmap
 	virtual void display(Renderer& renderer, const Transform& xform);
 
+    virtual void omit_display();
+
     /// Get the bounds of the Bitmap
     virtual SWFRect getBounds() const;
 
@@ -113,6 +115,12 @@ private:
     /// This is cached to save querying the BitmapData often
     size_t _height;
 
+    /// Pixels of the BitmapData_as changed since the last display.
+    //
+    /// Unless the whole Bitmap is invalidated, only this area needs to be
+    /// redrawn.
+    geometry::Range2d<int> _changedArea;
+
 };
 
 }	// end namespace gnash
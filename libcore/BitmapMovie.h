@@ -64,10 +64,6 @@ public:
         return _def->get_height_pixels();
     }
 
-    virtual const std::string& url() const {
-        return _def->get_url();
-    }
-
     virtual int version() const {
         return _def->get_version();
     }
@@ -543,6 +543,7 @@ DisplayList::display(Renderer& renderer, const Transform& base)
     testInvariant();
 
     std::stack<int> clipDepthStack;
+    _hasMaskLayers = false;
     
     // We only display DisplayObjects which are out of the "removed" zone
     // (or should we check unloaded?)
@@ -587,6 +588,7 @@ DisplayList::display(Renderer& renderer, const Transform& base)
             const int clipDepth = ch->get_clip_depth();
             clipDepthStack.push(clipDepth);
             renderer.begin_submit_mask();
+            _hasMaskLayers = true;
         }
         
         if (ch->boundsInClippingArea(renderer)) {
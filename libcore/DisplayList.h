@@ -72,7 +72,7 @@ public:
 	typedef container_type::reverse_iterator reverse_iterator;
 	typedef container_type::const_reverse_iterator const_reverse_iterator;
 
-    DisplayList() {}
+    DisplayList() : _hasMaskLayers(true) {}
     ~DisplayList() {}
 
     /// Output operator
@@ -269,6 +269,14 @@ public:
     /// Like DisplayObject_instance::add_invalidated_bounds() this method calls the
     /// method with the same name of all childs.	
 	void add_invalidated_bounds(InvalidatedRanges& ranges, bool force);	
+
+    /// Whether the list had mask layers when last displayed
+    //
+    /// Invalidated bounds of masked DisplayObjects are clipped to their
+    /// masks only when walking the whole list, so the owner must
+    /// not limit itself to the changed children when this is true.
+    /// It is true until the list is first displayed.
+    bool hasMaskLayers() const { return _hasMaskLayers; }
 	
 	/// Return number of elements in the list
 	size_t size() const { 
@@ -346,6 +354,9 @@ private:
 	void reinsertRemovedCharacter(DisplayObject* ch);
 
 	container_type _charsByDepth;
+
+    /// See hasMaskLayers(), updated by display()
+    bool _hasMaskLayers;
 };
 
 template <class V>
@@ -109,7 +109,8 @@ DisplayObject::DisplayObject(movie_root& mr, as_object* object,
     _unloaded(false),
     _destroyed(false),
     _invalidated(true),
-    _child_invalidated(true)
+    _child_invalidated(true),
+    _inParentInvalidatedChildren(false)
 {
     //assert(m_old_invalidated_ranges.isNull());
 
@@ -191,7 +192,7 @@ DisplayObject::set_invalidated(const char* debug_file, int debug_line)
     // Set the invalidated-flag of the parent. Note this does not mean that
     // the parent must re-draw itself, it just means that one of it's childs
     // needs to be re-drawn.
-    if ( _parent ) _parent->set_child_invalidated(); 
+    if ( _parent ) _parent->set_child_invalidated(this); 
   
     // Ok, at this point the instance will change it's
     // visual aspect after the
@@ -235,11 +236,16 @@ DisplayObject::add_invalidated_bounds(InvalidatedRanges& ranges, bool force)
 }
 
 void
-DisplayObject::set_child_invalidated()
+DisplayObject::set_child_invalidated(DisplayObject* child)
 {
+    if (!child->_inParentInvalidatedChildren) {
+        child->_inParentInvalidatedChildren = true;
+        _invalidatedChildren.push_back(child);
+    }
+
     if (!_child_invalidated) {
         _child_invalidated=true;
-        if (_parent) _parent->set_child_invalidated();
+        if (_parent) _parent->set_child_invalidated(this);
     } 
 }
 
@@ -699,6 +705,7 @@ DisplayObject::markReachableResources() const
     if (_parent) _parent->setReachable();
     if (_mask) _mask->setReachable();
     if (_maskee) _maskee->setReachable();
+    for (DisplayObject* ch : _invalidatedChildren) ch->setReachable();
 }
 
 /// Whether to use a hand cursor when the mouse is over this DisplayObject
@@ -663,6 +663,17 @@ public:
         return _child_invalidated;
     }
 
+    /// Return the direct children that changed since the last call to
+    /// clear_invalidated().
+    //
+    /// These are the children which are invalidated or have an
+    /// invalidated child, so that containers only need to visit them
+    /// to collect the invalidated bounds. Unloaded children may be
+    /// in the list.
+    const std::vector<DisplayObject*>& invalidatedChildren() const {
+        return _invalidatedChildren;
+    }
+
     /// Notify a change in the DisplayObject's appearance.
     virtual void update() {
         set_invalidated();
@@ -703,7 +714,10 @@ public:
     /// difference to set_invalidated() is that *this* DisplayObject does
     /// not need to redraw itself completely. This function will 
     /// recursively inform all its parents of the change.
-    void set_child_invalidated();
+    //
+    /// @param child    The child that changed, added to
+    ///                 invalidatedChildren().
+    void set_child_invalidated(DisplayObject* child);
 
     /// Clear invalidated flag and reset m_old_invalidated_bounds to null.
     ///
@@ -721,6 +735,10 @@ public:
         _invalidated = false;
         _child_invalidated = false;        
         m_old_invalidated_ranges.setNull();
+        for (DisplayObject* ch : _invalidatedChildren) {
+            ch->_inParentInvalidatedChildren = false;
+        }
+        _invalidatedChildren.clear();
     }
     
     /// \brief
@@ -1111,6 +1129,15 @@ private:
     /// can be set at the same time. 
     bool _child_invalidated;
 
+    /// Children that changed since the last call to clear_invalidated()
+    //
+    /// Kept reachable until cleared, even if they are removed from
+    /// the stage meanwhile.
+    std::vector<DisplayObject*> _invalidatedChildren;
+
+    /// Whether this DisplayObject is in its parent's _invalidatedChildren
+    bool _inParentInvalidatedChildren;
+
 
 };
 
@@ -22,6 +22,8 @@
 #include "DisplayObject.h"
 
 #include <vector>
+#include <algorithm>
+#include <cassert>
 
 namespace gnash {
 
@@ -32,16 +34,25 @@ DynamicShape::DynamicShape()
 	_currline(0),
 	_x(0),
 	_y(0),
-	_changed(false)
+	_changed(false),
+	_openFill(false),
+	_openFillEdges(0)
 {}
 
 void
 DynamicShape::clear()
 {
+	// Keep the paths, with their edge storage, for the next drawing.
+	for (SWF::Subshape& subshape : _shape.subshapes()) {
+		recyclePaths(subshape.paths());
+	}
+	recyclePaths(_currsubshape.paths());
+
 	_shape.clear();
 	_currpath = nullptr;
 	_currfill = _currline = 0; 
 	_currsubshape.clear();
+	_openFill = false;
 	// TODO: worth setting _changed=true ? 
 }
 
@@ -54,14 +65,73 @@ DynamicShape::display(Renderer& renderer, const Transform& xform) const
 void
 DynamicShape::add_path(const Path& pth)
 {
+	resumeFill();
 	_currsubshape.addPath(pth);
 	_currpath = &_currsubshape.currentPath();
 	_changed = true;
 }
 
+void
+DynamicShape::addPooledPath()
+{
+	Path path;
+	if (!_pathPool.empty()) {
+		path = std::move(_pathPool.back());
+		_pathPool.pop_back();
+	}
+	path.reset(_x, _y, _currfill, 0, _currline);
+
+	_currsubshape.addPath(std::move(path));
+	_currpath = &_currsubshape.currentPath();
+	_changed = true;
+}
+
+void
+DynamicShape::pushSubshape() const
+{
+	SWF::Subshape subshape;
+	subshape.fillStyles() = _currsubshape.fillStyles();
+	subshape.lineStyles() = _currsubshape.lineStyles();
+	subshape.paths().swap(_currsubshape.paths());
+	_shape.addSubshape(std::move(subshape));
+}
+
+void
+DynamicShape::recyclePaths(SWF::Subshape::Paths& paths)
+{
+	for (Path& path : paths) {
+		if (_pathPool.size() >= maxPooledPaths) break;
+		// Drop the edges but keep their storage.
+		path.m_edges.clear();
+		_pathPool.push_back(std::move(path));
+	}
+	paths.clear();
+}
+
+void
+DynamicShape::resumeFill()
+{
+	if (!_openFill) return;
+	_openFill = false;
+
+	// finalize() left the paths as the last subshape, with the styles
+	// still in _currsubshape.
+	SWF::ShapeRecord::Subshapes& subshapes = _shape.subshapes();
+	assert(!subshapes.empty());
+	assert(_currsubshape.paths().empty());
+	_currsubshape.paths().swap(subshapes.back().paths());
+	subshapes.pop_back();
+
+	// Drop the edge that only closed the fill for display.
+	_currpath = &_currsubshape.currentPath();
+	_currpath->m_edges.resize(_openFillEdges);
+}
+
 void
 DynamicShape::endFill()
 {
+	resumeFill();
+
 	// Close the path
 	if ( _currpath && _currfill )
 	{
@@ -82,10 +152,7 @@ DynamicShape::endFill()
 		_y = _currpath->ap.y;
 	}
 
-	if (_currline) {
-		_shape.addSubshape(_currsubshape);
-		_currsubshape.paths().clear(); // Retain style info
-	}
+	if (_currline) pushSubshape();
 
 	// Remove reference to the "current" path, as
 	// next drawing will happen on a different one
@@ -106,13 +173,14 @@ DynamicShape::beginFill(const FillStyle& f)
 	// TODO: how to know wheter the fill should be set
 	//       as *left* or *right* fill ?
 	//       A quick test shows that *left* always work fine !
-	Path newPath(_x, _y, _currfill, 0, _currline);
-	add_path(newPath);
+	addPooledPath();
 }
 
 void
 DynamicShape::startNewPath(bool newShape)
 {
+	resumeFill();
+
 	// Close any pending filled path
 	if ( _currpath && _currfill)
 	{
@@ -120,10 +188,7 @@ DynamicShape::startNewPath(bool newShape)
 		_currpath->close();
 	}
 
-	if (newShape) {
-		_shape.addSubshape(_currsubshape);
-		_currsubshape.paths().clear(); // Retain style info
-	}
+	if (newShape) pushSubshape();
 
 
 	// The DrawingApiTest.swf file shows we should not
@@ -131,8 +196,7 @@ DynamicShape::startNewPath(bool newShape)
 
 	// A quick test shows that *left* always work fine !
 	// More than that, using a *right* fill seems to break the tests !
-	Path newPath(_x, _y, _currfill, 0, _currline);
-	add_path(newPath);
+	addPooledPath();
 }
 
 void
@@ -142,17 +206,24 @@ DynamicShape::finalize() const
 	if ( ! _changed ) return;
 
 	// Close any pending filled path (_currpath should be last path)
+	// for display. If drawing goes on, resumeFill() takes it back and
+	// removes the closing edge, so that endFill() closes the fill where
+	// it begun rather than where it was displayed.
 	if ( _currpath && _currfill)
 	{
 		//assert(!_currsubshape.paths().empty());
 		//assert(_currpath == &(_currsubshape.paths().back()));
+		_openFillEdges = _currpath->m_edges.size();
 		_currpath->close();
+		_openFill = true;
 	}
 
 	// This function being const seems to be at odds with its purpose...
-	_shape.addSubshape(_currsubshape);
+	pushSubshape();
 
-	_currsubshape.paths().clear(); // Retain style info
+	// The current path now belongs to the ShapeRecord, so drawing
+	// continues on a new one.
+	_currpath = nullptr;
 
 	// TODO: check consistency of fills and such !
 
@@ -195,6 +266,7 @@ DynamicShape::moveTo(std::int32_t x, std::int32_t y)
 void
 DynamicShape::lineTo(std::int32_t x, std::int32_t y, int swfVersion)
 {
+	resumeFill();
 	if (!_currpath) startNewPath(false);
 	//assert(_currpath);
 
@@ -227,6 +299,7 @@ void
 DynamicShape::curveTo(std::int32_t cx, std::int32_t cy,
                       std::int32_t ax, std::int32_t ay, int swfVersion)
 {
+	resumeFill();
 	if (!_currpath) startNewPath(false);
 	//assert(_currpath);
 
@@ -260,6 +333,7 @@ DynamicShape::curveTo(std::int32_t cx, std::int32_t cy,
 size_t
 DynamicShape::addFillStyle(const FillStyle& stl)
 {
+    resumeFill();
     _currsubshape.addFillStyle(stl);
     return _currsubshape.fillStyles().size();
 }
@@ -267,6 +341,7 @@ DynamicShape::addFillStyle(const FillStyle& stl)
 size_t
 DynamicShape::add_line_style(const LineStyle& stl)
 {
+    resumeFill();
     _currsubshape.addLineStyle(stl);
     return _currsubshape.lineStyles().size();
 }
@@ -180,9 +180,33 @@ private:
 	/// If newShape is true the new shape will start a new subshape.
 	void startNewPath(bool newShape);
 
+	/// Add a path at the pen position with the current styles.
+	//
+	/// The path is taken from the pool if possible, so that its
+	/// edge storage is reused.
+	void addPooledPath();
+
+	/// Continue drawing a fill that finalize() closed for display.
+	//
+	/// The paths of the last subshape are taken back from the ShapeRecord
+	/// and the closing edge is removed. Called by everything that draws
+	/// or changes styles.
+	void resumeFill();
+
+	/// Move the current paths to a subshape of the ShapeRecord.
+	//
+	/// The styles are kept for the following paths.
+	void pushSubshape() const;
+
+	/// Move paths to the pool, leaving the given container empty.
+	//
+	/// Paths beyond maxPooledPaths are freed.
+	void recyclePaths(SWF::Subshape::Paths& paths);
 
+	/// The largest number of paths kept in the pool.
+	static const size_t maxPooledPaths = 256;
 
-	Path* _currpath;
+	mutable Path* _currpath;
 
 	size_t _currfill;
 
@@ -196,12 +220,26 @@ private:
 
 	mutable bool _changed;
 
+	/// Whether finalize() closed a fill that is still being drawn.
+	mutable bool _openFill;
+
+	/// The number of edges of that fill's path before it was closed.
+	mutable size_t _openFillEdges;
+
 	mutable SWF::Subshape _currsubshape;
 
     /// The actual SWF::ShapeRecord wrapped by this class.
     //
     /// Mutable for lazy finalization.
     mutable SWF::ShapeRecord _shape;
+
+    /// Paths released by clear(), with their edges removed.
+    //
+    /// At most maxPooledPaths are kept.
+    //
+    /// Content that clears and redraws its shape every frame reuses
+    /// them instead of allocating new edge storage each time.
+    SWF::Subshape::Paths _pathPool;
 };
 
 }	// end namespace gnash
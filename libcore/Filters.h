@@ -136,6 +136,9 @@ public:
         m_matrix(std::move(a_matrix))
     {}
 
+    /// The 4x5 matrix, row by row for red, green, blue and alpha.
+    const std::vector<float>& matrix() const { return m_matrix; }
+
 protected:
     std::vector<float> m_matrix; // The color SWFMatrix
 };
@@ -179,6 +182,19 @@ public:
         _alpha(alpha)
     {}
 
+    std::uint8_t matrixX() const { return _matrixX; }
+    std::uint8_t matrixY() const { return _matrixY; }
+
+    /// The matrixX * matrixY matrix, row by row.
+    const std::vector<float>& matrix() const { return _matrix; }
+
+    float divisor() const { return _divisor; }
+    float bias() const { return _bias; }
+    bool preserveAlpha() const { return _preserveAlpha; }
+    bool clamp() const { return _clamp; }
+    std::uint32_t color() const { return _color; }
+    std::uint8_t alpha() const { return _alpha; }
+
 protected:
     std::uint8_t _matrixX; // Number of columns
     std::uint8_t _matrixY; // Number of rows
@@ -192,16 +192,6 @@ public:
     {
         reset(0, 0, 0, 0, 0);
     }
-
-    Path(const Path& from)
-        : 
-        m_fill0(from.m_fill0),
-        m_fill1(from.m_fill1),
-        m_line(from.m_line),
-        ap(from.ap),
-        m_edges(from.m_edges)
-    {
-    }
     
     /// Initialize a path 
     //
@@ -32,8 +32,11 @@ MorphShape::MorphShape(movie_root& mr, as_object* object,
     :
     DisplayObject(mr, object, parent),
     _def(def),
-    _shape(_def->shape1())
+    _shape(_def->shape1()),
+    _morphedRatio(-1),
+    _bounds(_shape.getBounds())
 {
+    _bounds.expand_to_rect(_def->shape2().getBounds());
 }
 
 bool
@@ -78,16 +81,21 @@ MorphShape::currentRatio() const
 SWFRect
 MorphShape::getBounds() const
 {
-    // TODO: optimize this more.
-    SWFRect bounds = _shape.getBounds();
-    bounds.expand_to_rect(_def->shape2().getBounds());
-    return bounds;
+    return _bounds;
 }
 
 void
 MorphShape::morph()
 {
+    // The shape only changes with the ratio, so a paused tween is not
+    // interpolated again on each redraw.
+    if (_morphedRatio == get_ratio()) return;
+
     _shape.setLerp(_def->shape1(), _def->shape2(), currentRatio());
+    _morphedRatio = get_ratio();
+
+    _bounds = _shape.getBounds();
+    _bounds.expand_to_rect(_def->shape2().getBounds());
 }
 
 
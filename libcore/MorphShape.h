@@ -65,6 +65,7 @@ public:
 
 private:
     
+    /// Interpolate the shape for the current ratio, unless already done.
     void morph();
 
     double currentRatio() const;
@@ -73,6 +74,12 @@ private:
 	
     SWF::ShapeRecord _shape;
 
+    /// The ratio _shape was interpolated for, or -1 if it wasn't yet.
+    int _morphedRatio;
+
+    /// The bounds of _shape and of the end shape.
+    SWFRect _bounds;
+
 };
 
 
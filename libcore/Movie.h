@@ -69,7 +69,21 @@ public:
     }
 
     /// Get the URL the Movie was loaded from.
-    virtual const std::string& url() const = 0;
+    //
+    /// This is the URL of the definition unless another one was set
+    /// with setURL().
+    const std::string& url() const {
+        return _url.empty() ? definition()->get_url() : _url;
+    }
+
+    /// Set the URL the Movie was loaded from.
+    //
+    /// The MovieLibrary shares a definition between identical movies
+    /// loaded from different URLs, so the URL of the definition may not
+    /// be the one of this Movie.
+    void setURL(const std::string& url) {
+        _url = url;
+    }
 
     /// Get the version of the Movie
     //
@@ -106,6 +120,11 @@ public:
 
     virtual const movie_definition* definition() const = 0;
 
+private:
+
+    /// The URL of the Movie if not the one of its definition.
+    std::string _url;
+
 };
 
 
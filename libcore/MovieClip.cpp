@@ -1652,9 +1652,18 @@ MovieClip::add_invalidated_bounds(InvalidatedRanges& ranges, bool force)
     if (invalidated() || force) {
         // Add old invalidated bounds
         ranges.add(m_old_invalidated_ranges); 
+        _displayList.add_invalidated_bounds(ranges, true);
+    }
+    else if (_displayList.hasMaskLayers()) {
+        _displayList.add_invalidated_bounds(ranges, false);
+    }
+    else {
+        // Only changed children can add anything, so don't walk the
+        // whole list. Removed ones already passed their bounds on.
+        for (DisplayObject* ch : invalidatedChildren()) {
+            if (!ch->unloaded()) ch->add_invalidated_bounds(ranges, false);
+        }
     }
-    
-    _displayList.add_invalidated_bounds(ranges, force || invalidated());
 
     /// Add drawable.
     SWFRect bounds;
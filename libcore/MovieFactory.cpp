@@ -21,8 +21,16 @@
 
 #include <string>
 #include <map>
+#include <set>
+#include <deque>
 #include <memory> 
 #include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
 
 #include "GnashEnums.h"
 #include "GnashImage.h"
@@ -36,6 +44,7 @@
 #include "StreamProvider.h"
 #include "MovieLibrary.h"
 #include "fontlib.h"
+#include "StringPredicates.h"
 
 namespace gnash {
 
@@ -51,10 +60,82 @@ namespace {
             std::unique_ptr<IOChannel> in, const std::string& url,
             const RunResources& r, FileType type);
 
-    boost::intrusive_ptr<movie_definition> createNonLibraryMovie(
-            const URL& url, const RunResources& runResources,
-            const char* reset_url, bool startLoaderThread,
-            const std::string* postdata);
+    std::unique_ptr<IOChannel> openStream(const URL& url,
+            const RunResources& runResources, const std::string* postdata);
+
+    bool contentHash(IOChannel& in, size_t maxBytes,
+            MovieLibrary::ContentHash& hash, size_t& hashedBytes);
+
+    /// Loads movies and media files before they are requested.
+    //
+    /// URLs are loaded in order by a single thread, each one once,
+    /// until the prefetchBudget setting is spent or the movie library
+    /// is full. Movies are only loaded if the library has room for them,
+    /// so they never evict the movies in use.
+    class Prefetcher
+    {
+    public:
+
+        Prefetcher();
+
+        /// Queue a URL for loading.
+        void add(const URL& url, const RunResources& r);
+
+        /// Stop loading for good and wait for the loader thread.
+        //
+        /// Movies still being parsed may name more URLs; they are
+        /// ignored.
+        void stop();
+
+        /// Stop loading for good without waiting for the loader thread.
+        void kill();
+
+    private:
+
+        struct Request
+        {
+            Request(const URL& u, const RunResources& r)
+                :
+                url(u),
+                runResources(&r)
+            {}
+
+            URL url;
+            const RunResources* runResources;
+        };
+
+        /// Load the queued URLs, in the loader thread.
+        void run();
+
+        /// Load a URL, returning the number of bytes it had.
+        size_t fetch(const Request& r, size_t maxBytes);
+
+        /// Load a movie into the library if it has room for it.
+        //
+        /// Movies already in the library cost nothing.
+        size_t fetchMovie(const Request& r, size_t maxBytes);
+
+        std::mutex _mutex;
+
+        std::condition_variable _wakeup;
+
+        std::deque<Request> _queue;
+
+        /// All URLs ever queued.
+        std::set<std::string> _seen;
+
+        /// The number of bytes loaded.
+        size_t _spent;
+
+        /// Checked before locking, as loader threads may name URLs
+        /// while the programme exits.
+        std::atomic<bool> _killed;
+
+        std::thread _thread;
+    };
+
+    /// The Prefetcher is never destroyed; see prefetcher().
+    Prefetcher& prefetcher();
 }
 
 MovieLibrary MovieFactory::movieLibrary;
@@ -123,11 +204,41 @@ MovieFactory::makeMovie(const URL& url, const RunResources& runResources,
         }
     }
 
-    // Try to open a file under the filename, but DO NOT start
-    // the loader thread now to avoid IMPORT tag loaders from 
-    // calling createMovie() again and NOT finding
-    // the just-created movie.
-    mov = createNonLibraryMovie(url, runResources, real_url, false, postdata);
+    std::unique_ptr<IOChannel> in = openStream(url, runResources, postdata);
+    if (!in.get()) {
+        log_error(_("Couldn't load library movie '%s'"), url.str());
+        return mov;
+    }
+
+    // An identical movie may be in the library under another URL. Only
+    // local files are hashed, as reading remote movies twice would
+    // hold back their progressive loading.
+    MovieLibrary::ContentHash hash = 0;
+    size_t hashedBytes = 0;
+    const bool local = !postdata && url.protocol() == "file";
+    const bool hashed = local &&
+        contentHash(*in, movieLibrary.budget(), hash, hashedBytes);
+
+    // The stream could not be rewound after hashing, so open it again.
+    if (local && !hashed && in->tell() != 0) {
+        in = openStream(url, runResources, postdata);
+        if (!in.get()) {
+            log_error(_("Couldn't load library movie '%s'"), url.str());
+            return mov;
+        }
+    }
+
+    if (hashed && movieLibrary.get(hash, hashedBytes, cache_label, &mov)) {
+        log_debug("Movie %s already in library from another URL",
+                cache_label);
+        return mov;
+    }
+
+    // DO NOT start the loader thread now to avoid IMPORT tag loaders
+    // from calling createMovie() again and NOT finding the just-created
+    // movie.
+    const std::string& movie_url = real_url ? real_url : url.str();
+    mov = makeMovie(std::move(in), movie_url, runResources, false);
 
     if (!mov) {
         log_error(_("Couldn't load library movie '%s'"), url.str());
@@ -136,7 +247,8 @@ MovieFactory::makeMovie(const URL& url, const RunResources& runResources,
 
     // Movie is good, add to the library, but not if we used POST
     if (!postdata) {
-        movieLibrary.add(cache_label, mov.get());
+        if (hashed) movieLibrary.add(cache_label, hash, hashedBytes, mov.get());
+        else movieLibrary.add(cache_label, mov.get());
         log_debug("Movie %s (SWF%d) added to library",
                 cache_label, mov->get_version());
     }
@@ -153,9 +265,28 @@ MovieFactory::makeMovie(const URL& url, const RunResources& runResources,
     return mov;
 }
 
+void
+MovieFactory::prefetch(const URL& url, const RunResources& runResources)
+{
+    prefetcher().add(url, runResources);
+}
+
+void
+MovieFactory::stopPrefetching()
+{
+    prefetcher().stop();
+}
+
 void
 MovieFactory::clear()
 {
+    stopPrefetching();
+
+    const MovieLibrary::Stats s = movieLibrary.stats();
+    log_debug("Movie library: %d hits by URL, %d by content, %d misses, "
+            "%d evictions, %d movies of about %d bytes", s.urlHits,
+            s.contentHits, s.misses, s.evictions, s.items, s.bytes);
+
     movieLibrary.clear();
 }
 
@@ -286,14 +417,10 @@ createBitmapMovie(std::unique_ptr<IOChannel> in, const std::string& url,
 
 }
 
-boost::intrusive_ptr<movie_definition>
-createNonLibraryMovie(const URL& url, const RunResources& runResources,
-        const char* reset_url, bool startLoaderThread,
+std::unique_ptr<IOChannel>
+openStream(const URL& url, const RunResources& runResources,
         const std::string* postdata)
 {
-  
-    boost::intrusive_ptr<movie_definition> ret;
-  
     std::unique_ptr<IOChannel> in;
   
     const StreamProvider& streamProvider = runResources.streamProvider();
@@ -307,20 +434,235 @@ createNonLibraryMovie(const URL& url, const RunResources& runResources,
   
     if (!in.get()) {
         log_error(_("failed to open '%s'; can't create movie"), url);
-        return ret;
+        return in;
     }
     
     if (in->bad()) {
         log_error(_("streamProvider opener can't open '%s'"), url);
-        return ret;
+        in.reset();
     }
   
-    const std::string& movie_url = reset_url ? reset_url : url.str();
-    ret = MovieFactory::makeMovie(std::move(in), movie_url, runResources,
-            startLoaderThread);
-  
-    return ret;
-  
+    return in;
+}
+
+/// Compute a 64-bit FNV-1a hash of a whole stream, then rewind it.
+//
+/// The number of bytes hashed is returned as well, for the library to
+/// compare.
+///
+/// Streams that cannot be rewound, such as pipes, are not hashed.
+/// Nothing is hashed if the stream is longer than maxBytes, as the
+/// library would not hold it anyway.
+bool
+contentHash(IOChannel& in, size_t maxBytes, MovieLibrary::ContentHash& hash,
+        size_t& hashedBytes)
+{
+    const size_t size = in.size();
+    if (!maxBytes || (size != static_cast<size_t>(-1) && size > maxBytes)) {
+        return false;
+    }
+    if (!in.seek(0)) return false;
+
+    MovieLibrary::ContentHash h = 14695981039346656037ULL;
+    size_t total = 0;
+    bool complete = true;
+
+    try {
+        unsigned char buf[16384];
+        std::streamsize got;
+        while ((got = in.read(buf, sizeof buf)) > 0) {
+            total += got;
+            if (total > maxBytes) {
+                complete = false;
+                break;
+            }
+            for (std::streamsize i = 0; i < got; ++i) {
+                h = (h ^ buf[i]) * 1099511628211ULL;
+            }
+        }
+    }
+    catch (const IOException& e) {
+        log_error(_("Error reading movie data: %s"), e.what());
+        complete = false;
+    }
+
+    if (!in.seek(0)) {
+        log_error(_("Could not rewind the movie data after hashing it"));
+        return false;
+    }
+    if (!complete) return false;
+
+    hash = h;
+    hashedBytes = total;
+    return true;
+}
+
+void
+killPrefetcher()
+{
+    prefetcher().kill();
+}
+
+/// Loader threads may still name URLs while the programme exits, so the
+/// Prefetcher is never destroyed and its thread is not joined from a
+/// static destructor. Gui::quit() stops it before the MovieLibrary can
+/// be destroyed; the exit handler only keeps new URLs out.
+Prefetcher&
+prefetcher()
+{
+    static Prefetcher* p = new Prefetcher;
+    static const int registered = std::atexit(killPrefetcher);
+    UNUSED(registered);
+    return *p;
+}
+
+Prefetcher::Prefetcher()
+    :
+    _spent(0),
+    _killed(false)
+{
+}
+
+void
+Prefetcher::add(const URL& url, const RunResources& r)
+{
+    if (_killed) return;
+
+    const RcInitFile& rcfile = RcInitFile::getDefaultInstance();
+    const size_t budget = static_cast<size_t>(rcfile.getPrefetchBudget()) * 1024;
+
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    if (_killed || _spent >= budget) return;
+    if (!MovieFactory::movieLibrary.freeRoom()) return;
+    if (!_seen.insert(url.str()).second) return;
+
+    log_debug("Queueing %s for prefetching", url);
+    _queue.push_back(Request(url, r));
+
+    if (!_thread.joinable()) {
+        _thread = std::thread(std::bind(&Prefetcher::run, this));
+    }
+    else _wakeup.notify_all();
+}
+
+void
+Prefetcher::stop()
+{
+    kill();
+    if (_thread.joinable()) _thread.join();
+}
+
+void
+Prefetcher::kill()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _killed = true;
+    _queue.clear();
+    _wakeup.notify_all();
+}
+
+void
+Prefetcher::run()
+{
+    const RcInitFile& rcfile = RcInitFile::getDefaultInstance();
+    const size_t budget = static_cast<size_t>(rcfile.getPrefetchBudget()) * 1024;
+
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    for (;;) {
+
+        _wakeup.wait(lock, [this] () { return _killed || !_queue.empty(); });
+        if (_killed) return;
+
+        if (_spent >= budget || !MovieFactory::movieLibrary.freeRoom()) {
+            _queue.clear();
+            continue;
+        }
+
+        const Request r = _queue.front();
+        _queue.pop_front();
+        const size_t left = budget - _spent;
+
+        lock.unlock();
+        const size_t bytes = fetch(r, left);
+        lock.lock();
+
+        _spent += bytes;
+    }
+}
+
+size_t
+Prefetcher::fetch(const Request& r, size_t maxBytes)
+{
+    const std::string& path = r.url.path();
+    const bool movie = path.size() >= 4 &&
+        StringNoCaseEqual()(path.substr(path.size() - 4), ".swf");
+
+    if (movie) return fetchMovie(r, maxBytes);
+
+    // There is no cache of media streams, so sounds and videos are
+    // only read through for the system to cache local files.
+    if (r.url.protocol() != "file") return 0;
+
+    log_debug("Prefetching %s", r.url);
+    std::unique_ptr<IOChannel> in =
+        r.runResources->streamProvider().getStream(r.url);
+    if (!in.get() || in->bad()) return 0;
+
+    size_t total = 0;
+    try {
+        char buf[16384];
+        std::streamsize got;
+        while (total < maxBytes && (got = in->read(buf, sizeof buf)) > 0) {
+            total += got;
+        }
+    }
+    catch (const IOException& e) {
+        log_debug("Error prefetching %s: %s", r.url, e.what());
+    }
+    return total;
+}
+
+size_t
+Prefetcher::fetchMovie(const Request& r, size_t maxBytes)
+{
+    MovieLibrary& library = MovieFactory::movieLibrary;
+    const std::string key = r.url.str();
+
+    if (library.contains(key)) return 0;
+
+    std::unique_ptr<IOChannel> in = openStream(r.url, *r.runResources,
+            nullptr);
+    if (!in.get()) return 0;
+
+    // The size must be known to be sure that the movie fits.
+    const size_t size = in->size();
+    if (size == static_cast<size_t>(-1) ||
+            size > std::min(maxBytes, library.freeRoom())) {
+        log_debug("No room to prefetch movie %s", r.url);
+        return 0;
+    }
+
+    log_debug("Prefetching movie %s", r.url);
+
+    boost::intrusive_ptr<movie_definition> md;
+    MovieLibrary::ContentHash hash = 0;
+    size_t hashedBytes = 0;
+    const bool local = r.url.protocol() == "file";
+    const bool hashed = local &&
+        contentHash(*in, library.budget(), hash, hashedBytes);
+    if (hashed && library.get(hash, hashedBytes, key, &md)) return 0;
+    if (local && !hashed && in->tell() != 0) return 0;
+
+    md = MovieFactory::makeMovie(std::move(in), key, *r.runResources, false);
+    if (!md) return 0;
+
+    if (hashed) library.add(key, hash, hashedBytes, md.get());
+    else library.add(key, md.get());
+
+    md->completeLoad();
+    return size;
 }
 
 } // unnamed namespace
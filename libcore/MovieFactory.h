@@ -114,8 +114,32 @@ public:
             std::unique_ptr<IOChannel> in, const std::string& url,
             const RunResources& runResources, bool startLoaderThread);
 
+    /// Load a movie or media file before it is requested.
+    //
+    /// This does nothing unless the prefetchBudget setting is set. The
+    /// file is loaded by a background thread: a movie is then added to
+    /// the library, a local sound or video file is only read through.
+    /// Each URL is prefetched once, until the budget is spent.
+    ///
+    /// @param url
+    /// The URL of the movie, sound or video file.
+    ///
+    /// @param runResources
+    /// The RunResources to load a movie with. It must be kept alive
+    /// until clear() is called.
+    static DSOEXPORT void prefetch(const URL& url,
+            const RunResources& runResources);
+
+    /// Stop prefetching for the rest of the run.
+    //
+    /// This waits for a movie being prefetched to be added to the
+    /// library, so it must be called before the programme exits.
+    static DSOEXPORT void stopPrefetching();
+
     /// Clear the MovieFactory resources
     //
+    /// This stops prefetching for the rest of the run and empties the
+    /// library.
     /// This should be in the dtor.
     static DSOEXPORT void clear();
 
@@ -25,105 +25,298 @@
 #include <boost/intrusive_ptr.hpp>
 #include <string>
 #include <map>
-#include <algorithm>
+#include <list>
+#include <vector>
+#include <mutex>
+#include <cstdint>
 
 namespace gnash {
 
-/// Library of SWF movies indexed by URL strings
+/// Library of SWF movies indexed by URL strings and content
 //
 /// Elements are actually movie_definitions, the ones
 /// associated with URLS. They may be BitmapMovieDefinitions or
 /// SWFMovieDefinitions.
+//
+/// A movie read from a new URL is also looked up by a hash of the
+/// bytes it was read from, so identical movies loaded from different
+/// URLs (or with different query strings) share a single definition.
+//
+/// The library is bounded both by a number of movies and by an
+/// approximate size in bytes, the size of the files the movies were
+/// read from. The least recently used movies are evicted first.
 class MovieLibrary
 {
 public:
 
+    /// A hash of the bytes a movie was read from.
+    typedef std::uint64_t ContentHash;
+
+    /// Counters of the library use.
+    struct Stats
+    {
+        Stats()
+            :
+            urlHits(0),
+            contentHits(0),
+            misses(0),
+            evictions(0),
+            bytes(0),
+            items(0)
+        {}
+
+        /// Movies found by their URL.
+        std::uint64_t urlHits;
+
+        /// Movies found by their content under another URL.
+        std::uint64_t contentHits;
+
+        /// Movies that were not found and had to be parsed.
+        std::uint64_t misses;
+
+        /// Movies evicted to keep the library within its limits.
+        std::uint64_t evictions;
+
+        /// Approximate size of the movies currently held.
+        size_t bytes;
+
+        /// Number of movies currently held.
+        size_t items;
+    };
+
     struct LibraryItem
     {
         boost::intrusive_ptr<movie_definition> def;
-        unsigned hitCount;
+
+        /// Whether the content hash of the movie is known.
+        bool hashed;
+
+        ContentHash hash;
+
+        /// The number of bytes hashed, also compared on a lookup by
+        /// content so that a hash collision can't return another movie.
+        size_t hashedBytes;
+
+        /// The approximate size of the movie.
+        size_t bytes;
+
+        /// All URLs the movie was requested with.
+        std::vector<std::string> urls;
     };
 
-    typedef std::map<std::string, LibraryItem> LibraryContainer;
+    /// The movies, most recently used first.
+    typedef std::list<LibraryItem> LibraryContainer;
 
     MovieLibrary()
         : 
-        _limit(8) 
+        _limit(8),
+        _budget(0),
+        _bytes(0)
     {
         RcInitFile& rcfile = RcInitFile::getDefaultInstance();
+        _budget = static_cast<size_t>(rcfile.getMovieLibraryBudget()) * 1024;
 	    setLimit(rcfile.getMovieLibraryLimit());
     }
   
     /// Sets the maximum number of items to hold in the library. When adding new
-    /// items, the one with the least hit count is being removed in that case.
+    /// items, the least recently used one is being removed in that case.
     /// Zero is a valid limit (disables library). 
     void setLimit(LibraryContainer::size_type limit)
     {
+        std::lock_guard<std::mutex> lock(_mapMutex);
         _limit = limit;  
-        limitSize(_limit);  
+        limitSize(_limit, _budget);
     }
 
+    /// Sets the approximate number of bytes the library may hold.
+    //
+    /// Movies larger than this are never added.
+    void setBudget(size_t bytes)
+    {
+        std::lock_guard<std::mutex> lock(_mapMutex);
+        _budget = bytes;
+        limitSize(_limit, _budget);
+    }
+
+    /// The size of the largest movie the library may hold.
+    //
+    /// This is zero when the library is disabled.
+    size_t budget() const
+    {
+        std::lock_guard<std::mutex> lock(_mapMutex);
+        return _limit ? _budget : 0;
+    }
+
+    /// The number of bytes that can be added without evicting a movie.
+    //
+    /// This is zero when the library holds as many movies as it may.
+    size_t freeRoom() const
+    {
+        std::lock_guard<std::mutex> lock(_mapMutex);
+        if (_items.size() >= _limit) return 0;
+        return _budget - _bytes;
+    }
+
+    /// Whether a movie was added with the given URL.
+    //
+    /// Unlike get(), this is not counted as a use of the movie.
+    bool contains(const std::string& key) const
+    {
+        std::lock_guard<std::mutex> lock(_mapMutex);
+        return _byURL.find(key) != _byURL.end();
+    }
+
+    /// Get the movie previously added with the given URL.
     bool get(const std::string& key,
             boost::intrusive_ptr<movie_definition>* ret)
     {
         std::lock_guard<std::mutex> lock(_mapMutex);
-        LibraryContainer::iterator it = _map.find(key);
-        if (it == _map.end()) return false;
+        URLMap::iterator it = _byURL.find(key);
+        if (it == _byURL.end()) return false;
         
-        *ret = it->second.def;
-        it->second.hitCount++;
+        touch(it->second);
+        *ret = it->second->def;
+        ++_stats.urlHits;
         return true;
     }
 
-    void add(const std::string& key, movie_definition* mov)
+    /// Get a movie read from the same bytes as the one at the given URL.
+    //
+    /// On success, the movie can then also be found by the URL.
+    ///
+    /// @param hashedBytes  The number of bytes the hash was computed from.
+    bool get(ContentHash hash, size_t hashedBytes, const std::string& key,
+            boost::intrusive_ptr<movie_definition>* ret)
     {
+        std::lock_guard<std::mutex> lock(_mapMutex);
+        ContentMap::iterator it = _byContent.find(hash);
+        if (it == _byContent.end() || it->second->hashedBytes != hashedBytes) {
+            return false;
+        }
 
-        if (!_limit) return;
-
-        if (_limit) limitSize(_limit - 1);
+        touch(it->second);
+        if (_byURL.insert(std::make_pair(key, it->second)).second) {
+            it->second->urls.push_back(key);
+        }
+        *ret = it->second->def;
+        ++_stats.contentHits;
+        return true;
+    }
 
-        LibraryItem temp;
+    /// Add a movie whose content hash is unknown.
+    void add(const std::string& key, movie_definition* mov)
+    {
+        insert(key, mov, false, 0, 0);
+    }
 
-        temp.def = mov;
-        temp.hitCount = 0;
+    /// Add a movie read from bytes with the given hash.
+    void add(const std::string& key, ContentHash hash, size_t hashedBytes,
+            movie_definition* mov)
+    {
+        insert(key, mov, true, hash, hashedBytes);
+    }
 
+    void clear()
+    {
         std::lock_guard<std::mutex> lock(_mapMutex);
-        _map[key] = temp;
+        _items.clear();
+        _byURL.clear();
+        _byContent.clear();
+        _bytes = 0;
     }
-  
 
-    void clear()
+    /// Get the counters of the library use since it was created.
+    Stats stats() const
     {
         std::lock_guard<std::mutex> lock(_mapMutex);
-        _map.clear();
+        Stats s = _stats;
+        s.bytes = _bytes;
+        s.items = _items.size();
+        return s;
     }
   
 private:
 
-    static bool findWorstHitCount(const LibraryContainer::value_type& a,
-                                const LibraryContainer::value_type& b)
+    typedef std::map<std::string, LibraryContainer::iterator> URLMap;
+
+    typedef std::map<ContentHash, LibraryContainer::iterator> ContentMap;
+
+    void insert(const std::string& key, movie_definition* mov, bool hashed,
+            ContentHash hash, size_t hashedBytes)
     {
-        return (a.second.hitCount < b.second.hitCount);
-    }
+        std::lock_guard<std::mutex> lock(_mapMutex);
+        ++_stats.misses;
 
-    LibraryContainer _map;
-    unsigned _limit;
+        if (!_limit) return;
 
-    void limitSize(LibraryContainer::size_type max) {
+        // The size of the file is what a movie definition is known
+        // to hold; the parsed structures are of the same order.
+        const size_t bytes = mov->get_bytes_total();
+        if (bytes > _budget) return;
 
-        if (max < 1) {
-            clear();
-            return;
+        // Replace any movie previously added under this URL or content.
+        URLMap::iterator u = _byURL.find(key);
+        if (u != _byURL.end()) erase(u->second);
+        if (hashed) {
+            ContentMap::iterator c = _byContent.find(hash);
+            if (c != _byContent.end()) erase(c->second);
         }
 
-        while (_map.size() > max) {
-            std::lock_guard<std::mutex> lock(_mapMutex);
-            _map.erase(std::min_element(_map.begin(), _map.end(),
-                        &findWorstHitCount));
+        limitSize(_limit - 1, _budget - bytes);
+
+        LibraryItem temp;
+        temp.def = mov;
+        temp.hashed = hashed;
+        temp.hash = hash;
+        temp.hashedBytes = hashedBytes;
+        temp.bytes = bytes;
+        temp.urls.push_back(key);
+
+        _items.push_front(temp);
+        _byURL[key] = _items.begin();
+        if (hashed) _byContent[hash] = _items.begin();
+        _bytes += bytes;
+    }
+
+    /// Make an item the most recently used one.
+    void touch(LibraryContainer::iterator it)
+    {
+        _items.splice(_items.begin(), _items, it);
+    }
+
+    void erase(LibraryContainer::iterator it)
+    {
+        for (const std::string& url : it->urls) _byURL.erase(url);
+        if (it->hashed) _byContent.erase(it->hash);
+        _bytes -= it->bytes;
+        _items.erase(it);
+    }
+
+    /// Evict the least recently used items above the given limits.
+    void limitSize(LibraryContainer::size_type max, size_t maxBytes)
+    {
+        while (!_items.empty() &&
+                (_items.size() > max || _bytes > maxBytes)) {
+            erase(--_items.end());
+            ++_stats.evictions;
         }
-    
     }
 
+    LibraryContainer _items;
+
+    URLMap _byURL;
+
+    ContentMap _byContent;
+
+    unsigned _limit;
+
+    size_t _budget;
+
+    /// Approximate size of the movies in the library.
+    size_t _bytes;
+
+    Stats _stats;
+
     mutable std::mutex _mapMutex;
   
 };
@@ -253,6 +253,10 @@ MovieLoader::processCompletedRequest(const Request& r)
 		return true; // completed in any case...
 	}
 
+    // The definition may be shared with an identical movie loaded
+    // from another URL.
+    if (md->get_url() != url.str()) extern_movie->setURL(url.str());
+
 	// Parse query string
 	MovieClip::MovieVariables vars;
 	url.parse_querystring(url.querystring(), vars);
@@ -147,15 +147,17 @@ public:
     ///                     bool accept(const ObjectURI&, const as_value&);
     ///                 Scan is by enumeration order and stops when accept()
     ///                 returns false.
+    /// @return         false if the scan was stopped by the visitor.
     template <class U, class V>
-    void visitValues(V& visitor, U cmp = U()) const {
+    bool visitValues(V& visitor, U cmp = U()) const {
 
         for (const auto& prop : _props) {
 
             if (!cmp(prop)) continue;
             as_value val = prop.getValue(_owner);
-            if (!visitor.accept(prop.uri(), val)) return;
+            if (!visitor.accept(prop.uri(), val)) return false;
         }
+        return true;
     }
 
     /// Enumerate all non-hidden properties to the given container.
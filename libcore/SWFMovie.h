@@ -86,11 +86,6 @@ public:
 	/// It's intended to be called by movie_root::setLevel().
     void construct(as_object* init = nullptr);
 
-    /// Get the URL of the SWFMovie's definition.
-    const std::string& url() const {
-        return _def->get_url();
-    }
-
     /// Get the version of the SWFMovie.
     //
     /// @return     the version of the SWFMovie.
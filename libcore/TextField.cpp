@@ -78,6 +78,7 @@ TextField::TextField(as_object* object, DisplayObject* parent,
     :
     InteractiveObject(object, parent),
     _tag(&def),
+    _layoutPending(false),
     _url(""),
     _target(""),
     _display(),
@@ -146,6 +147,7 @@ TextField::TextField(as_object* object, DisplayObject* parent,
         SWFRect bounds)
     :
     InteractiveObject(object, parent),
+    _layoutPending(false),
     _url(""),
     _target(""),
     _display(),
@@ -273,6 +275,8 @@ TextField::show_cursor(Renderer& renderer, const SWFMatrix& mat)
 size_t
 TextField::cursorRecord()
 {
+    layout();
+
     if (_textRecords.empty()) return 0;
 
     size_t i = 0;
@@ -292,6 +296,8 @@ TextField::display(Renderer& renderer, const Transform& base)
 
     registerTextVariable();
 
+    layout();
+
     const bool drawBorder = getDrawBorder();
     const bool drawBackground = getDrawBackground();
 
@@ -380,6 +386,8 @@ TextField::add_invalidated_bounds(InvalidatedRanges& ranges, bool force)
 {
     if (!force && !invalidated()) return; // no need to redraw
     
+    layout();
+
     ranges.add(m_old_invalidated_ranges);
 
     const SWFMatrix& wm = getWorldMatrix(*this);
@@ -537,6 +545,7 @@ TextField::keyInput(key::code c)
 
 
     setHtml(false); //editable html fields are not yet implemented
+    layout();
     std::wstring s = _text;
 
     // maybe _text is changed in ActionScript
@@ -736,6 +745,8 @@ TextField::mouseEvent(const event_id& ev)
     {
 		case event_id::PRESS:
 		{
+			layout();
+
 			movie_root& root = stage();
             std::int32_t x_mouse, y_mouse;
             boost::tie(x_mouse, y_mouse) = root.mousePosition();
@@ -781,6 +792,7 @@ TextField::topmostMouseEntity(std::int32_t x, std::int32_t y)
     point p(x, y);
     m.invert().transform(p);
 
+    layout();
     if (_bounds.point_test(p.x, p.y)) return this;
 
     return nullptr;
@@ -802,12 +814,18 @@ TextField::updateText(const std::wstring& wstr)
 
     set_invalidated();
 
+    // Appending text, as in a log or a chat window, only needs the new
+    // text to be laid out.
+    const bool appended = _layoutEnd && wstr.size() > _text.size() &&
+        !wstr.compare(0, _text.size(), _text);
+
     _text = wstr;
 
     _selection.first = std::min(_selection.first, _text.size());
     _selection.second = std::min(_selection.second, _text.size());
 
-    format_text();
+    if (appended) _layoutPending = true;
+    else invalidateLayout();
 }
 
 void
@@ -815,10 +833,10 @@ TextField::updateHtmlText(const std::wstring& wstr)
 {
     if (_htmlText == wstr) return;
 
+    // The layout only depends on _text.
     set_invalidated();
 
     _htmlText = wstr;
-    format_text();
 }
 
 void
@@ -876,7 +894,7 @@ TextField::setTextFormat(TextFormat_as& tf)
 {
     //TODO: this is lazy. we should set all the TextFormat variables HERE, i think
     //This is just so we can set individual variables without having to call format_text()
-    //This calls format_text() at the end of setting TextFormat
+    //This lays the text out again at the end of setting TextFormat
     if (tf.align()) setAlignment(*tf.align());
     if (tf.size()) setFontHeight(*tf.size()); // keep twips
     if (tf.indent()) setIndent(*tf.indent());
@@ -894,11 +912,12 @@ TextField::setTextFormat(TextFormat_as& tf)
 	if (tf.url()) setURL(*tf.url());
 	if (tf.target()) setTarget(*tf.target());
     
-    format_text();
+    invalidateLayout();
 }
 
 float
-TextField::align_line(TextAlignment align, int last_line_start_record, float x)
+TextField::align_line(TextAlignment align, int last_line_start_record,
+        float x) const
 {
     float width = _bounds.width(); 
     float right_margin = getRightMargin();
@@ -949,13 +968,13 @@ TextField::setFont(boost::intrusive_ptr<const Font> newfont)
     boost::intrusive_ptr<const Font> oldfont = _font;
     set_invalidated();
     _font = newfont; 
-    format_text();
+    invalidateLayout();
     return oldfont;  
 }
 
 
 void
-TextField::insertTab(SWF::TextRecord& rec, std::int32_t& x, float scale)
+TextField::insertTab(SWF::TextRecord& rec, std::int32_t& x, float scale) const
 {
      // tab (ASCII HT)
     const int space = 32;
@@ -1011,13 +1030,20 @@ TextField::insertTab(SWF::TextRecord& rec, std::int32_t& x, float scale)
 }
 
 void
-TextField::format_text()
+TextField::format_text() const
 {
+    _layoutPending = false;
+    _layoutEnd.reset();
+
     _textRecords.clear();
     _line_starts.clear();
     _recordStarts.clear();
     _glyphcount = 0;
 
+    // Counted again by newLine(), so that it doesn't depend on how
+    // many times the text was laid out.
+    _maxScroll = 1;
+
     _recordStarts.push_back(0);
 		
     // nothing more to do if text is empty
@@ -1124,6 +1150,17 @@ TextField::format_text()
     ///handleChar takes care of placing the glyphs    
     handleChar(it, e, x, y, rec, last_code, last_space_glyph,
             last_line_start_record);
+
+    // Text appended later can be laid out from here if this is the
+    // end of the text, and laying out more text cannot change the lines
+    // above. A line that was truncated must be laid out again.
+    if (it == e && !doHtml() && !doWordWrap() &&
+            autoSize == AUTOSIZE_NONE && getTextAlignment() == ALIGN_LEFT &&
+            x < _bounds.width() - getRightMargin() - PADDING_TWIPS) {
+        const LayoutEnd end = { x, y, last_code, last_space_glyph,
+            last_line_start_record, _text.size() };
+        _layoutEnd = end;
+    }
                 
     // Expand bounding box to include the whole text (if autoSize and wordWrap
     // is not in operation.
@@ -1154,13 +1191,51 @@ TextField::format_text()
     align_line(getTextAlignment(), last_line_start_record, x);
 
     scrollLines();
-	
-    set_invalidated(); //redraw
-    
 }
 
 void
-TextField::scrollLines()
+TextField::formatAppendedText() const
+{
+    LayoutEnd end = *_layoutEnd;
+
+    _layoutPending = false;
+    _layoutEnd.reset();
+
+    // Carry on with the last line. Its vertical offset may have been
+    // changed by display().
+    SWF::TextRecord rec = _textRecords.back();
+    _textRecords.pop_back();
+    rec.setYOffset(end.y);
+
+    std::wstring::const_iterator it = _text.begin() + end.textLength;
+    const std::wstring::const_iterator e = _text.end();
+
+    handleChar(it, e, end.x, end.y, rec, end.lastCode, end.lastSpaceGlyph,
+            end.lastLineStartRecord);
+
+    if (it == e && end.x < _bounds.width() - getRightMargin() - PADDING_TWIPS) {
+        end.textLength = _text.size();
+        _layoutEnd = end;
+    }
+
+    _textRecords.push_back(rec);
+
+    scrollLines();
+}
+
+void
+TextField::invalidateLayout()
+{
+    // Invalidate first, so that the bounds of the text as it was laid
+    // out are the ones to redraw.
+    set_invalidated();
+
+    _layoutPending = true;
+    _layoutEnd.reset();
+}
+
+void
+TextField::scrollLines() const
 {
     std::uint16_t fontHeight = getFontHeight();
     const float fontLeading = 0;
@@ -1204,7 +1279,7 @@ TextField::scrollLines()
 void
 TextField::newLine(std::int32_t& x, std::int32_t& y,
 				   SWF::TextRecord& rec, int& last_space_glyph,
-				LineStarts::value_type& last_line_start_record, float div)
+				LineStarts::value_type& last_line_start_record, float div) const
 {
     // newline.
     LineStarts::iterator linestartit = _line_starts.begin();
@@ -1292,7 +1367,8 @@ void
 TextField::handleChar(std::wstring::const_iterator& it,
         const std::wstring::const_iterator& e, std::int32_t& x,
         std::int32_t& y, SWF::TextRecord& rec, int& last_code,
-        int& last_space_glyph, LineStarts::value_type& last_line_start_record)
+        int& last_space_glyph,
+        LineStarts::value_type& last_line_start_record) const
 {
     LineStarts::iterator linestartit = _line_starts.begin();
     LineStarts::const_iterator linestartend = _line_starts.end();
@@ -1564,8 +1640,8 @@ TextField::handleChar(std::wstring::const_iterator& it,
                             attloc = attributes.find("BLOCKINDENT");
                             if (attloc != attributes.end()) {
                                 //textformat BLOCKINDENT attribute
-                                setBlockIndent(pixelsToTwips(std::strtol(
-                                        attloc->second.data(), nullptr, 10)));
+                                _blockIndent = pixelsToTwips(std::strtol(
+                                        attloc->second.data(), nullptr, 10));
                                 if (newrec.xOffset() == std::max(0, originalleftmargin +
                                     originalindent + originalblockindent) + PADDING_TWIPS) {
                                     //if beginning of line, indent
@@ -1578,8 +1654,8 @@ TextField::handleChar(std::wstring::const_iterator& it,
                             attloc = attributes.find("INDENT");
                             if (attloc != attributes.end()) {
                                 //textformat INDENT attribute
-                                setIndent(pixelsToTwips(std::strtol(
-                                    attloc->second.data(), nullptr, 10)));
+                                _indent = pixelsToTwips(std::strtol(
+                                    attloc->second.data(), nullptr, 10));
                                 if (newrec.xOffset() == std::max(0, originalleftmargin +
                                     originalindent + getBlockIndent()) + PADDING_TWIPS) {
                                     //if beginning of line, indent
@@ -1592,14 +1668,14 @@ TextField::handleChar(std::wstring::const_iterator& it,
                             attloc = attributes.find("LEADING");
                             if (attloc != attributes.end()) {
                                 //textformat LEADING attribute
-                                setLeading(pixelsToTwips(std::strtol(
-                                        attloc->second.data(), nullptr, 10)));
+                                _leading = pixelsToTwips(std::strtol(
+                                        attloc->second.data(), nullptr, 10));
                             }
                             attloc = attributes.find("LEFTMARGIN");
                             if (attloc != attributes.end()) {
                                 //textformat LEFTMARGIN attribute
-                                setLeftMargin(pixelsToTwips(std::strtol(
-                                        attloc->second.data(), nullptr, 10)));
+                                _leftMargin = pixelsToTwips(std::strtol(
+                                        attloc->second.data(), nullptr, 10));
                                 if (newrec.xOffset() == std::max(0, originalleftmargin +
                                     getIndent() + getBlockIndent()) + PADDING_TWIPS) {
                                     //if beginning of line, indent
@@ -1612,8 +1688,8 @@ TextField::handleChar(std::wstring::const_iterator& it,
                             attloc = attributes.find("RIGHTMARGIN");
                             if (attloc != attributes.end()) {
                                 //textformat RIGHTMARGIN attribute
-                                setRightMargin(pixelsToTwips(std::strtol(
-                                        attloc->second.data(), nullptr, 10)));
+                                _rightMargin = pixelsToTwips(std::strtol(
+                                        attloc->second.data(), nullptr, 10));
                                 //FIXME:Should not apply this to this line if we are not at
                                 //beginning of line. Not sure how to do that.
                             }
@@ -1624,12 +1700,12 @@ TextField::handleChar(std::wstring::const_iterator& it,
                             }
                             handleChar(it, e, x, y, newrec, last_code,
                                     last_space_glyph, last_line_start_record);
-                            setBlockIndent(originalblockindent);
-                            setIndent(originalindent);
-                            setLeading(originalleading);
-                            setLeftMargin(originalleftmargin);
-                            setRightMargin(originalrightmargin);
-                            setTabStops(originaltabstops);
+                            _blockIndent = originalblockindent;
+                            _indent = originalindent;
+                            _leading = originalleading;
+                            _leftMargin = originalleftmargin;
+                            _rightMargin = originalrightmargin;
+                            _tabStops = originaltabstops;
                         }
                         else if (s == "P") {
                             //paragraph
@@ -2192,6 +2268,7 @@ TextField::pointInShape(std::int32_t x, std::int32_t y) const
     const SWFMatrix wm = getWorldMatrix(*this).invert();
     point lp(x, y);
     wm.transform(lp);
+    layout();
     return _bounds.point_test(lp.x, lp.y);
 }
 
@@ -2262,6 +2339,7 @@ TextField::setTextColor(const rgba& col)
 
         set_invalidated();
         _textColor = col;
+        _layoutEnd.reset();
         std::for_each(_displayRecords.begin(), _displayRecords.end(),
                 std::bind(&SWF::TextRecord::setColor, std::placeholders::_1,
                     _textColor));
@@ -2274,7 +2352,7 @@ TextField::setEmbedFonts(bool use)
     if (_embedFonts != use) {
         set_invalidated();
         _embedFonts=use;
-        format_text();
+        invalidateLayout();
     }
 }
 
@@ -2284,7 +2362,7 @@ TextField::setWordWrap(bool wrap)
     if (_wordWrap != wrap) {
         set_invalidated();
         _wordWrap = wrap;
-        format_text();
+        invalidateLayout();
     }
 }
 
@@ -2294,6 +2372,7 @@ TextField::setLeading(std::int16_t h)
     if (_leading != h) {
         set_invalidated();
         _leading = h;
+        _layoutEnd.reset();
     }
 }
 
@@ -2303,6 +2382,7 @@ TextField::setUnderlined(bool v)
     if (_underlined != v) {
         set_invalidated();
         _underlined = v;
+        _layoutEnd.reset();
     }
 }
 
@@ -2311,6 +2391,7 @@ TextField::setBullet(bool b)
 {              
     if (_bullet != b) {
         _bullet = b;
+        _layoutEnd.reset();
     }
 }
 
@@ -2324,6 +2405,7 @@ TextField::setTabStops(const std::vector<int>& tabStops)
 	}
 	
     set_invalidated();
+    _layoutEnd.reset();
 }
 
 void 
@@ -2332,6 +2414,7 @@ TextField::setURL(std::string url)
     if (_url != url) {
         set_invalidated();
         _url = url;
+        _layoutEnd.reset();
     }
 }
 
@@ -2341,6 +2424,7 @@ TextField::setTarget(std::string target)
     if (_target != target) {
         set_invalidated();
         _target = target;
+        _layoutEnd.reset();
     }
 }
 
@@ -2350,6 +2434,7 @@ TextField::setDisplay(TextFormatDisplay display)
     if (_display != display) {
         set_invalidated();
         _display = display;
+        _layoutEnd.reset();
     }
 }
 
@@ -2359,6 +2444,7 @@ TextField::setAlignment(TextAlignment h)
     if (_alignment != h) {
         set_invalidated();
         _alignment = h;
+        _layoutEnd.reset();
     }
 }
 
@@ -2368,6 +2454,7 @@ TextField::setIndent(std::uint16_t h)
     if (_indent != h) {
         set_invalidated();
         _indent = h;
+        _layoutEnd.reset();
     }
 }
 
@@ -2377,6 +2464,7 @@ TextField::setBlockIndent(std::uint16_t h)
     if (_blockIndent != h) {
         set_invalidated();
         _blockIndent = h;
+        _layoutEnd.reset();
     }
 }
 
@@ -2386,6 +2474,7 @@ TextField::setRightMargin(std::uint16_t h)
     if (_rightMargin != h) {
         set_invalidated();
         _rightMargin = h;
+        _layoutEnd.reset();
     }
 }
 
@@ -2395,6 +2484,7 @@ TextField::setLeftMargin(std::uint16_t h)
     if (_leftMargin != h) {
         set_invalidated();
         _leftMargin = h;
+        _layoutEnd.reset();
     }
 }
 
@@ -2404,6 +2494,7 @@ TextField::setFontHeight(std::uint16_t h)
     if (_fontHeight != h) {
         set_invalidated();
         _fontHeight = h;
+        _layoutEnd.reset();
     }
 }
 
@@ -2443,11 +2534,11 @@ TextField::setAutoSize(AutoSize val)
 
     set_invalidated();
     _autoSize = val; 
-    format_text();
+    invalidateLayout();
 }
 
 TextField::TextAlignment
-TextField::getTextAlignment()
+TextField::getTextAlignment() const
 {
     TextAlignment textAlignment = getAlignment(); 
 
@@ -2492,7 +2583,7 @@ TextField::handleFocus()
     m_has_focus = true;
 
     m_cursor = _text.size();
-    format_text();
+    invalidateLayout();
     return true;
 }
 
@@ -2504,7 +2595,7 @@ TextField::killFocus()
     if (!m_has_focus) return; 
     set_invalidated();
     m_has_focus = false;
-    format_text(); // is this needed ?
+    invalidateLayout(); // is this needed ?
 }
 
 void
@@ -2515,6 +2606,7 @@ TextField::setWidth(double newwidth)
             bounds.get_y_min(),
             bounds.get_x_min() + newwidth,
             bounds.get_y_max());
+    _layoutEnd.reset();
 }
 
 void
@@ -2525,6 +2617,7 @@ TextField::setHeight(double newheight)
             bounds.get_y_min(),
             bounds.get_x_max(),
             bounds.get_y_min() + newheight);
+    _layoutEnd.reset();
 }
 
 } // namespace gnash
@@ -20,6 +20,7 @@
 #define GNASH_TEXTFIELD_H
 
 #include <boost/intrusive_ptr.hpp>
+#include <boost/optional.hpp>
 #include <map>
 #include <string>
 #include <vector>
@@ -215,6 +216,7 @@ public:
 	/// Get bounding SWFRect of this TextField
 	virtual SWFRect getBounds() const
 	{
+		layout();
 		return _bounds;
 	}
 
@@ -313,6 +315,7 @@ public:
 	/// 	as (*)
     void password(bool b) {
         _password = b;
+        _layoutEnd.reset();
     }
 	/// \brief
 	/// Set whether this TextField should use embedded font glyphs,
@@ -328,7 +331,7 @@ public:
 	}
 
 	/// Return text TextAlignment
-    TextAlignment getTextAlignment();
+    TextAlignment getTextAlignment() const;
 
 	/// Set autoSize value 
 	//
@@ -401,6 +404,7 @@ public:
 	///	If true HTML tags in the text will be parsed and rendered
 	void setHtml(bool on) {
 		_html = on;
+		_layoutEnd.reset();
 	}
 
 	/// Return true if the TextField text is selectable
@@ -527,11 +531,13 @@ public:
 
 	size_t getScroll() const
 	{
+		layout();
 		return _scroll;
 	}
 
 	size_t getMaxScroll() const
 	{
+		layout();
 		return _maxScroll;
 	}
 
@@ -542,11 +548,13 @@ public:
 
 	size_t getMaxHScroll() const
 	{
+		layout();
 		return _maxHScroll;
 	}
 
 	size_t getBottomScroll() const
 	{
+		layout();
 		return _bottomScroll;
 	}
 
@@ -559,23 +567,19 @@ public:
 	void setDisplay(TextFormatDisplay display);
 	void setScroll(size_t scroll) {
 		_scroll = scroll;
-		format_text();
-	}
-	void setMaxScroll(size_t maxScroll) {
-		_maxScroll = maxScroll;
-		format_text();
+		invalidateLayout();
 	}
 	void setHScroll(size_t hScroll) {
 		_hScroll = hScroll;
-		format_text();
+		invalidateLayout();
 	}
 	void setMaxHScroll(size_t maxHScroll) {
 		_maxHScroll = maxHScroll;
-		format_text();
+		invalidateLayout();
 	}
 	void setbottomScroll(size_t bottomScroll) {
 		_bottomScroll = bottomScroll;
-		format_text();
+		invalidateLayout();
 	}
 
 	/// Returns the number of the record that the cursor is in
@@ -585,6 +589,7 @@ public:
 	void setTextFormat(TextFormat_as& tf);
 
 	const SWFRect& getTextBoundingBox() const {
+		layout();
 		return m_text_bounding_box;
 	}
 
@@ -608,7 +613,7 @@ private:
 
 	void updateHtmlText(const std::wstring& s);
 
-    void insertTab(SWF::TextRecord& rec, std::int32_t& x, float scale);
+    void insertTab(SWF::TextRecord& rec, std::int32_t& x, float scale) const;
 
 	/// What happens when setFocus() is called on this TextField.
     //
@@ -623,30 +628,53 @@ private:
 	void onChanged();
 
 	/// Reset our text bounding box to the given point.
-	void reset_bounding_box(std::int32_t x, std::int32_t y)
+	void reset_bounding_box(std::int32_t x, std::int32_t y) const
 	{
 		m_text_bounding_box.set_to_point(x, y);
 	}
 
 	/// Convert the DisplayObjects in _text into a series of
 	/// text_glyph_records to be rendered.
-	void format_text();
+	void format_text() const;
+
+	/// Lay out the text appended since the last layout.
+	//
+	/// This carries on from where the last layout stopped, so that
+	/// the lines above are not laid out again.
+	void formatAppendedText() const;
+
+	/// Lay out the text again before it is next used.
+	//
+	/// Setters call this instead of format_text(), so that setting
+	/// several properties only lays the text out once.
+	void invalidateLayout();
+
+	/// Lay out the text if it changed since it was last laid out.
+	//
+	/// This must be called before using the laid out text, its bounds
+	/// or the scroll values. The state written by the layout is mutable,
+	/// so that const getters can lay the text out.
+	void layout() const {
+		if (!_layoutPending) return;
+		if (_layoutEnd) formatAppendedText();
+		else format_text();
+	}
 	
 	/// Move viewable lines based on m_cursor
-	void scrollLines();
+	void scrollLines() const;
 	
 	/// Handles a new line, this will be called several times, so this
 	/// will hopefully make code cleaner
 	void newLine(std::int32_t& x, std::int32_t& y,
 				 SWF::TextRecord& rec, int& last_space_glyph,
-				 LineStarts::value_type& last_line_start_record, float div);
+				 LineStarts::value_type& last_line_start_record, float div) const;
 					
 	/// De-reference and do appropriate action for character iterator
 	void handleChar(std::wstring::const_iterator& it,
             const std::wstring::const_iterator& e, std::int32_t& x,
             std::int32_t& y, SWF::TextRecord& rec, int& last_code,
 		    int& last_space_glyph,
-            LineStarts::value_type& last_line_start_record);
+            LineStarts::value_type& last_line_start_record) const;
 	
 	/// Extracts an HTML tag.
 	///
@@ -668,7 +696,8 @@ private:
 	/// m_text_glyph_records[], starting with
 	/// last_line_start_record and going through the end of
 	/// m_text_glyph_records.
-	float align_line(TextAlignment align, int last_line_start_record, float x);
+	float align_line(TextAlignment align, int last_line_start_record,
+            float x) const;
 
 	/// Associate a variable to the text of this DisplayObject
 	//
@@ -721,12 +750,34 @@ private:
 	std::wstring _htmlText;
 
 	/// bounds of dynamic text, as laid out
-	SWFRect m_text_bounding_box;
+	mutable SWFRect m_text_bounding_box;
 
 	typedef std::vector<SWF::TextRecord> TextRecords;
-	TextRecords _textRecords;
+	mutable TextRecords _textRecords;
+
+	/// Where the last layout stopped.
+	//
+	/// Text appended to the laid out text can be laid out from there.
+	struct LayoutEnd
+	{
+		std::int32_t x;
+		std::int32_t y;
+		int lastCode;
+		int lastSpaceGlyph;
+		LineStarts::value_type lastLineStartRecord;
+
+		/// The length of the text laid out.
+		size_t textLength;
+	};
+
+	/// Set when the text was laid out up to its end, and only more
+	/// text was added since.
+	mutable boost::optional<LayoutEnd> _layoutEnd;
+
+	/// Whether the text must be laid out before it is next used.
+	mutable bool _layoutPending;
 
-	std::vector<size_t> _recordStarts;
+	mutable std::vector<size_t> _recordStarts;
 
 	TextRecords _displayRecords;
 
@@ -735,8 +786,8 @@ private:
 	std::string _restrict;
 	std::set<wchar_t> _restrictedchars;
 	TextFormatDisplay _display;
-	std::vector<int> _tabStops;
-	LineStarts _line_starts;
+	mutable std::vector<int> _tabStops;
+	mutable LineStarts _line_starts;
 
 	/// The text variable name
 	//
@@ -755,13 +806,13 @@ private:
 
 	boost::intrusive_ptr<const Font> _font;
 	size_t m_cursor;
-	size_t _glyphcount;
-	size_t _scroll;
-	size_t _maxScroll;
+	mutable size_t _glyphcount;
+	mutable size_t _scroll;
+	mutable size_t _maxScroll;
 	size_t _hScroll;
 	size_t _maxHScroll;
 	size_t _bottomScroll;
-	size_t _linesindisplay;
+	mutable size_t _linesindisplay;
 
     /// Corresponds to the maxChars property.
     size_t _maxChars;
@@ -776,24 +827,24 @@ private:
 	/// extended to fit text or hide text overflowing it.
 	/// See the setAutoSize() method to change that.
 	///
-	SWFRect _bounds;
+	mutable SWFRect _bounds;
 
     /// Represents the selected part of the text. The second element must
     /// never be less than the first.
     std::pair<size_t, size_t> _selection;
 
-    std::int16_t _leading;
-	std::uint16_t _indent;
+    mutable std::int16_t _leading;
+	mutable std::uint16_t _indent;
 
 	/// Indentation for every line (including the ones created by
 	/// effect of a word-wrap.
-	std::uint16_t _blockIndent;
+	mutable std::uint16_t _blockIndent;
 
-	std::uint16_t _leftMargin;
+	mutable std::uint16_t _leftMargin;
 
-	std::uint16_t _rightMargin;
+	mutable std::uint16_t _rightMargin;
 
-	std::uint16_t _fontHeight;
+	mutable std::uint16_t _fontHeight;
 
 	/// This flag will be true as soon as the TextField
 	/// is assigned a text value. Only way to be false is
@@ -83,7 +83,7 @@ bool
 Timer::expired(unsigned long now, unsigned long& elapsed)
 {
     if (cleared()) return false;
-    long unsigned expTime = _start + _interval;
+    long unsigned expTime = expiryTime();
     if (now < expTime) return false;
     elapsed = expTime-now;
     return true;
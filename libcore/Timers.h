@@ -126,6 +126,13 @@ public:
           return _start == std::numeric_limits<unsigned long>::max();
     }
 
+    /// Return the time, in milliseconds, at which the timer next expires
+    //
+    /// The return is meaningless if the timer has been cleared.
+    unsigned long expiryTime() const {
+        return _start + _interval;
+    }
+
     /// Execute associated function and reset state
     //
     /// After execution either the timer is cleared
@@ -47,7 +47,7 @@ namespace gnash {
 namespace {
     /// Find a variable in the given as_object
     //
-    /// @param varname
+    /// @param name
     /// Name of the local variable
     ///
     /// @param ret
@@ -55,29 +55,29 @@ namespace {
     /// Untouched if the variable is not found.
     ///
     /// @return true if the variable was found, false otherwise
-    bool getLocal(as_object& locals, const std::string& name, as_value& ret);
+    bool getLocal(as_object& locals, const ObjectURI& name, as_value& ret);
 
-    bool findLocal(as_object& locals, const std::string& varname, as_value& ret,
+    bool findLocal(as_object& locals, const ObjectURI& name, as_value& ret,
             as_object** retTarget);
 
     /// Delete a local variable
     //
-    /// @param varname
+    /// @param name
     /// Name of the local variable
     ///
     /// @return true if the variable was found and deleted, false otherwise
-    bool deleteLocal(as_object& locals, const std::string& varname);
+    bool deleteLocal(as_object& locals, const ObjectURI& name);
 
     /// Set a variable of the given object, if it exists.
     //
-    /// @param varname
+    /// @param name
     /// Name of the local variable
     ///
     /// @param val
     /// Value to assign to the variable
     ///
     /// @return true if the variable was found, false otherwise
-    bool setLocal(as_object& locals, const std::string& varname,
+    bool setLocal(as_object& locals, const ObjectURI& name,
         const as_value& val);
 
     as_object* getElement(as_object* obj, const ObjectURI& uri);
@@ -99,6 +99,12 @@ namespace {
 
     static bool validRawVariableName(const std::string& varname);
 
+    /// Return true if a variable name contains no path.
+    //
+    /// Most names, and nearly all constant pool names, are plain, and
+    /// can be looked up directly.
+    inline bool isPlainName(const std::string& varname);
+
 }
 
 as_value as_environment::undefVal;
@@ -289,6 +295,10 @@ as_value
 getVariable(const as_environment& env, const std::string& varname,
         const as_environment::ScopeStack& scope, as_object** retTarget)
 {
+    if (isPlainName(varname)) {
+        return getVariableRaw(env, varname, scope, retTarget);
+    }
+
     // Path lookup rigamarole.
     std::string path;
     std::string var;
@@ -332,6 +342,11 @@ setVariable(const as_environment& env, const std::string& varname,
         log_action(_("-------------- %s = %s"), varname, val);
     );
 
+    if (isPlainName(varname)) {
+        setVariableRaw(env, varname, val, scope);
+        return;
+    }
+
     // Path lookup rigamarole.
     std::string path;
     std::string var;
@@ -377,7 +392,7 @@ delVariable(const as_environment& ctx, const std::string& varname,
     }
 
     // Check locals for deletion.
-    if (vm.calling() && deleteLocal(vm.currentCall().locals(), varname)) {
+    if (vm.calling() && deleteLocal(vm.currentCall().locals(), varkey)) {
         return true;
     }
 
@@ -434,6 +449,12 @@ validRawVariableName(const std::string& varname)
     return (varname.find(":::") == std::string::npos);
 }
 
+inline bool
+isPlainName(const std::string& varname)
+{
+    return varname.find_first_of(":/.") == std::string::npos;
+}
+
 // No path rigamarole.
 void
 setVariableRaw(const as_environment& env, const std::string& varname,
@@ -462,7 +483,7 @@ setVariableRaw(const as_environment& env, const std::string& varname,
     
     const int swfVersion = vm.getSWFVersion();
     if (swfVersion < 6 && vm.calling()) {
-       if (setLocal(vm.currentCall().locals(), varname, val)) return;
+       if (setLocal(vm.currentCall().locals(), varkey, val)) return;
     }
     
     // TODO: shouldn't _target be in the scope chain ?
@@ -507,7 +528,7 @@ getVariableRaw(const as_environment& env, const std::string& varname,
     // Check locals for getting them
     // for SWF6 and up locals should be in the scope stack
     if (swfVersion < 6 && vm.calling()) {
-       if (findLocal(vm.currentCall().locals(), varname, val, retTarget)) {
+       if (findLocal(vm.currentCall().locals(), key, val, retTarget)) {
            return val;
        }
     }
@@ -571,17 +592,17 @@ getVariableRaw(const as_environment& env, const std::string& varname,
 }
 
 bool
-getLocal(as_object& locals, const std::string& name, as_value& ret)
+getLocal(as_object& locals, const ObjectURI& name, as_value& ret)
 {
-    return locals.get_member(getURI(getVM(locals), name), &ret);
+    return locals.get_member(name, &ret);
 }
 
 bool
-findLocal(as_object& locals, const std::string& varname, as_value& ret,
+findLocal(as_object& locals, const ObjectURI& name, as_value& ret,
         as_object** retTarget) 
 {
 
-    if (getLocal(locals, varname, ret)) {
+    if (getLocal(locals, name, ret)) {
         if (retTarget) *retTarget = &locals;
         return true;
     }
@@ -590,15 +611,15 @@ findLocal(as_object& locals, const std::string& varname, as_value& ret,
 }
 
 bool
-deleteLocal(as_object& locals, const std::string& varname)
+deleteLocal(as_object& locals, const ObjectURI& name)
 {
-    return locals.delProperty(getURI(getVM(locals), varname)).second;
+    return locals.delProperty(name).second;
 }
 
 bool
-setLocal(as_object& locals, const std::string& varname, const as_value& val)
+setLocal(as_object& locals, const ObjectURI& name, const as_value& val)
 {
-    Property* prop = locals.getOwnProperty(getURI(getVM(locals), varname));
+    Property* prop = locals.getOwnProperty(name);
     if (!prop) return false;
     prop->setValue(locals, val);
     return true;
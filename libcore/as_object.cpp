@@ -87,7 +87,7 @@ public:
     Property* getProperty(as_object** owner = nullptr) const {
 
         //assert(_object);
-        Property* prop = _object->_members.getProperty(_uri);
+        Property* prop = _object->getOwnProperty(_uri);
         
         if (prop && _condition(*prop)) {
             if (owner) *owner = _object;
@@ -283,7 +283,8 @@ as_object::as_object(const Global_as& gl)
     _displayObject(nullptr),
     _array(false),
     _vm(getVM(gl)),
-    _members(*this)
+    _members(*this),
+    _sparseElements(false)
 {
 }
 
@@ -293,7 +294,8 @@ as_object::as_object(VM& vm)
     _displayObject(nullptr),
     _array(false),
     _vm(vm),
-    _members(*this)
+    _members(*this),
+    _sparseElements(false)
 {
 }
 
@@ -312,6 +314,15 @@ as_object::stringValue() const
 std::pair<bool,bool>
 as_object::delProperty(const ObjectURI& uri)
 {
+    const int index = denseIndex(uri);
+    if (index >= 0) {
+        // Only the last element can go without leaving a hole.
+        if (static_cast<size_t>(index) + 1 == _elements.size()) {
+            _elements.pop_back();
+            return std::make_pair(true, true);
+        }
+        spreadElements();
+    }
     return _members.delProperty(uri);
 }
 
@@ -322,7 +333,9 @@ as_object::add_property(const std::string& name, as_function& getter,
 {
     const ObjectURI& uri = getURI(vm(), name);
 
-    Property* prop = _members.getProperty(uri);
+    Property* prop = getOwnProperty(uri);
+
+    addingProperty(uri, true);
 
     if (prop) {
         const as_value& cacheVal = prop->getCache();
@@ -379,6 +392,13 @@ as_object::get_member(const ObjectURI& uri, as_value* val)
 {
     //assert(val);
 
+    // Densely stored Array elements are visible own properties.
+    const as_value* element = findElement(uri);
+    if (element) {
+        *val = *element;
+        return true;
+    }
+
     const int version = getSWFVersion(*this);
 
     PrototypeRecursor<IsVisible> pr(this, uri, IsVisible(version));
@@ -520,6 +540,7 @@ as_object::set_prototype(const as_value& proto)
     // TODO: check what happens if __proto__ is set as a user-defined 
     // getter/setter
     // TODO: check triggers !!
+    addingProperty(NSV::PROP_uuPROTOuu);
     _members.setValue(NSV::PROP_uuPROTOuu, proto, as_object::DefaultFlags);
 }
 
@@ -594,6 +615,15 @@ as_object::set_member(const ObjectURI& uri, const as_value& val, bool ifFound)
     // call this function again if the key is a valid index.
     if (array()) checkArrayLength(*this, uri, val);
 
+    // Array elements are stored densely when possible.
+    if (array() || !_elements.empty()) {
+        const int index = _vm.getArrayIndex(uri);
+        if (index >= 0) {
+            const bool found = static_cast<size_t>(index) < _elements.size();
+            if ((found || !ifFound) && setElement(index, val)) return found;
+        }
+    }
+
     PrototypeRecursor<Exists> pr(this, uri);
 
     Property* prop = pr.getProperty();
@@ -646,6 +676,7 @@ as_object::set_member(const ObjectURI& uri, const as_value& val, bool ifFound)
     if (ifFound) return false;
         
     // Property does not exist, so it won't be read-only. Set it.
+    addingProperty(uri);
     if (!_members.setValue(uri, val)) {
             
         IF_VERBOSE_ASCODING_ERRORS(
@@ -677,6 +708,7 @@ as_object::init_member(const ObjectURI& uri, const as_value& val, int flags)
 {
 
     // Set (or create) a SimpleProperty 
+    addingProperty(uri);
     if (!_members.setValue(uri, val, flags)) {
         ObjectURI::Logger l(getStringTable(*this));
         log_error(_("Attempt to initialize read-only property '%s'"
@@ -698,6 +730,7 @@ void
 as_object::init_property(const ObjectURI& uri, as_function& getter,
                          as_function& setter, int flags)
 {
+    addingProperty(uri, true);
     _members.addGetterSetter(uri, getter, &setter, as_value(), flags);
 }
 
@@ -713,6 +746,7 @@ void
 as_object::init_property(const ObjectURI& uri, as_c_function_ptr getter,
                          as_c_function_ptr setter, int flags)
 {
+    addingProperty(uri, true);
     _members.addGetterSetter(uri, getter, setter, flags);
 }
 
@@ -720,6 +754,7 @@ bool
 as_object::init_destructive_property(const ObjectURI& uri, as_function& getter,
                                      int flags)
 {
+    addingProperty(uri, true);
     return _members.addDestructiveGetter(uri, getter, flags);
 }
 
@@ -727,6 +762,7 @@ bool
 as_object::init_destructive_property(const ObjectURI& uri,
                                      as_c_function_ptr getter, int flags)
 {
+    addingProperty(uri, true);
     return _members.addDestructiveGetter(uri, getter, flags);
 }
 
@@ -752,6 +788,7 @@ as_object::init_readonly_property(const std::string& name,
 void
 as_object::set_member_flags(const ObjectURI& uri, int setTrue, int setFalse)
 {
+    if (denseIndex(uri) >= 0) spreadElements();
     _members.setFlags(uri, setTrue, setFalse);
 }
 
@@ -854,6 +891,12 @@ as_object::dump_members()
     log_debug("%d members of object %p follow", _members.size(),
             static_cast<const void*>(this));
     _members.dump();
+
+    if (_elements.empty()) return;
+    log_debug("%d densely stored elements follow", _elements.size());
+    for (size_t i = 0; i < _elements.size(); ++i) {
+        log_debug("  %d: %s", i, _elements[i]);
+    }
 }
 
 void
@@ -862,6 +905,7 @@ as_object::setPropFlags(const as_value& props_val, int set_false, int set_true)
 
     if (props_val.is_null()) {
         // Take all the members of the object
+        if (!_elements.empty()) spreadElements();
         _members.setFlagsAll(set_true, set_false);
         return;
     }
@@ -917,6 +961,11 @@ as_object::visitKeys(KeyVisitor& visitor) const
     const as_object* current(this);
     while (current && visited.insert(current).second) {
         current->_members.visitKeys(visitor, doneList);
+
+        for (size_t i = 0; i < current->_elements.size(); ++i) {
+            const ObjectURI uri = _vm.getIndexURI(i);
+            if (doneList.insert(uri).second) visitor(uri);
+        }
         current = current->get_prototype();
     }
 }
@@ -925,9 +974,96 @@ as_object::visitKeys(KeyVisitor& visitor) const
 Property*
 as_object::getOwnProperty(const ObjectURI& uri)
 {
+    if (denseIndex(uri) >= 0) spreadElements();
     return _members.getProperty(uri);
 }
 
+void
+as_object::setArray(bool array)
+{
+    // Only arrays keep elements densely.
+    if (!array && !_elements.empty()) spreadElements();
+    _array = array;
+}
+
+bool
+as_object::setElement(size_t index, const as_value& val)
+{
+    // Watched objects need the full set_member() treatment.
+    if (_trigs.get()) return false;
+
+    if (index < _elements.size()) {
+        _elements[index] = val;
+        return true;
+    }
+
+    // An element can only be appended if there is no property or
+    // inherited setter with its name.
+    if (index != _elements.size() || !array() || _sparseElements ||
+            _vm.indexGetterSetters()) {
+        return false;
+    }
+    _elements.push_back(val);
+    return true;
+}
+
+std::vector<as_value>*
+as_object::denseElements(size_t size)
+{
+    if (!array() || _sparseElements || _trigs.get() ||
+            _vm.indexGetterSetters() || _elements.size() != size) {
+        return nullptr;
+    }
+    return &_elements;
+}
+
+int
+as_object::denseIndex(const ObjectURI& uri) const
+{
+    if (_elements.empty()) return -1;
+    const int index = _vm.getArrayIndex(uri);
+    if (index < 0 || static_cast<size_t>(index) >= _elements.size()) {
+        return -1;
+    }
+    return index;
+}
+
+void
+as_object::spreadElements()
+{
+    _sparseElements = true;
+
+    std::vector<as_value> elements;
+    elements.swap(_elements);
+
+    for (size_t i = 0; i < elements.size(); ++i) {
+        _members.setValue(_vm.getIndexURI(i), elements[i]);
+    }
+}
+
+void
+as_object::addingProperty(const ObjectURI& uri, bool getterSetter)
+{
+    if (_vm.getArrayIndex(uri) >= 0) {
+        _sparseElements = true;
+        if (getterSetter) _vm.addIndexGetterSetter();
+    }
+
+    // A new property is enumerated after the elements, which only works
+    // if they are normal properties too.
+    if (!_elements.empty() && !_members.getProperty(uri)) spreadElements();
+}
+
+void
+as_object::visitElements(PropertyVisitor& visitor) const
+{
+    // The visitor may change the elements, so no iterator is kept.
+    for (size_t i = 0; i < _elements.size(); ++i) {
+        const as_value val = _elements[i];
+        if (!visitor.accept(_vm.getIndexURI(i), val)) return;
+    }
+}
+
 as_object*
 as_object::get_prototype() const
 {
@@ -1012,6 +1148,10 @@ as_object::markReachableResources() const
 {
     _members.setReachable();
 
+    for (const as_value& element : _elements) {
+        element.setReachable();
+    }
+
     if (_trigs.get()) {
         for (TriggerContainer::const_iterator it = _trigs->begin();
              it != _trigs->end(); ++it) {
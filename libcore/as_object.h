@@ -452,6 +452,9 @@ public:
     /// Get this object's own named property, if existing.
     //
     /// This function does *not* recurse in this object's prototype.
+    /// Array elements stored densely are turned into normal properties
+    /// first, so prefer the free getOwnProperty() when only the value is
+    /// needed.
     //
     /// @param uri      Property identifier. 
     /// @return         A Property pointer, or NULL if this object doesn't
@@ -532,6 +535,8 @@ public:
     /// Drop all properties from this object
     void clearProperties() {
         _members.clear();
+        _elements.clear();
+        _sparseElements = false;
     }
 
     /// Visit the properties of this object by key/as_value pairs
@@ -545,7 +550,8 @@ public:
     ///                 a const as_value as second argument.
     template<typename T>
     void visitProperties(PropertyVisitor& visitor) const {
-        _members.visitValues<T>(visitor);
+        if (!_members.visitValues<T>(visitor)) return;
+        visitElements(visitor);
     }
 
     /// Visit all visible property identifiers.
@@ -627,10 +633,52 @@ public:
     }
 
     /// Set whether this object should be treated as an array.
-    void setArray(bool array = true) {
-        _array = array;
+    void setArray(bool array = true);
+
+    /// Return an element kept in an Array's dense storage.
+    //
+    /// Arrays whose elements are added in index order keep them in a
+    /// vector rather than as normal properties, which makes access much
+    /// cheaper. This is invisible to ActionScript.
+    //
+    /// @param index    The index of the element.
+    /// @return         The element, or null if it isn't stored densely. It
+    ///                 may still exist as a normal property.
+    const as_value* getElement(size_t index) const {
+        return index < _elements.size() ? &_elements[index] : nullptr;
+    }
+
+    /// Return an element kept in an Array's dense storage, by name.
+    //
+    /// @param uri      The name of the element.
+    /// @return         The element, or null if it isn't stored densely.
+    const as_value* findElement(const ObjectURI& uri) const {
+        if (_elements.empty()) return nullptr;
+        const int index = denseIndex(uri);
+        return index < 0 ? nullptr : &_elements[index];
     }
 
+    /// Set an element in an Array's dense storage.
+    //
+    /// This does what set_member() would do, except that the length of
+    /// the Array is not updated.
+    //
+    /// @return         false if the element can't be stored densely. Nothing
+    ///                 is done then; use set_member() instead.
+    bool setElement(size_t index, const as_value& val);
+
+    /// Access an Array's dense storage to change it in place.
+    //
+    /// This is only possible when the first size elements are all stored
+    /// densely, and changing them can't run any ActionScript (no watches
+    /// or setters). The elements can then be added, removed or moved
+    /// around freely.
+    //
+    /// @param size     The length of the Array.
+    /// @return         The elements, or null if they can't be changed in
+    ///                 place.
+    std::vector<as_value>* denseElements(size_t size);
+
     /// Return the DisplayObject associated with this object.
     //
     /// @return     A DisplayObject if this is as_object is associated with
@@ -685,6 +733,25 @@ private:
     void executeTriggers(Property* prop, const ObjectURI& uri,
             const as_value& val);
 
+    /// Return the index of an element stored densely, or -1.
+    int denseIndex(const ObjectURI& uri) const;
+
+    /// Move the densely stored elements to the normal properties.
+    //
+    /// This is done whenever the elements stop being simple values that
+    /// are enumerated last, in index order. They then stay normal
+    /// properties.
+    void spreadElements();
+
+    /// Keep the dense storage consistent before a property is added.
+    //
+    /// @param uri          The name of the property.
+    /// @param getterSetter Whether the property is a getter-setter.
+    void addingProperty(const ObjectURI& uri, bool getterSetter = false);
+
+    /// Visit the densely stored elements, as visitProperties() does.
+    void visitElements(PropertyVisitor& visitor) const;
+
     /// A utility class for processing this as_object's inheritance chain
     template<typename T> class PrototypeRecursor;
 
@@ -715,6 +782,17 @@ private:
     /// Properties of this as_object
     PropertyList _members;
 
+    /// The elements 0 to n-1 of an Array, when stored densely.
+    //
+    /// They have no flags, and none of them is also in _members. They
+    /// come after all of _members in enumeration order.
+    std::vector<as_value> _elements;
+
+    /// Whether _members may contain Array elements.
+    //
+    /// No elements are stored densely in this case.
+    bool _sparseElements;
+
     /// The constructors of the objects implemented by this as_object.
     //
     /// There is no need to use a complex container as the list of 
@@ -776,6 +854,9 @@ getMember(as_object& o, const ObjectURI& uri)
 inline as_value
 getOwnProperty(as_object& o, const ObjectURI& uri)
 {
+    const as_value* el = o.findElement(uri);
+    if (el) return *el;
+
     Property* p = o.getOwnProperty(uri);
     return p ? p->getValue(o) : as_value();
 }
@@ -853,6 +934,7 @@ get(as_object* o)
 inline bool
 hasOwnProperty(as_object& o, const ObjectURI& uri)
 {
+    if (o.findElement(uri)) return true;
     return (o.getOwnProperty(uri));
 }
 
@@ -22,11 +22,11 @@
 
 #include <cmath> 
 #include <cctype> 
+#include <cstdio>
+#include <clocale>
 #include <boost/lexical_cast.hpp>
 #include <boost/format.hpp>
-#include <locale>
 #include <sstream>
-#include <iomanip>
 #include <string>
 #include <algorithm>
 
@@ -198,13 +198,79 @@ parseDecimalNumber(std::string::const_iterator start,
     return boost::lexical_cast<double>(std::string(start, last));
 }
 
+/// Convert a plain decimal number without going through a stream.
+//
+/// Only numbers made of an optional minus sign, digits and an optional
+/// fraction, with no more than 15 digits, are handled. This covers most
+/// numbers found in movies, and gives the exact result: both the digits
+/// and the power of ten are exact doubles, so the division is correctly
+/// rounded.
+//
+/// @return     false if the string is not such a number, in which case
+///             d is left untouched.
+bool
+parseSimpleNumber(std::string::const_iterator start,
+        std::string::const_iterator last, double& d)
+{
+    static const double powersOfTen[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8,
+        1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15
+    };
+    const size_t maxDigits = 15;
+
+    const bool negative = (*start == '-');
+    if (negative) ++start;
+
+    std::uint64_t digits = 0;
+    size_t count = 0;
+    size_t decimals = 0;
+    bool fraction = false;
+
+    for (; start != last; ++start) {
+        const char c = *start;
+        if (c >= '0' && c <= '9') {
+            if (++count > maxDigits) return false;
+            digits = digits * 10 + (c - '0');
+            if (fraction) ++decimals;
+        }
+        else if (c == '.' && !fraction && count) {
+            fraction = true;
+        }
+        else return false;
+    }
+
+    // A fraction needs digits on both sides of the point.
+    if (!count || (fraction && !decimals)) return false;
+
+    d = digits / powersOfTen[decimals];
+    if (negative) d = -d;
+    return true;
+}
+
+/// Format a number with snprintf, using a dot as the decimal point.
+std::string
+formatNumber(const char* format, double val)
+{
+    char buf[64];
+    std::snprintf(buf, sizeof buf, format, val);
+    std::string str(buf);
+
+    // ActionScript always expects dot as decimal point.
+    const std::string point = std::localeconv()->decimal_point;
+    if (point != ".") {
+        const std::string::size_type pos = str.find(point);
+        if (pos != std::string::npos) str.replace(pos, point.size(), ".");
+    }
+    return str;
+}
+
 } // anonymous namespace
 
 // Conversion to const std::string&.
 std::string
 as_value::to_string(int version) const
 {
-    switch (_type)
+    switch (type())
     {
         case STRING:
             return getStr();
@@ -227,7 +293,7 @@ as_value::to_string(int version) const
         {
             as_object* obj = getObj();
             String_as* s;
-            if (isNativeType(obj, s)) return s->value();
+            if (isNativeType(obj, s)) return s->value().getStringChars();
 
             try {
                 as_value ret = to_primitive(STRING);
@@ -251,7 +317,7 @@ as_value::to_string(int version) const
 as_value::AsType
 as_value::defaultPrimitive(int version) const
 {
-    if (_type == OBJECT && version > 5) {
+    if (type() == OBJECT && version > 5) {
         Date_as* d;
         if (isNativeType(getObj(), d)) return STRING;
     }
@@ -262,7 +328,7 @@ as_value::defaultPrimitive(int version) const
 as_value
 as_value::to_primitive(AsType hint) const
 {
-    if (_type != OBJECT) return *this; 
+    if (type() != OBJECT) return *this; 
 
 #if GNASH_DEBUG_CONVERSION_TO_PRIMITIVE
     log_debug("to_primitive(%s)", hint==NUMBER ? "NUMBER" : "STRING");
@@ -274,7 +340,7 @@ as_value::to_primitive(AsType hint) const
     as_object* obj(nullptr);
 
     if (hint == NUMBER) {
-        //assert(_type == OBJECT);
+        //assert(type() == OBJECT);
         obj = getObj();
 
         if (!findMethod(*obj, NSV::PROP_VALUE_OF, method)) {
@@ -287,7 +353,7 @@ as_value::to_primitive(AsType hint) const
     }
     else {
         //assert(hint == STRING);
-        //assert(_type == OBJECT);
+        //assert(type() == OBJECT);
         obj = getObj();
 
         // @@ Moock says, "the value that results from
@@ -308,7 +374,7 @@ as_value::to_primitive(AsType hint) const
     log_debug("to_primitive: method call returned %s", ret);
 #endif
 
-    if (ret._type == OBJECT) {
+    if (ret.type() == OBJECT) {
         throw ActionTypeError();
     }
     return ret;
@@ -318,7 +384,7 @@ double
 as_value::to_number(const int version) const
 {
 
-    switch (_type) {
+    switch (type()) {
         case STRING:
         {
             const std::string& s = getStr();
@@ -353,6 +419,9 @@ as_value::to_number(const int version) const
                     s.find_first_not_of(" \r\n\t");
 
                 if (pos == std::string::npos) return NaN;
+
+                double d;
+                if (parseSimpleNumber(s.begin() + pos, s.end(), d)) return d;
                 
                 // Will throw a boost::bad_lexical_cast if it fails.
                 return parseDecimalNumber(s.begin() + pos, s.end());
@@ -422,7 +491,7 @@ as_value::to_number(const int version) const
 bool
 as_value::to_bool(const int version) const
 {
-    switch (_type)
+    switch (type())
     {
         case STRING:
         {
@@ -443,7 +512,7 @@ as_value::to_bool(const int version) const
         case DISPLAYOBJECT:
             return true;
         default:
-            //assert(_type == UNDEFINED || _type == NULLTYPE || is_exception());
+            //assert(type() == UNDEFINED || type() == NULLTYPE || is_exception());
             return false;
     }
 }
@@ -453,7 +522,7 @@ as_object*
 as_value::to_object(VM& vm) const
 {
 
-    switch (_type)
+    switch (type())
     {
         case OBJECT:
             return getObj();
@@ -462,7 +531,8 @@ as_value::to_object(VM& vm) const
             return getObject(toDisplayObject());
 
         case STRING:
-            return constructObject(vm, getStr(), NSV::CLASS_STRING);
+            // The String object shares the characters of this value.
+            return constructObject(vm, *this, NSV::CLASS_STRING);
 
         case NUMBER:
             return constructObject(vm, getNum(), NSV::CLASS_NUMBER);
@@ -479,7 +549,7 @@ as_value::to_object(VM& vm) const
 MovieClip*
 as_value::toMovieClip(bool allowUnloaded) const
 {
-    if (_type != DISPLAYOBJECT) return nullptr;
+    if (type() != DISPLAYOBJECT) return nullptr;
 
     DisplayObject *ch = getCharacter(allowUnloaded);
     if (!ch) return nullptr;
@@ -489,7 +559,7 @@ as_value::toMovieClip(bool allowUnloaded) const
 DisplayObject*
 as_value::toDisplayObject(bool allowUnloaded) const
 {
-    if (_type != DISPLAYOBJECT) return nullptr;
+    if (type() != DISPLAYOBJECT) return nullptr;
     return getCharacter(allowUnloaded);
 }
 
@@ -498,7 +568,7 @@ as_value::toDisplayObject(bool allowUnloaded) const
 as_function*
 as_value::to_function() const
 {
-    if (_type == OBJECT) {
+    if (type() == OBJECT) {
         return getObj()->to_function();
     }
 
@@ -508,13 +578,14 @@ as_value::to_function() const
 as_object*
 as_value::get_object() const
 {
-    if (_type == OBJECT) {
+    if (type() == OBJECT) {
         return getObj();
     }
 
     return nullptr;
 }
 
+#ifndef GNASH_COMPACT_AS_VALUE
 void
 as_value::set_undefined()
 {
@@ -551,12 +622,51 @@ as_value::set_as_object(as_object* obj)
     }
 }
 
+#else
+void
+as_value::set_undefined()
+{
+    release();
+    _bits = tagged(TAG_UNDEFINED);
+}
+
+void
+as_value::set_null()
+{
+    release();
+    _bits = tagged(TAG_NULL);
+}
+
+void
+as_value::set_as_object(as_object* obj)
+{
+    if (!obj)
+    {
+        set_null();
+        return;
+    }
+    if (obj->displayObject()) {
+        // The static cast is fine as long as the as_object is genuinely
+        // a DisplayObject.
+        Shared* proxy = new SharedProxy(
+                CharacterProxy(obj->displayObject(), getRoot(*obj)));
+        release();
+        _bits = tagged(TAG_DISPLAYOBJECT, proxy);
+        return;
+    }
+
+    release();
+    _bits = tagged(TAG_OBJECT, static_cast<const void*>(obj));
+}
+
+#endif
+
 bool
 as_value::equals(const as_value& v, int version) const
 {
 
     // First compare values of the same type.
-    if (_type == v._type) return equalsSameType(v);
+    if (type() == v.type()) return equalsSameType(v);
     
     // Then compare booleans.
     if (is_bool()) return compareBoolean(*this, v, version);
@@ -611,7 +721,7 @@ as_value::equals(const as_value& v, int version) const
 const char*
 as_value::typeOf() const
 {
-    switch (_type)
+    switch (type())
     {
         case UNDEFINED:
             return "undefined"; 
@@ -649,18 +759,22 @@ as_value::typeOf() const
 bool
 as_value::equalsSameType(const as_value& v) const
 {
-    //assert(_type == v._type);
+    //assert(type() == v.type());
 
-    switch (_type)
+    switch (type())
     {
         case UNDEFINED:
         case NULLTYPE:
             return true;
 
         case OBJECT:
+            return getObj() == v.getObj();
+
         case BOOLEAN:
+            return getBool() == v.getBool();
+
         case STRING:
-            return _value == v._value;
+            return getStr() == v.getStr();
 
         case DISPLAYOBJECT:
             return toDisplayObject() == v.toDisplayObject(); 
@@ -683,14 +797,14 @@ as_value::equalsSameType(const as_value& v) const
 bool
 as_value::strictly_equals(const as_value& v) const
 {
-    if ( _type != v._type ) return false;
+    if ( type() != v.type() ) return false;
     return equalsSameType(v);
 }
 
 void
 as_value::setReachable() const
 {
-    switch (_type)
+    switch (type())
     {
         case OBJECT:
         {
@@ -708,6 +822,7 @@ as_value::setReachable() const
     }
 }
 
+#ifndef GNASH_COMPACT_AS_VALUE
 as_object*
 as_value::getObj() const
 {
@@ -722,17 +837,44 @@ as_value::getCharacterProxy() const
     return boost::get<CharacterProxy>(_value);
 }
 
+#else
+as_object*
+as_value::getObj() const
+{
+    //assert(type() == OBJECT);
+    return static_cast<as_object*>(pointer());
+}
+
+CharacterProxy
+as_value::getCharacterProxy() const
+{
+    //assert(type() == DISPLAYOBJECT);
+    return static_cast<const SharedProxy*>(shared())->proxy;
+}
+
+#endif
+
 DisplayObject*
 as_value::getCharacter(bool allowUnloaded) const
 {
     return getCharacterProxy().get(allowUnloaded);
 }
 
+#ifndef GNASH_COMPACT_AS_VALUE
+std::shared_ptr<const DecodedString>*
+as_value::getDecodedCache() const
+{
+    assert(type() == STRING);
+    const std::shared_ptr<const SharedString>* shared =
+        boost::get<std::shared_ptr<const SharedString> >(&_value);
+    return shared ? &(*shared)->decoded : nullptr;
+}
+
 void
 as_value::set_string(const std::string& str)
 {
     _type = STRING;
-    _value = str;
+    _value = stringValue(str);
 }
 
 void
@@ -749,10 +891,74 @@ as_value::set_bool(bool val)
     _value = val;
 }
 
+#else
+std::shared_ptr<const DecodedString>*
+as_value::getDecodedCache() const
+{
+    assert(type() == STRING);
+    return &static_cast<const SharedString*>(shared())->decoded;
+}
+
+void
+as_value::set_string(const std::string& str)
+{
+    // Make the new string first, as str may belong to this value.
+    Shared* shared = new SharedString(str);
+    release();
+    _bits = tagged(TAG_STRING, shared);
+}
+
+void
+as_value::set_double(double val)
+{
+    release();
+    _bits = numberBits(val);
+}
+
+void
+as_value::set_bool(bool val)
+{
+    release();
+    _bits = tagged(TAG_BOOLEAN, static_cast<std::uint64_t>(val));
+}
+
+/// A thrown value.
+struct as_value::Thrown : as_value::Shared
+{
+    explicit Thrown(as_value v) : value(std::move(v)) {}
+    const as_value value;
+};
+
+as_value::AsType
+as_value::thrownType() const
+{
+    const AsType t = static_cast<const Thrown*>(shared())->value.type();
+    return static_cast<AsType>(static_cast<int>(t) + 1);
+}
+
+void
+as_value::flag_exception()
+{
+    if (is_exception()) return;
+
+    // Moving leaves this value undefined, so there is nothing to release.
+    Shared* thrown = new Thrown(std::move(*this));
+    _bits = tagged(TAG_EXCEPTION, thrown);
+}
+
+void
+as_value::unflag_exception()
+{
+    if (!is_exception()) return;
+    *this = as_value(static_cast<const Thrown*>(shared())->value);
+}
+
+#endif
+
 bool
 as_value::is_function() const
 {
-    return _type == OBJECT && getObj()->to_function();
+    return type() == OBJECT && getObj()->to_function();
 }
 
 bool
@@ -761,10 +967,10 @@ as_value::writeAMF0(amf::Writer& w) const
 
     assert (!is_exception());
 
-    switch (_type)
+    switch (type())
     {
         default:
-            log_unimpl(_("serialization of as_value of type %d"), _type);
+            log_unimpl(_("serialization of as_value of type %d"), type());
             return false;
 
         case OBJECT:
@@ -871,23 +1077,31 @@ doubleToString(double val, int radix)
 
     if (val == 0.0 || val == -0.0) return "0"; 
 
-    std::ostringstream ostr;
-
     if (radix == 10) {
 
-        // ActionScript always expects dot as decimal point.
-        ostr.imbue(std::locale::classic()); 
-        
+        // Integers of up to 15 digits are printed in full, so they
+        // can be formatted directly.
+        if (std::abs(val) < 1e15 && val == std::floor(val)) {
+            char buf[16];
+            char* end = buf + sizeof buf;
+            char* p = end;
+            std::uint64_t n = static_cast<std::uint64_t>(std::abs(val));
+            do {
+                *--p = '0' + n % 10;
+                n /= 10;
+            } while (n);
+            if (val < 0) *--p = '-';
+            return std::string(p, end);
+        }
+
         // force to decimal notation for this range (because the
         // reference player does)
         if (std::abs(val) < 0.0001 && std::abs(val) >= 0.00001) {
 
             // All nineteen digits (4 zeros + up to 15 significant digits)
-            ostr << std::fixed << std::setprecision(19) << val;
-            
-            std::string str = ostr.str();
+            std::string str = formatNumber("%.19f", val);
             
-            // Because 'fixed' also adds trailing zeros, remove them.
+            // Because %f also adds trailing zeros, remove them.
             std::string::size_type pos = str.find_last_not_of('0');
             if (pos != std::string::npos) {
                 str.erase(pos + 1);
@@ -895,9 +1109,7 @@ doubleToString(double val, int radix)
             return str;
         }
 
-        ostr << std::setprecision(15) << val;
-        
-        std::string str = ostr.str();
+        std::string str = formatNumber("%.15g", val);
         
         // Remove a leading zero from 2-digit exponent if any
         std::string::size_type pos = str.find("e", 0);
@@ -1034,7 +1246,7 @@ std::ostream&
 operator<<(std::ostream& o, const as_value& v)
 {
 
-    switch (v._type)
+    switch (v.type())
     {
         case as_value::UNDEFINED:
             return o << "[undefined]";
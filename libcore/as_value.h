@@ -20,11 +20,15 @@
 #define GNASH_AS_VALUE_H
 
 #include <limits>
+#include <memory>
 #include <string>
 #include <boost/variant.hpp>
 #include <iosfwd> // for inlined output operator
 #include <type_traits>
 #include <cstdint>
+#ifdef GNASH_COMPACT_AS_VALUE
+# include <cstring>
+#endif
 
 #include "dsodefs.h" // for DSOTEXPORT
 #include "CharacterProxy.h"
@@ -40,6 +44,7 @@ namespace gnash {
 	class as_function;
 	class MovieClip;
 	class DisplayObject;
+    class DecodedString;
     namespace amf {
         class Writer;
     }
@@ -115,6 +120,7 @@ public:
         DISPLAYOBJECT_EXCEPT
     };
     
+#ifndef GNASH_COMPACT_AS_VALUE
     /// Construct an undefined value
     DSOEXPORT as_value()
         :
@@ -145,14 +151,14 @@ public:
     DSOEXPORT as_value(const char* str)
         :
         _type(STRING),
-        _value(std::string(str))
+        _value(stringValue(str))
     {}
 
     /// Construct a primitive String value 
     DSOEXPORT as_value(std::string str)
         :
         _type(STRING),
-        _value(std::move(str))
+        _value(stringValue(std::move(str)))
     {}
     
     /// Construct a primitive Boolean value
@@ -194,6 +200,89 @@ public:
         other._type = UNDEFINED;
         return *this;
     }
+#else
+    /// Construct an undefined value
+    DSOEXPORT as_value()
+        :
+        _bits(tagged(TAG_UNDEFINED))
+    {
+    }
+    
+    /// Copy constructor.
+    DSOEXPORT as_value(const as_value& v)
+        :
+        _bits(v._bits)
+    {
+        retain();
+    }
+
+    /// Move constructor.
+    DSOEXPORT as_value(as_value&& other)
+        :
+        _bits(other._bits)
+    {
+        other._bits = tagged(TAG_UNDEFINED);
+    }
+
+    ~as_value() {
+        release();
+    }
+    
+    /// Construct a primitive String value 
+    DSOEXPORT as_value(const char* str)
+        :
+        _bits(tagged(TAG_STRING, new SharedString(str)))
+    {}
+
+    /// Construct a primitive String value 
+    DSOEXPORT as_value(std::string str)
+        :
+        _bits(tagged(TAG_STRING, new SharedString(std::move(str))))
+    {}
+    
+    /// Construct a primitive Boolean value
+    template <typename T, typename U =
+        typename std::enable_if<std::is_same<bool, T>::value>::type>
+    as_value(T val)
+        :
+        _bits(tagged(TAG_BOOLEAN, static_cast<std::uint64_t>(val)))
+    {}
+
+    /// Construct a primitive Number value
+    as_value(double num)
+        :
+        _bits(numberBits(num))
+    {}
+    
+    /// Construct a null, Object, or DisplayObject value
+    as_value(as_object* obj)
+        :
+        _bits(tagged(TAG_UNDEFINED))
+    {
+        set_as_object(obj);
+    }
+    
+    /// Assign to an as_value.
+    DSOEXPORT as_value& operator=(const as_value& v)
+    {
+        // Retain first, in case this is a self-assignment.
+        v.retain();
+        release();
+        _bits = v._bits;
+        return *this;
+    }
+
+    DSOEXPORT as_value& operator=(as_value&& other)
+    {
+        if (this != &other) {
+            release();
+            _bits = other._bits;
+            other._bits = tagged(TAG_UNDEFINED);
+        }
+        return *this;
+    }
+
+#endif
 
     friend std::ostream& operator<<(std::ostream& o, const as_value&);
     
@@ -205,24 +294,25 @@ public:
     
     /// Return true if this value is a string
     bool is_string() const {
-        return _type == STRING;
+        return type() == STRING;
     }
     
     /// Return true if this value is strictly a number
     bool is_number() const {
-        return _type == NUMBER;
+        return type() == NUMBER;
     }
     
     /// Return true if this value is an object
     //
     /// Both DisplayObjects and Objects count as Objects
     bool is_object() const {
-        return _type == OBJECT || _type == DISPLAYOBJECT;
+        const AsType t = type();
+        return t == OBJECT || t == DISPLAYOBJECT;
     }
     
     /// Return true if this value is a DISPLAYOBJECT 
     bool is_sprite() const {
-        return _type == DISPLAYOBJECT;
+        return type() == DISPLAYOBJECT;
     }
     
     /// Get a std::string representation for this value.
@@ -267,6 +357,26 @@ public:
     /// is not an object.
     as_object* get_object() const;
     
+    /// Return the characters of a String value without copying them.
+    //
+    /// The caller must check that this value is a String. The reference
+    /// is only valid as long as the value is.
+    const std::string& getStringChars() const {
+        return getStr();
+    }
+
+    /// Return where the decoded characters of a String value are kept.
+    //
+    /// Copies of a long String share its characters, and the String
+    /// methods (see String_as.cpp) keep their decoded form with them
+    /// rather than decoding the characters on every call. Short strings
+    /// are not shared, so they have nowhere to keep it.
+    ///
+    /// The caller must check that this value is a String.
+    ///
+    /// @return     The cache, or 0 if the characters are not shared.
+    std::shared_ptr<const DecodedString>* getDecodedCache() const;
+
     /// Returns value as a MovieClip if it is a MovieClip.
     //
     /// This function performs no conversion, so returns 0 if the as_value is
@@ -334,17 +444,18 @@ public:
     void set_null();
     
     bool is_undefined() const {
-        return (_type == UNDEFINED);
+        return (type() == UNDEFINED);
     }
     
     bool is_null() const {
-        return (_type == NULLTYPE);
+        return (type() == NULLTYPE);
     }
     
     bool is_bool() const {
-        return (_type == BOOLEAN);
+        return (type() == BOOLEAN);
     }
     
+#ifndef GNASH_COMPACT_AS_VALUE
     bool is_exception() const {
         return (_type == UNDEFINED_EXCEPT || _type == NULLTYPE_EXCEPT
                 || _type == BOOLEAN_EXCEPT || _type == NUMBER_EXCEPT
@@ -365,6 +476,17 @@ public:
             _type = static_cast<AsType>(static_cast<int>(_type) - 1);
         }
     }
+#else
+    bool is_exception() const {
+        return _bits >= tagged(TAG_EXCEPTION);
+    }
+    
+    // Flag or unflag an as_value as an exception -- this gets flagged
+    // when an as_value is 'thrown'.
+    void flag_exception();
+    
+    void unflag_exception();
+#endif
     
     /// Return true if this value is strictly equal to the given one
     //
@@ -410,6 +532,7 @@ public:
 
 private:
 
+#ifndef GNASH_COMPACT_AS_VALUE
     /// AsValueType handles the following AS types:
     //
     /// 1. undefined / null
@@ -418,14 +541,179 @@ private:
     /// 4. Object
     /// 5. MovieClip
     /// 6. String
+    //
+    /// Strings are immutable. Long ones are shared between copies of a
+    /// value, so that copying it does not copy the characters; short ones
+    /// fit in a std::string without allocating and are kept as such.
+    struct SharedString;
+
     typedef boost::variant<boost::blank,
                            double,
                            bool,
                            as_object*,
                            CharacterProxy,
-                           std::string>
+                           std::string,
+                           std::shared_ptr<const SharedString> >
     AsValueType;
+
+    /// The characters of a long String, shared by its copies.
+    struct SharedString
+    {
+        explicit SharedString(std::string s) : str(std::move(s)) {}
+        const std::string str;
+
+        /// The decoded characters, see getDecodedCache().
+        mutable std::shared_ptr<const DecodedString> decoded;
+    };
+
+    /// Strings longer than this are shared.
+    //
+    /// This is the usual capacity of a std::string without allocation.
+    static const size_t sharedStringSize = 15;
+
+    /// Return the variant member for a String value.
+    static AsValueType stringValue(std::string str) {
+        if (str.size() <= sharedStringSize) return AsValueType(std::move(str));
+        return AsValueType(
+                std::make_shared<const SharedString>(std::move(str)));
+    }
     
+    AsType type() const {
+        return _type;
+    }
+
+#else
+    /// The tag of a value that is not a Number.
+    //
+    /// Values with a tag from TAG_STRING up own a reference to a Shared
+    /// part.
+    enum Tag
+    {
+        TAG_UNDEFINED,
+        TAG_NULL,
+        TAG_BOOLEAN,
+        TAG_OBJECT,
+        TAG_STRING,
+        TAG_DISPLAYOBJECT,
+        TAG_EXCEPTION
+    };
+
+    /// Values from this one up are tagged, the ones below are Numbers.
+    //
+    /// These are negative quiet NaNs, which a Number never is, since all
+    /// NaNs are stored as canonicalNaN.
+    static const std::uint64_t tagBase = 0xfff8000000000000ULL;
+
+    /// The bits of every NaN Number.
+    static const std::uint64_t canonicalNaN = 0x7ff8000000000000ULL;
+
+    /// The tag is stored above the 48-bit payload.
+    static const int tagShift = 48;
+
+    static const std::uint64_t payloadMask = (1ULL << tagShift) - 1;
+
+    /// The reference counted part of a String, DisplayObject or thrown
+    /// value, shared by its copies.
+    //
+    /// Values only live in the VM thread, so the count is a plain one.
+    struct Shared
+    {
+        Shared() : refs(1) {}
+        virtual ~Shared() {}
+        unsigned refs;
+    };
+
+    struct SharedString : Shared
+    {
+        explicit SharedString(std::string s) : str(std::move(s)) {}
+        const std::string str;
+
+        /// The decoded characters, see getDecodedCache().
+        mutable std::shared_ptr<const DecodedString> decoded;
+    };
+
+    struct SharedProxy : Shared
+    {
+        explicit SharedProxy(const CharacterProxy& p) : proxy(p) {}
+        const CharacterProxy proxy;
+    };
+
+    /// Holds the value that was thrown.
+    struct Thrown;
+
+    static std::uint64_t tagged(Tag t, std::uint64_t payload = 0) {
+        return tagBase | (static_cast<std::uint64_t>(t) << tagShift) | payload;
+    }
+
+    static std::uint64_t tagged(Tag t, const void* p) {
+        const std::uint64_t payload = reinterpret_cast<std::uintptr_t>(p);
+        assert(!(payload & ~payloadMask));
+        return tagged(t, payload);
+    }
+
+    static std::uint64_t tagged(Tag t, Shared* p) {
+        return tagged(t, static_cast<const void*>(p));
+    }
+
+    static std::uint64_t numberBits(double num) {
+        if (isNaN(num)) return canonicalNaN;
+        std::uint64_t bits;
+        std::memcpy(&bits, &num, sizeof bits);
+        return bits;
+    }
+
+    /// The caller must check that this is not a Number.
+    Tag tag() const {
+        return static_cast<Tag>((_bits >> tagShift) & 7);
+    }
+
+    void* pointer() const {
+        return reinterpret_cast<void*>(
+                static_cast<std::uintptr_t>(_bits & payloadMask));
+    }
+
+    bool isShared() const {
+        return _bits >= tagged(TAG_STRING);
+    }
+
+    /// The caller must check that the value has a Shared part.
+    Shared* shared() const {
+        return static_cast<Shared*>(pointer());
+    }
+
+    void retain() const {
+        if (isShared()) ++shared()->refs;
+    }
+
+    void release() {
+        if (isShared() && !--shared()->refs) delete shared();
+    }
+
+    /// Return the type of a thrown value.
+    AsType thrownType() const;
+
+    AsType type() const {
+        if (_bits < tagBase) return NUMBER;
+        switch (tag()) {
+            case TAG_UNDEFINED:
+                return UNDEFINED;
+            case TAG_NULL:
+                return NULLTYPE;
+            case TAG_BOOLEAN:
+                return BOOLEAN;
+            case TAG_OBJECT:
+                return OBJECT;
+            case TAG_STRING:
+                return STRING;
+            case TAG_DISPLAYOBJECT:
+                return DISPLAYOBJECT;
+            default:
+                return thrownType();
+        }
+    }
+
+#endif
+
     /// Use the relevant equality function, not operator==
     bool operator==(const as_value& v) const;
     
@@ -438,9 +726,14 @@ private:
     ///
     bool equalsSameType(const as_value& v) const;
     
+#ifndef GNASH_COMPACT_AS_VALUE
     AsType _type;
     
     AsValueType _value;
+#else
+    /// A Number, or a tag and its payload.
+    std::uint64_t _bits;
+#endif
     
     /// Get the object pointer variant member.
     //
@@ -457,11 +750,12 @@ private:
     /// The caller must check that this value is a DisplayObject
     CharacterProxy getCharacterProxy() const;
 
+#ifndef GNASH_COMPACT_AS_VALUE
     /// Get the number variant member.
     //
     /// The caller must check that this value is a Number.
     double getNum() const {
-        assert(_type == NUMBER);
+        assert(type() == NUMBER);
         return boost::get<double>(_value);
     }
     
@@ -469,20 +763,57 @@ private:
     //
     /// The caller must check that this value is a Boolean.
     bool getBool() const {
-        assert(_type == BOOLEAN);
+        assert(type() == BOOLEAN);
         return boost::get<bool>(_value);
     }
 
-    /// Get the boolean variant member.
+    /// Get the string variant member.
     //
     /// The caller must check that this value is a String.
     const std::string& getStr() const {
-        assert(_type == STRING);
+        assert(type() == STRING);
+        const std::shared_ptr<const SharedString>* shared =
+            boost::get<std::shared_ptr<const SharedString> >(&_value);
+        if (shared) return (*shared)->str;
         return boost::get<std::string>(_value);
     }
+#else
+    /// Get the number variant member.
+    //
+    /// The caller must check that this value is a Number.
+    double getNum() const {
+        assert(type() == NUMBER);
+        double num;
+        std::memcpy(&num, &_bits, sizeof num);
+        return num;
+    }
     
+    /// Get the boolean variant member.
+    //
+    /// The caller must check that this value is a Boolean.
+    bool getBool() const {
+        assert(type() == BOOLEAN);
+        return _bits & 1;
+    }
+
+    /// Get the string variant member.
+    //
+    /// The caller must check that this value is a String.
+    const std::string& getStr() const {
+        assert(type() == STRING);
+        return static_cast<const SharedString*>(shared())->str;
+    }
+#endif
+
 };
 
+#ifdef GNASH_COMPACT_AS_VALUE
+static_assert(sizeof(double) == sizeof(std::uint64_t),
+        "Compact as_values need 64-bit doubles");
+static_assert(sizeof(as_value) == sizeof(std::uint64_t),
+        "A compact as_value is a single 64-bit word");
+#endif
+
 /// Stream operator.
 DSOTEXPORT std::ostream& operator<<(std::ostream& os, const as_value& v);
 
@@ -23,8 +23,8 @@
 #include <string>
 #include <algorithm>
 #include <cmath>
-#include <functional>
 #include <iterator>
+#include <functional>
 #include <boost/algorithm/string/case_conv.hpp>
 #include <boost/lexical_cast.hpp>
 
@@ -66,8 +66,6 @@ namespace {
 
     struct indexed_as_value;
 
-    typedef std::function<bool(const as_value&, const as_value&)> as_cmp_fn;
-
     void attachArrayInterface(as_object& proto);
     void attachArrayStatics(as_object& proto);
 
@@ -109,6 +107,10 @@ namespace {
     /// Set the length property of an object only if it is a genuine array.
     void setArrayLength(as_object& o, const int size);
 
+    /// Replace the first elements of an array with the given values.
+    template<typename T> void setElements(as_object& o, const T& v,
+            size_t size);
+
     void resizeArray(as_object& o, const int size);
 
 }
@@ -180,52 +182,39 @@ namespace mergesort {
 //
 // The following is an implementation of merge sort. I chose merge sort because
 // it is reasonably fast, efficient, simple and it is used by Spidermonkey for
-// the same purpose as ours. I am using in-place merge, which of course trades
-// memory efficiency for CPU time (just like std::sort). Whether this is a good
-// tradeoff in this case, remains to be seen.
+// the same purpose as ours. The halves are merged through a buffer: each
+// comparison is a call to ActionScript, so it is better to spend memory than
+// to compare more often than O(n log n) times.
 
-/// 'Safe' version of std::inplace_merge: even with a comparator that does not
-/// adhere to the strict weak ordering model, this implementation is
-/// memory-safe and free from infinite loops.
+/// 'Safe' merge: even with a comparator that does not adhere to the strict
+/// weak ordering model, this implementation is memory-safe and free from
+/// infinite loops.
 // 
 /// Merges the two already-sorted ranges (@begin, @middle] and (@middle, @end] into the
-/// sorted range (begin, end]. @compare is used for determining order.
+/// sorted range (begin, end]. @compare is used for determining order. The
+/// merge is stable: equal elements of the first range come first.
 template<typename IterType, typename ComparatorType>
 void
-inplaceMerge(IterType begin, IterType middle, const IterType& end, ComparatorType compare)
+safeMerge(IterType begin, IterType middle, IterType end, ComparatorType compare)
 {
     typedef typename std::iterator_traits<IterType>::value_type value_type;
 
-    // Let's assume compare is std::less, for example.
-    //
-    // We walk through the first range, looking for an element which is
-    // greater or equal to the first value of the second range, the
-    // next-high value (NHV). If we find one, then we move the range of
-    // the values in the second range which are less than NHV one place to
-    // the left, and we copy NHV into the vacant space immediately to the
-    // right.
-    //     +--<--+                        -<-+   
-    //     |     | <- <-  (2nd it.)       |  |<-|<-|   (3rd it.)    
-    // [2, 6, 7  3, 4, 5]    ->    [2, 3, 7, 4, 5, 6]     ->    [2,3,4,5,6,7]
-    //     |     |     |                  |  |     |                   |
-    //     |  middle   |                  middle   |                middle
-    //     +---->------+                  +--->----+
-    while(begin != middle ) {
-        if (compare(*middle, *begin)) {
-            value_type next_high = *begin;
-            *begin = *middle;
-
-            // Find the first element that is not less than next_high. Then, shift all
-            // elements before that element one position to the left, and copy
-            // next_high into the vacant spot.
-            IterType it = std::find_if(middle, end, 
-                [&](const value_type& v) { return !compare(v, next_high); });
-
-            std::copy(std::next(middle), it, middle);
-            *(--it) = next_high;
-        }
-        ++begin;
+    std::vector<value_type> merged;
+    merged.reserve(std::distance(begin, end));
+
+    IterType first = begin;
+    IterType second = middle;
+
+    // Every comparison consumes an element, so this ends whatever the
+    // comparator answers.
+    while (first != middle && second != end) {
+        if (compare(*second, *first)) merged.push_back(*second++);
+        else merged.push_back(*first++);
     }
+    merged.insert(merged.end(), first, middle);
+    merged.insert(merged.end(), second, end);
+
+    std::copy(merged.begin(), merged.end(), begin);
 }
 
 /// Merge-sort the range delineated by (@begin, end] using comparator @compare.
@@ -244,145 +233,37 @@ void mergeSort(IterType begin, IterType end, ComparatorType compare)
 
     mergeSort(begin, middle, compare);
     mergeSort(middle, end, compare);
-    inplaceMerge(begin, middle, end, compare);
+    safeMerge(begin, middle, end, compare);
 }
 
 
 } // namespace mergesort
 
-template <typename IterType, typename ComparatorType>
-void
-SafeSort(IterType begin, IterType end, ComparatorType compare)
-{
-    std::sort(begin, end, compare);
-}
-
-class as_value_custom;
-
-template <typename IterType>
-void
-SafeSort(IterType begin, IterType end, const as_value_custom& compare);
-
 /// \brief
-/// Attempt to sort the array using given values comparator, avc.
-/// If two or more elements in the array are equal, as determined
-/// by the equality comparator ave, then the array is not sorted
-/// and 0 is returned. Otherwise the array is sorted and returned.
+/// Sort the array using given values comparator, avc.
+//
+/// This is only used for scripted comparators; the sort flags use
+/// the keys of the elements (see sortOnKeys).
 ///
 /// @param avc
 ///	boolean functor or function comparing two as_value& objects
-///     used to determine sort-order
-///
-/// @param ave
-///	boolean functor or function comparing two as_value& objects
-///     used to determine equality
 ///
-template <class AVCMP, class AVEQ>
-bool sort(as_object& o, AVCMP avc, AVEQ ave)
-{
-    // IMPORTANT NOTE
-    //
-    // As for ISO/IEC 14882:2003 - 23.2.2.4.29 
-    // the sort algorithm relies on the assumption
-    // that the comparator function implements
-    // a Strict Weak Ordering operator:
-    // http://www.sgi.com/tech/stl/StrictWeakOrdering.html
-    //
-    // Invalid comparator can lead to undefined behaviour,
-    // including invalid memory access and infinite loops.
-    //
-    // Pragmatically, it seems that std::list::sort is
-    // more robust in this reguard, so we'll sort a list
-    // instead of the queue. We want to sort a copy anyway
-    // to avoid the comparator changing the original container.
-
-    typedef std::list<as_value> SortContainer;
-
-    SortContainer v;
-    PushToContainer<SortContainer> pv(v);
-    foreachArray(o, pv);
-
-    const size_t size = v.size(); 
-
-    v.sort(avc);
-
-    if (std::adjacent_find(v.begin(), v.end(), ave) != v.end()) return false;
-
-    VM& vm = getVM(o);
-
-    SortContainer::const_iterator it = v.begin();
-
-    for (size_t i = 0; i < size; ++i) {
-        if (i >= v.size()) {
-            break;
-        }
-        o.set_member(arrayKey(vm, i), *it);
-        ++it;
-    }
-    return true;
-}
-
-
 template <class AVCMP>
 void
 sort(as_object& o, AVCMP avc) 
 {
-
-    typedef std::list<as_value> SortContainer;
-
-    SortContainer v;
-    PushToContainer<SortContainer> pv(v);
+    // Sort a copy: the comparator may change the array.
+    std::vector<as_value> v;
+    PushToContainer<std::vector<as_value> > pv(v);
     foreachArray(o, pv);
 
     const size_t size = v.size(); 
 
-    v.sort(avc);
-
-    VM& vm = getVM(o);
-
-    SortContainer::const_iterator it = v.begin();
-
-    for (size_t i = 0; i < size; ++i) {
-        if (it == v.end()) {
-            break;
-        }
-        o.set_member(arrayKey(vm, i), *it);
-        ++it;
-    }
-}
-
-/// \brief
-/// Return a new array containing sorted index of this array.
-/// If two or more elements in the array are equal, as determined
-/// by the equality comparator ave, then 0 is returned instead.
-///
-/// @param avc
-///	boolean functor or function comparing two as_value& objects
-///     used to determine sort-order
-///
-/// @param ave
-///	boolean functor or function comparing two as_value& objects
-///     used to determine equality
-///
-template <class AVCMP, class AVEQ>
-as_value sortIndexed(as_object& array, AVCMP avc, AVEQ ave)
-{
-    std::vector<indexed_as_value> v;
-
-    getIndexedElements(array, v);
-
-    SafeSort(v.begin(), v.end(), avc);
-
-    if (std::adjacent_find(v.begin(), v.end(), ave) != v.end()) {
-        return as_value(0.0);
-    }
+    mergesort::mergeSort(v.begin(), v.end(), avc);
 
-    as_object* o = getGlobal(array).createArray();
-    pushIndices(*o, v);
-    return o;
+    setElements(o, v, size);
 }
 
-
 /// \brief
 /// Return a new array containing sorted index of this array
 ///
@@ -395,282 +276,243 @@ sortIndexed(as_object& array, AVCMP avc)
 {
     std::vector<indexed_as_value> v;
     getIndexedElements(array, v);
-    SafeSort(v.begin(), v.end(), avc);
+    mergesort::mergeSort(v.begin(), v.end(), avc);
     as_object* o = getGlobal(array).createArray();
     pushIndices(*o, v);
     return o;
 }
 
-
-// simple as_value strict-weak-ordering comparison functors:
-// string comparison, ascending (default sort method)
-struct as_value_lt
+/// Return the flags of a sort field, checking they are all supported.
+//
+/// SORT_UNIQUE and SORT_RETURN_INDEX must first be stripped from the flags.
+std::uint8_t
+fieldFlags(std::uint8_t flags)
 {
-    as_value_lt(const fn_call& fn) : _fn(fn) {}
+    const std::uint8_t supported =
+        SORT_CASE_INSENSITIVE | SORT_DESCENDING | SORT_NUMERIC;
 
-    int str_cmp(const as_value& a, const as_value& b) const 
-    {
-        std::string s = a.to_string(getSWFVersion(_fn));
-        return s.compare(b.to_string(getSWFVersion(_fn)));
+    if (flags & ~supported) {
+        log_unimpl(_("Unhandled sort flags: %d (0x%X)"), +flags, +flags);
+        // Default string comparison.
+        return 0;
     }
+    return flags;
+}
 
-    int str_nocase_cmp(const as_value& a, const as_value& b) const
-    {
-        using namespace boost::algorithm;
+/// The comparison keys of the elements of an array.
+//
+/// Each element has a key per sort field, extracted once: comparisons
+/// then only look at the keys, instead of converting both values to
+/// strings or numbers every time.
+///
+/// A string sort compares the strings of the values, upper-cased if
+/// case-insensitive. A numeric sort orders numbers before NaN, null and
+/// undefined, except that two values are compared as strings if either
+/// is a string.
+class SortKeys
+{
+public:
 
-        std::string c = to_upper_copy(a.to_string(getSWFVersion(_fn)));
-        std::string d = to_upper_copy(b.to_string(getSWFVersion(_fn)));
-        return c.compare(d);
-    }
+    /// Extract the keys of the values to sort.
+    //
+    /// @param values   The elements of the array.
+    /// @param fields   The properties to sort on, or none to sort on the
+    ///                 elements themselves.
+    /// @param flags    The flags of each sort field (one if there are no
+    ///                 fields), as returned by fieldFlags().
+    SortKeys(const std::vector<as_value>& values,
+            const std::vector<ObjectURI>& fields,
+            std::vector<std::uint8_t> flags, const fn_call& fn);
 
-    bool as_value_numLT(const as_value& a, const as_value& b) const
-    {
-        if (a.is_undefined()) return false;
-        if (b.is_undefined()) return true;
-        if (a.is_null()) return false;
-        if (b.is_null()) return true;
-        const double aval = toNumber(a, getVM(_fn));
-        const double bval = toNumber(b, getVM(_fn));
-        if (isNaN(aval)) return false;
-        if (isNaN(bval)) return true;
-        return aval < bval;
-    }
+    /// Whether the element at index a sorts before the one at index b.
+    bool operator()(size_t a, size_t b) const;
 
-    bool as_value_numGT(const as_value& a, const as_value& b) const
-    {
-        if (b.is_undefined()) return false;
-        if (a.is_undefined()) return true;
-        if (b.is_null()) return false;
-        if (a.is_null()) return true;
-        const double aval = toNumber(a, getVM(_fn));
-        const double bval = toNumber(b, getVM(_fn));
-        if (isNaN(bval)) return false;
-        if (isNaN(aval)) return true;
-        return aval > bval;
-    }
+    /// Whether the elements at index a and b have equal sort fields.
+    bool equal(size_t a, size_t b) const;
 
-    inline bool as_value_numEQ(const as_value& a, const as_value& b) const
-    {
-        if (a.is_undefined() && b.is_undefined()) return true;
-        if (a.is_null() && b.is_null()) return true;
-        double aval = toNumber(a, getVM(_fn));
-        double bval = toNumber(b, getVM(_fn));
-        if (isNaN(aval) && isNaN(bval)) return true;
-        return aval == bval;
-    }
+private:
 
-    bool operator()(const as_value& a, const as_value& b) const
+    struct Key
     {
-        return str_cmp(a, b) < 0;
-    }
-private:
-    const fn_call& _fn;
-};
+        bool string;
+        bool undefined;
+        bool null;
 
-// string comparison, descending
-struct as_value_gt : public as_value_lt 
-{
-    as_value_gt(const fn_call& fn) : as_value_lt(fn) {}
-    bool operator()(const as_value& a, const as_value& b) const {
-        return str_cmp(a, b) > 0;
-    }
-};
+        /// The value as a number, for numeric sorts of non-strings.
+        double number;
 
-// string equality
-struct as_value_eq : public as_value_lt
-{
-    as_value_eq(const fn_call& fn) : as_value_lt(fn) {}
-    bool operator()(const as_value& a, const as_value& b) const
-    {
-        return str_cmp(a, b) == 0;
-    }
-};
+        /// The value as a string, only if it may be compared as a string.
+        std::string str;
+    };
 
-// case-insensitive string comparison, ascending
-struct as_value_nocase_lt : public as_value_lt
-{
-    as_value_nocase_lt(const fn_call& fn) : as_value_lt(fn) {}
-    bool operator()(const as_value& a, const as_value& b) const
-    {
-        return str_nocase_cmp(a, b) < 0;
+    const Key& key(size_t element, size_t field) const {
+        return _keys[element * _flags.size() + field];
     }
-};
 
-// case-insensitive string comparison, descending
-struct as_value_nocase_gt : public as_value_lt
-{
-    as_value_nocase_gt(const fn_call& fn) : as_value_lt(fn) {}
-    bool operator()(const as_value& a, const as_value& b) const
-    {
-        return str_nocase_cmp(a, b) > 0;
-    }
-};
+    /// Ascending order of the keys of a field.
+    static bool less(const Key& a, const Key& b, std::uint8_t flags);
 
-// case-insensitive string equality
-struct as_value_nocase_eq : public as_value_lt
-{
-    as_value_nocase_eq(const fn_call& fn) : as_value_lt(fn) {}
-    bool operator()(const as_value& a, const as_value& b) const
-    {
-        return str_nocase_cmp(a, b) == 0;
-    }
-};
+    static bool equal(const Key& a, const Key& b, std::uint8_t flags);
 
-// numeric comparison, ascending
-struct as_value_num_lt : public as_value_lt
-{
-    as_value_num_lt(const fn_call& fn) : as_value_lt(fn) {}
-    bool operator()(const as_value& a, const as_value& b) const
-    {
-        if (a.is_string() || b.is_string()) return str_cmp(a, b) < 0;
-        return as_value_numLT(a, b);
-    }
+    std::vector<std::uint8_t> _flags;
+
+    /// The keys of the first element, then of the second one, etc.
+    std::vector<Key> _keys;
 };
 
-// numeric comparison, descending
-struct as_value_num_gt : public as_value_lt
+SortKeys::SortKeys(const std::vector<as_value>& values,
+        const std::vector<ObjectURI>& fields,
+        std::vector<std::uint8_t> flags, const fn_call& fn)
+    :
+    _flags(std::move(flags)),
+    _keys(values.size() * _flags.size())
 {
-    as_value_num_gt(const fn_call& fn) : as_value_lt(fn) {}
-    bool operator()(const as_value& a, const as_value& b) const
-    {
-        if (a.is_string() || b.is_string()) return str_cmp(a, b) > 0;
-        return as_value_numGT(a, b);
+    VM& vm = getVM(fn);
+    const int version = getSWFVersion(fn);
+
+    std::vector<as_value> props;
+
+    for (size_t field = 0; field < _flags.size(); ++field) {
+
+        if (!fields.empty()) {
+            props.clear();
+            for (const as_value& val : values) {
+                as_object* o = toObject(val, vm);
+                props.push_back(o ? getOwnProperty(*o, fields[field]) :
+                        as_value());
+            }
+        }
+        const std::vector<as_value>& v = fields.empty() ? values : props;
+
+        const std::uint8_t f = _flags[field];
+        const bool numeric = (f & SORT_NUMERIC);
+
+        // A numeric sort needs strings only if some values are strings.
+        const bool strings = !numeric || std::any_of(v.begin(), v.end(),
+                [](const as_value& val) { return val.is_string(); });
+
+        for (size_t i = 0; i < v.size(); ++i) {
+            Key& k = _keys[i * _flags.size() + field];
+            k.string = v[i].is_string();
+            k.undefined = v[i].is_undefined();
+            k.null = v[i].is_null();
+            k.number = (numeric && !k.string) ? toNumber(v[i], vm) : 0;
+            if (strings) {
+                k.str = v[i].to_string(version);
+                if (f & SORT_CASE_INSENSITIVE) {
+                    boost::algorithm::to_upper(k.str);
+                }
+            }
+        }
     }
-};
+}
 
-// numeric equality
-struct as_value_num_eq : public as_value_lt
+bool
+SortKeys::operator()(size_t a, size_t b) const
 {
-    as_value_num_eq(const fn_call& fn) : as_value_lt(fn) {}
-    bool operator()(const as_value& a, const as_value& b) const
-    {
-        if (a.is_string() || b.is_string()) return str_cmp(a, b) == 0;
-        return as_value_numEQ(a, b);
+    for (size_t field = 0; field < _flags.size(); ++field) {
+        const Key& ka = key(a, field);
+        const Key& kb = key(b, field);
+        const std::uint8_t f = _flags[field];
+
+        const bool descending = (f & SORT_DESCENDING);
+        if (descending ? less(kb, ka, f) : less(ka, kb, f)) return true;
+        if (descending ? less(ka, kb, f) : less(kb, ka, f)) return false;
+        // Equal for this field: compare the next one.
     }
-};
+    return false;
+}
 
-// case-insensitive numeric comparison, ascending
-struct as_value_num_nocase_lt : public as_value_lt
+bool
+SortKeys::equal(size_t a, size_t b) const
 {
-    as_value_num_nocase_lt(const fn_call& fn) : as_value_lt(fn) {}
-    bool operator()(const as_value& a, const as_value& b) const
-    {
-        if (a.is_string() || b.is_string()) return str_nocase_cmp(a, b) < 0;
-        return as_value_numLT(a, b);
+    if (_flags.empty()) return false;
+
+    for (size_t field = 0; field < _flags.size(); ++field) {
+        if (!equal(key(a, field), key(b, field), _flags[field])) return false;
     }
-};
+    return true;
+}
 
-// case-insensitive numeric comparison, descending
-struct as_value_num_nocase_gt : public as_value_lt
+bool
+SortKeys::less(const Key& a, const Key& b, std::uint8_t flags)
 {
-    as_value_num_nocase_gt(const fn_call& fn) : as_value_lt(fn) {}
-    bool operator()(const as_value& a, const as_value& b) const
-    {
-        if (a.is_string() || b.is_string()) return str_nocase_cmp(a, b) > 0;
-        return as_value_numGT(a, b);
-    }
-};
+    if (!(flags & SORT_NUMERIC) || a.string || b.string) return a.str < b.str;
+
+    if (a.undefined) return false;
+    if (b.undefined) return true;
+    if (a.null) return false;
+    if (b.null) return true;
+    if (isNaN(a.number)) return false;
+    if (isNaN(b.number)) return true;
+    return a.number < b.number;
+}
 
-// case-insensitive numeric equality
-struct as_value_num_nocase_eq : public as_value_lt
+bool
+SortKeys::equal(const Key& a, const Key& b, std::uint8_t flags)
 {
-    as_value_num_nocase_eq(const fn_call& fn) : as_value_lt(fn) {}
-    bool operator() (const as_value& a, const as_value& b) const
-    {
-        if (a.is_string() || b.is_string()) return str_nocase_cmp(a, b) == 0;
-        return as_value_numEQ(a, b);
-    }
-};
+    if (!(flags & SORT_NUMERIC) || a.string || b.string) return a.str == b.str;
 
-// Return basic as_value comparison functor for corresponding sort flag
-// Note:
-// SORT_UNIQUE and SORT_RETURN_INDEX must first be stripped from the flag
-as_cmp_fn
-get_basic_cmp(std::uint8_t flags, const fn_call& fn)
+    if (a.undefined && b.undefined) return true;
+    if (a.null && b.null) return true;
+    if (isNaN(a.number) && isNaN(b.number)) return true;
+    return a.number == b.number;
+}
+
+/// Sort an array using the sort flags.
+//
+/// @param fields   The properties to sort on, or none to sort on the
+///                 elements themselves.
+/// @param flags    The flags of each field, see SortKeys.
+/// @param unique   If two elements are equal, return 0 and leave the
+///                 array unchanged.
+/// @param index    Return a new array of the indices of the elements
+///                 in sorted order and leave the array unchanged.
+/// @return         The sorted array, the array of indices, or 0.
+as_value
+sortOnKeys(as_object& array, const std::vector<ObjectURI>& fields,
+        std::vector<std::uint8_t> flags, bool unique, bool index,
+        const fn_call& fn)
 {
-    as_cmp_fn f;
+    std::vector<as_value> values;
+    PushToContainer<std::vector<as_value> > pv(values);
+    foreachArray(array, pv);
 
-    // SORT_UNIQUE and SORT_RETURN_INDEX must be stripped by caller
-    //assert(flags^SORT_UNIQUE);
-    //assert(flags^SORT_RETURN_INDEX);
+    const SortKeys keys(values, fields, std::move(flags), fn);
 
-    switch ( flags )
-    {
-        case 0: // default string comparison
-            f = as_value_lt(fn);
-            return f;
-
-        case SORT_DESCENDING:
-            f = as_value_gt(fn);
-            return f;
-
-        case SORT_CASE_INSENSITIVE: 
-            f = as_value_nocase_lt(fn);
-            return f;
-
-        case SORT_CASE_INSENSITIVE | 
-                SORT_DESCENDING:
-            f = as_value_nocase_gt(fn);
-            return f;
-
-        case SORT_NUMERIC: 
-            f = as_value_num_lt(fn);
-            return f;
-
-        case SORT_NUMERIC | SORT_DESCENDING:
-            f = as_value_num_gt(fn);
-            return f;
-
-        case SORT_CASE_INSENSITIVE | 
-                SORT_NUMERIC:
-            f = as_value_num_nocase_lt(fn);
-            return f;
-
-        case SORT_CASE_INSENSITIVE | 
-                SORT_NUMERIC |
-                SORT_DESCENDING:
-            f = as_value_num_nocase_gt(fn);
-            return f;
-
-        default:
-            log_unimpl(_("Unhandled sort flags: %d (0x%X)"), +flags, +flags);
-            f = as_value_lt(fn);
-            return f;
+    std::vector<size_t> order(values.size());
+    for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+
+    mergesort::mergeSort(order.begin(), order.end(), std::cref(keys));
+
+    if (unique && std::adjacent_find(order.begin(), order.end(),
+            [&keys](size_t a, size_t b) { return keys.equal(a, b); }) !=
+            order.end()) {
+        return as_value(0.0);
     }
-}
 
-// Return basic as_value equality functor for corresponding sort flag
-// Note:
-// SORT_UNIQUE and SORT_RETURN_INDEX must first be stripped from the flag
-as_cmp_fn
-get_basic_eq(std::uint8_t flags, const fn_call& fn)
-{
-    as_cmp_fn f;
-    flags &= ~(SORT_DESCENDING);
+    std::vector<as_value> sorted;
+    sorted.reserve(order.size());
 
-    switch (flags)
-    {
-        case 0: // default string comparison
-            f = as_value_eq(fn);
-            return f;
-
-        case SORT_CASE_INSENSITIVE: 
-            f = as_value_nocase_eq(fn);
-            return f;
-
-        case SORT_NUMERIC: 
-            f = as_value_num_eq(fn);
-            return f;
-
-        case SORT_CASE_INSENSITIVE | 
-                SORT_NUMERIC:
-            f = as_value_num_nocase_eq(fn);
-            return f;
-
-        default:
-            f = as_value_eq(fn);
-            return f;
+    if (index) {
+        for (size_t i : order) sorted.push_back(static_cast<double>(i));
+        as_object* o = getGlobal(array).createArray();
+        setElements(*o, sorted, sorted.size());
+        return o;
     }
+
+    for (size_t i : order) sorted.push_back(values[i]);
+    setElements(array, sorted, sorted.size());
+    return as_value(&array);
+}
+
+/// Sort an array on its elements using the sort flags.
+as_value
+sortOnKeys(as_object& array, std::uint8_t flags, bool unique, bool index,
+        const fn_call& fn)
+{
+    return sortOnKeys(array, std::vector<ObjectURI>(),
+            std::vector<std::uint8_t>(1, flags), unique, index, fn);
 }
 
 // Custom (ActionScript) comparator 
@@ -704,128 +546,6 @@ public:
     }
 };
 
-// Comparator for sorting on a single array property
-class as_value_prop
-{
-public:
-    
-    // Note: cmpfn must implement a strict weak ordering
-    as_value_prop(ObjectURI name, as_cmp_fn cmpfn, const as_object& o)
-        :
-        _comp(std::move(cmpfn)),
-        _prop(std::move(name)),
-        _obj(o)
-    {
-    }
-
-    bool operator()(const as_value& a, const as_value& b) const {
-
-        // why do we cast ao/bo to objects here ?
-        as_object* ao = toObject(a, getVM(_obj));
-        as_object* bo = toObject(b, getVM(_obj));
-
-        //assert(ao);
-        //assert(bo);
-        
-        const as_value& av = getOwnProperty(*ao, _prop);
-        const as_value& bv = getOwnProperty(*bo, _prop);
-
-        return _comp(av, bv);
-    }
-private:
-    as_cmp_fn _comp;
-    ObjectURI _prop;
-    const as_object& _obj;
-};
-
-// Comparator for sorting on multiple array properties
-class as_value_multiprop
-{
-public:
-    typedef std::vector<as_cmp_fn> Comps;
-    Comps& _cmps;
-
-    typedef std::vector<ObjectURI> Props;
-    Props& _prps;
-    
-    const as_object& _obj;
-
-    // Note: all as_cmp_fns in *cmps must implement strict weak ordering
-    as_value_multiprop(std::vector<ObjectURI>& prps, 
-        std::vector<as_cmp_fn>& cmps, const as_object& o)
-        :
-        _cmps(cmps),
-        _prps(prps),
-        _obj(o)
-    {
-    }
-
-    bool operator() (const as_value& a, const as_value& b)
-    {
-        if (_cmps.empty()) return false;
-
-        std::vector<as_cmp_fn>::iterator cmp = _cmps.begin();
-
-        // why do we cast ao/bo to objects here ?
-        as_object* ao = toObject(a, getVM(_obj));
-        as_object* bo = toObject(b, getVM(_obj));
-
-        // TODO: this may not be correct, but it is better than accessing
-        // null pointers.
-        if (!ao || !bo) return false;
-        
-        for (Props::iterator pit = _prps.begin(), pend = _prps.end();
-                pit != pend; ++pit, ++cmp) {
-            
-            const as_value& av = getOwnProperty(*ao, *pit);
-            const as_value& bv = getOwnProperty(*bo, *pit);
-
-            if ((*cmp)(av, bv)) return true;
-            if ((*cmp)(bv, av)) return false;
-            // Note: for loop finishes only if a == b for
-            // each requested comparison
-            // (since *cmp(av,bv) == *cmp(bv,av) == false)
-        }
-        
-        return false;
-    }
-};
-
-class as_value_multiprop_eq : public as_value_multiprop
-{
-public:
-    as_value_multiprop_eq(std::vector<ObjectURI>& prps, 
-        std::vector<as_cmp_fn>& cmps, const as_object& o)
-        :
-        as_value_multiprop(prps, cmps, o),
-        _obj(o)
-    {
-    }
-
-    bool operator()(const as_value& a, const as_value& b) const {
-        if (_cmps.empty()) return false;
-
-        Comps::const_iterator cmp = _cmps.begin();
-
-        // why do we cast ao/bo to objects here ?
-        as_object* ao = toObject(a, getVM(_obj));
-        as_object* bo = toObject(b, getVM(_obj));
-
-        for (Props::iterator pit = _prps.begin(), pend = _prps.end();
-                pit != pend; ++pit, ++cmp)
-        {
-            const as_value& av = getOwnProperty(*ao, *pit);
-            const as_value& bv = getOwnProperty(*bo, *pit);
-
-            if (!(*cmp)(av, bv)) return false;
-        }
-        
-        return true;
-    }
-private:
-    const as_object& _obj;
-};
-
 // Convenience function to strip SORT_UNIQUE and SORT_RETURN_INDEX from sort
 // flag. Presence of flags recorded in douniq and doindex.
 inline std::uint8_t
@@ -838,13 +558,6 @@ flag_preprocess(std::uint8_t flgs, bool* douniq, bool* doindex)
     return flgs;
 }
 
-template <typename IterType>
-void
-SafeSort(IterType begin, IterType end, const as_value_custom& compare)
-{
-    mergesort::mergeSort(begin, end, compare);
-}
-
 class GetKeys
 {
 public:
@@ -929,7 +642,8 @@ checkArrayLength(as_object& array, const ObjectURI& uri, const as_value& val)
         return;
     }
 
-    const int index = isIndex(uri.toString(getStringTable(array)));
+    int index = getVM(array).getArrayIndex(uri);
+    if (index < 0) index = isIndex(uri.toString(getStringTable(array)));
 
     // if we were sent a valid array index
     if (index >= 0) {
@@ -992,22 +706,11 @@ array_class_init(as_object& where, const ObjectURI& uri)
 }
 
 
-namespace patch
-{
-    template < typename T > std::string to_string( const T& n )
-    {
-        std::ostringstream stm ;
-        stm << n ;
-        return stm.str() ;
-    }
-}
-
 // Used by foreachArray, declared in Array_as.h
 ObjectURI
 arrayKey(VM& vm, size_t i)
 {
-    // TODO: tell getURI that the string is already lowercase!
-    return getURI(vm, patch::to_string(i), true);
+    return vm.getIndexURI(i);
 }
 
 namespace {
@@ -1100,18 +803,30 @@ array_splice(const fn_call& fn)
         callMethod(ret, propPush, getOwnProperty(*array, key));
     }
 
-    // Shift elements in 'this' array by simple assignment, not delete
-    // and readd.
-    for (size_t i = 0; i < static_cast<size_t>(size - remove); ++i) {
-        const bool started = (i >= static_cast<size_t>(start));
-        const size_t index = started ? i + remove : i;
-        const size_t target = started ? i + newelements : i;
-        array->set_member(getKey(fn, target), v[index]);
-    }
+    std::vector<as_value>* elements = array->denseElements(size);
+    if (elements) {
+        // Rebuild densely stored elements in one go.
+        TempContainer spliced(v.begin(), v.begin() + start);
+        for (size_t i = 0; i < newelements; ++i) {
+            spliced.push_back(fn.arg(i + 2));
+        }
+        spliced.insert(spliced.end(), v.begin() + start + remove, v.end());
+        elements->swap(spliced);
+    }
+    else {
+        // Shift elements in 'this' array by simple assignment, not delete
+        // and readd.
+        for (size_t i = 0; i < static_cast<size_t>(size - remove); ++i) {
+            const bool started = (i >= static_cast<size_t>(start));
+            const size_t index = started ? i + remove : i;
+            const size_t target = started ? i + newelements : i;
+            array->set_member(getKey(fn, target), v[index]);
+        }
 
-    // Insert the replacement elements in the gap we left.
-    for (size_t i = 0; i < newelements; ++i) {
-        array->set_member(getKey(fn, start + i), fn.arg(i + 2));
+        // Insert the replacement elements in the gap we left.
+        for (size_t i = 0; i < newelements; ++i) {
+            array->set_member(getKey(fn, start + i), fn.arg(i + 2));
+        }
     }
     
     // This one is correct!
@@ -1127,8 +842,7 @@ array_sort(const fn_call& fn)
     as_object* array = ensure<ValidThis>(fn);
     
     if (!fn.nargs) {
-        sort(*array, as_value_lt(fn));
-        return as_value(array);
+        return sortOnKeys(*array, 0, false, false, fn);
     }
     
     if (fn.arg(0).is_undefined()) return as_value();
@@ -1177,16 +891,7 @@ array_sort(const fn_call& fn)
 
     bool do_unique, do_index;
     flags = flag_preprocess(flags, &do_unique, &do_index);
-    as_cmp_fn comp = get_basic_cmp(flags, fn);
-
-    if (do_unique) {
-        as_cmp_fn eq = get_basic_eq(flags, fn);
-        if (do_index) return sortIndexed(*array, comp, eq);
-        return sort(*array, comp, eq) ? as_value(array) : as_value(0.0);
-    }
-    if (do_index) return sortIndexed(*array, comp);
-    sort(*array, comp);
-    return as_value(array);
+    return sortOnKeys(*array, fieldFlags(flags), do_unique, do_index, fn);
 }
 
 as_value
@@ -1213,23 +918,9 @@ array_sortOn(const fn_call& fn)
             flags = flag_preprocess(flags, &do_unique, &do_index);
         }
 
-        as_value_prop avc(propField, get_basic_cmp(flags, fn),
-                getGlobal(fn));
-
-        if (do_unique) {
-            as_value_prop ave(propField, get_basic_eq(flags, fn), 
-                    getGlobal(fn));
-            if (do_index)
-                return sortIndexed(*array, avc, ave);
-            return sort(*array, avc, ave) ? as_value(array) : as_value(0.0);
-        }
-        
-        if (do_index) {
-            return sortIndexed(*array, avc);
-        }
-
-        sort(*array, avc);
-        return as_value(array);
+        return sortOnKeys(*array, std::vector<ObjectURI>(1, propField),
+                std::vector<std::uint8_t>(1, fieldFlags(flags)), do_unique,
+                do_index, fn);
     }
 
     // case: sortOn(["prop1", "prop2"] ...)
@@ -1242,17 +933,15 @@ array_sortOn(const fn_call& fn)
         GetKeys gk(prp, vm, version);
         foreachArray(*props, gk);
         
-        std::vector<as_cmp_fn> cmp;
-        std::vector<as_cmp_fn> eq;
+        std::vector<std::uint8_t> flgs;
         
         // Will be the same as arrayLength(*props);
         const size_t optnum = prp.size();
         
         // case: sortOn(["prop1", "prop2"])
         if (fn.nargs == 1) {
-            // assign each cmp function to the standard cmp fn
-            as_cmp_fn c = get_basic_cmp(0, fn);
-            cmp.assign(optnum, c);
+            // assign each field the standard flags
+            flgs.assign(optnum, 0);
         }
         // case: sortOn(["prop1", "prop2"], [Array.FLAG1, Array.FLAG2])
         else if (fn.arg(1).is_object()) {
@@ -1262,28 +951,16 @@ array_sortOn(const fn_call& fn)
             // Only an array will do for this case.
             if (farray->array() && arrayLength(*farray) == optnum) {
 
-                std::vector<std::uint8_t> flgs;
                 GetMultiFlags mf(flgs, fn);
                 foreachArray(*farray, mf);
                 do_unique = mf.unique();
                 do_index = mf.index();
                 
-                std::vector<std::uint8_t>::const_iterator it =
-                    flgs.begin();
-
-                while (it != flgs.end()) {
-                    cmp.push_back(get_basic_cmp(*it++, fn));
-                }
-
-                if (do_unique) {
-                    it = flgs.begin();
-                    while (it != flgs.end())
-                        eq.push_back(get_basic_eq(*it++, fn));
-                }
+                std::transform(flgs.begin(), flgs.end(), flgs.begin(),
+                        fieldFlags);
             }
             else {
-                as_cmp_fn c = get_basic_cmp(0, fn);
-                cmp.assign(optnum, c);
+                flgs.assign(optnum, 0);
             }
         }
         // case: sortOn(["prop1", "prop2"], Array.FLAG)
@@ -1291,26 +968,10 @@ array_sortOn(const fn_call& fn)
             std::uint8_t flags =
                 static_cast<std::uint8_t>(toInt(fn.arg(1), getVM(fn)));
             flags = flag_preprocess(flags, &do_unique, &do_index);
-            as_cmp_fn c = get_basic_cmp(flags, fn);
-
-            cmp.assign(optnum, c);
-            
-            if (do_unique) {
-                as_cmp_fn e = get_basic_eq(flags, fn);
-                eq.assign(optnum, e);
-            }
+            flgs.assign(optnum, fieldFlags(flags));
         }
-        as_value_multiprop avc(prp, cmp, getGlobal(fn));
-
-        if (do_unique) {
-            as_value_multiprop_eq ave(prp, eq, getGlobal(fn));
-            if (do_index) return sortIndexed(*array, avc, ave);
-            return sort(*array, avc, ave) ? as_value(array) : as_value(0.0);
-        }
-        if (do_index) return sortIndexed(*array, avc);
-        sort(*array, avc);
-        return as_value(array);
 
+        return sortOnKeys(*array, prp, flgs, do_unique, do_index, fn);
     }
 
     IF_VERBOSE_ASCODING_ERRORS(
@@ -1332,9 +993,14 @@ array_push(const fn_call& fn)
 
     const size_t size = arrayLength(*array);
 
+    // Densely stored elements are appended directly, and the length is
+    // then updated only once.
+    bool appended = false;
     for (size_t i = 0; i < shift; ++i) {
-        array->set_member(getKey(fn, size + i), fn.arg(i));
+        if (array->setElement(size + i, fn.arg(i))) appended = true;
+        else array->set_member(getKey(fn, size + i), fn.arg(i));
     }
+    if (appended) setArrayLength(*array, size + shift);
  
     return as_value(size + shift);
 }
@@ -1352,6 +1018,14 @@ array_unshift(const fn_call& fn)
 
     const size_t size = arrayLength(*array);
 
+    std::vector<as_value>* elements = array->denseElements(size);
+    if (elements) {
+        const fn_call::Args::container_type& args = fn.getArgs();
+        elements->insert(elements->begin(), args.begin(), args.end());
+        setArrayLength(*array, size + shift);
+        return as_value(size + shift);
+    }
+
     for (size_t i = size + shift - 1; i >= shift ; --i) {
         const ObjectURI nextkey = getKey(fn, i - shift);
         const ObjectURI currentkey = getKey(fn, i);
@@ -1398,6 +1072,14 @@ array_shift(const fn_call& fn)
     // An array with no elements has nothing to return.
     if (size < 1) return as_value();
 
+    std::vector<as_value>* elements = array->denseElements(size);
+    if (elements) {
+        const as_value ret = elements->front();
+        elements->erase(elements->begin());
+        setArrayLength(*array, size - 1);
+        return ret;
+    }
+
     as_value ret = getOwnProperty(*array, getKey(fn, 0));
 
     for (size_t i = 0; i < static_cast<size_t>(size - 1); ++i) {
@@ -1422,6 +1104,12 @@ array_reverse(const fn_call& fn)
     // An array with 0 or 1 elements has nothing to reverse.
     if (size < 2) return as_value();
 
+    std::vector<as_value>* elements = array->denseElements(size);
+    if (elements) {
+        std::reverse(elements->begin(), elements->end());
+        return array;
+    }
+
     for (size_t i = 0; i < static_cast<size_t>(size) / 2; ++i) {
         const ObjectURI bottomkey = getKey(fn, i);
         const ObjectURI topkey = getKey(fn, size - i - 1);
@@ -1574,8 +1262,9 @@ join(as_object* array, const std::string& separator)
 
     for (size_t i = 0; i < size; ++i) {
         if (i) s += separator;
-        const std::string& index = patch::to_string(i);
-        const as_value& el = getOwnProperty(*array, getURI(vm, index));
+        const as_value* dense = array->getElement(i);
+        const as_value el = dense ? *dense : getOwnProperty(*array,
+                arrayKey(vm, i));
         s += el.to_string(version);
     }
     return as_value(s);
@@ -1609,7 +1298,8 @@ void foreachArray(as_object& array, int start, int end, T& pred)
     VM& vm = getVM(array);
 
     for (size_t i = start; i < static_cast<size_t>(end); ++i) {
-        pred(getOwnProperty(array, arrayKey(vm, i)));
+        const as_value* el = array.getElement(i);
+        pred(el ? *el : getOwnProperty(array, arrayKey(vm, i)));
     }
 }
 
@@ -1636,10 +1326,40 @@ resizeArray(as_object& o, const int size)
 
     const size_t currentSize = arrayLength(o);
     if (realSize < currentSize) {
+        std::vector<as_value>* elements = o.denseElements(currentSize);
+        if (elements) {
+            elements->resize(realSize);
+            return;
+        }
+
+        // Delete from the end, so that densely stored elements stay so.
         VM& vm = getVM(o);
-        for (size_t i = realSize; i < currentSize; ++i) {
-            o.delProperty(arrayKey(vm, i));
+        for (size_t i = currentSize; i > realSize; --i) {
+            o.delProperty(arrayKey(vm, i - 1));
+        }
+    }
+}
+
+template<typename T>
+void
+setElements(as_object& o, const T& v, size_t size)
+{
+    std::vector<as_value>* elements = o.denseElements(size);
+    if (elements && v.size() == size) {
+        std::copy(v.begin(), v.end(), elements->begin());
+        return;
+    }
+
+    VM& vm = getVM(o);
+
+    typename T::const_iterator it = v.begin();
+
+    for (size_t i = 0; i < size; ++i) {
+        if (it == v.end()) {
+            break;
         }
+        o.set_member(arrayKey(vm, i), *it);
+        ++it;
     }
 }
 
@@ -1656,6 +1376,11 @@ setArrayLength(as_object& array, const int size)
 int
 isIndex(const std::string& nameString)
 {
+    // Avoid the cost of an exception for names that can't be numbers.
+    if (nameString.empty()) return -1;
+    const char c = nameString[0];
+    if (c != '-' && c != '+' && (c < '0' || c > '9')) return -1;
+
     try {
         return boost::lexical_cast<int>(nameString);
     }
@@ -41,7 +41,8 @@ size_t arrayLength(as_object& array);
 /// Convert an integral value into an ObjectURI
 //
 /// NB this function adds a string value to the VM for each separate
-/// integral value. It's the way the VM works.
+/// integral value. It's the way the VM works. The names are cached by the
+/// VM, so this is cheap.
 //
 /// @param i        The integral value to find
 /// @return         The ObjectURI to look up.
@@ -83,7 +84,8 @@ void foreachArray(as_object& array, T& pred)
     VM& vm = getVM(array);
 
     for (size_t i = 0; i < static_cast<size_t>(size); ++i) {
-        pred(getOwnProperty(array, arrayKey(vm, i)));
+        const as_value* el = array.getElement(i);
+        pred(el ? *el : getOwnProperty(array, arrayKey(vm, i)));
     }
 }
 
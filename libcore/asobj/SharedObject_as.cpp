@@ -25,6 +25,12 @@
 #include "SharedObject_as.h"
 
 #include <cstdio>
+#include <fstream>
+#include <fcntl.h>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
 
 #include "movie_root.h"
 #include "GnashSystemNetHeaders.h"
@@ -93,6 +99,12 @@ namespace {
     void flushSOL(SharedObjectLibrary::SoLib::value_type& sol);
     bool validateName(const std::string& solName);
 
+    /// Replace a SOL file with new contents.
+    //
+    /// The data goes to a temporary file first, which is then renamed,
+    /// so the SOL file is never left half-written.
+    bool replaceFile(const std::string& filespec, const SimpleBuffer& data);
+
     SharedObject_as* createSharedObject(Global_as& gl);
 }
 
@@ -192,6 +204,90 @@ private:
 
 } // anonymous namespace
 
+/// Writes SOL files from a background thread.
+//
+/// Saving a large SharedObject can take long enough to stall a frame,
+/// so flush() only encodes the data and queues it here. A file queued
+/// again before it was written is written once, with the newest data.
+class SOLWriter
+{
+public:
+
+    SOLWriter()
+        :
+        _done(false),
+        _thread(&SOLWriter::run, this)
+    {
+    }
+
+    /// Write all queued files and stop the thread.
+    ~SOLWriter()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _done = true;
+        }
+        _queued.notify_one();
+        _thread.join();
+    }
+
+    SOLWriter(const SOLWriter&) = delete;
+    SOLWriter& operator=(const SOLWriter&) = delete;
+
+    /// Queue a file, replacing any data still queued for it.
+    void write(const std::string& filespec, SimpleBuffer&& data)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _pending[filespec] = std::move(data);
+        _queued.notify_one();
+    }
+
+private:
+
+    typedef std::map<std::string, SimpleBuffer> Files;
+
+    void run()
+    {
+        Files files;
+
+        std::unique_lock<std::mutex> lock(_mutex);
+        for (;;) {
+            _queued.wait(lock, [this] { return !_pending.empty() || _done; });
+
+            // Let repeated flushes of the same object replace each other.
+            _queued.wait_for(lock, coalesceDelay, [this] { return _done; });
+            if (_pending.empty()) break;
+
+            files.swap(_pending);
+            lock.unlock();
+
+            for (const Files::value_type& f : files) {
+                replaceFile(f.first, f.second);
+            }
+            files.clear();
+
+            lock.lock();
+        }
+    }
+
+    static constexpr std::chrono::milliseconds coalesceDelay{100};
+
+    std::mutex _mutex;
+
+    /// Signalled when a file is queued or the thread should stop.
+    std::condition_variable _queued;
+
+    /// The files to write, by filespec.
+    Files _pending;
+
+    bool _done;
+
+    /// Started last, once everything it uses is initialized.
+    std::thread _thread;
+};
+
+constexpr std::chrono::milliseconds SOLWriter::coalesceDelay;
+
 class SharedObject_as : public Relay
 {
 public:
@@ -213,7 +309,8 @@ public:
 
     /// Write the data as a SOL file.
     //
-    /// If there is no data to write, the file is removed.
+    /// The data is encoded immediately and the file written in the
+    /// background by the SharedObjectLibrary.
     bool flush(int space = 0) const;
 
     /// The filename of this SharedObject.
@@ -305,7 +402,7 @@ SharedObject_as::~SharedObject_as()
 
 /// Returns false if the data cannot be written to file.
 //
-/// If there is no data, the file is removed and the function returns true.
+/// Failures of the background write itself are only logged.
 bool
 SharedObject_as::flush(int space) const
 {
@@ -351,30 +448,13 @@ SharedObject_as::flush(int space) const
     }
 
     // Encode header part.
-    SimpleBuffer header;
-    encodeHeader(buf.size(), header);
-
-    std::ofstream ofs(filespec.c_str(), std::ios::binary);
-    if (!ofs) {
-        log_error(_("SharedObject::flush(): Failed opening file '%s' in binary"
-                    " mode"), filespec);
-        return false;
-    }
+    SimpleBuffer sol(buf.size() + 6);
+    encodeHeader(buf.size(), sol);
+    sol.append(buf.data(), buf.size());
 
-    bool success = ofs.write(reinterpret_cast<const char*>(header.data()), header.size())
-                   && ofs.write(reinterpret_cast<const char*>(buf.data()), buf.size());
-    ofs.close();
-
-    if (!success) {
-        log_error(_("Error writing AMF data to output file %s"), filespec);
-        if (std::remove(filespec.c_str()) != 0) {
-            log_error(_("Error removing SOL output file %s: %s"), filespec,
-                      strerror(errno));
-        }
-        return false;
-    }
-
-    log_security(_("SharedObject '%s' written to filesystem."), filespec);
+    // The data is known to be valid, so the write is reported as a
+    // success; errors writing the file are only logged.
+    getVM(_owner).getSharedObjectLibrary().writeSOL(filespec, std::move(sol));
     return true;
 }
 
@@ -465,6 +545,19 @@ SharedObjectLibrary::clear()
 {
     std::for_each(_soLib.begin(), _soLib.end(), &flushSOL);
     _soLib.clear();
+
+    // The files must be there if the objects are loaded again, and
+    // quitting may not destroy the library, so the writer is stopped.
+    // It is started again by the next write.
+    _writer.reset();
+}
+
+void
+SharedObjectLibrary::writeSOL(const std::string& filespec,
+        SimpleBuffer&& data)
+{
+    if (!_writer) _writer.reset(new SOLWriter);
+    _writer->write(filespec, std::move(data));
 }
 
 SharedObjectLibrary::~SharedObjectLibrary()
@@ -899,13 +992,15 @@ readSOL(VM& vm, const std::string& filespec)
         return data;
     }
 
-    std::unique_ptr<std::uint8_t[]> sbuf(new std::uint8_t[size]);
-    const std::uint8_t *buf = sbuf.get();
+    // A lazy reader keeps the buffer until all objects are decoded.
+    std::shared_ptr<SimpleBuffer> sbuf = std::make_shared<SimpleBuffer>(size);
+    sbuf->resize(size);
+    const std::uint8_t *buf = sbuf->data();
     const std::uint8_t *end = buf + size;
 
     try {
         std::ifstream ifs(filespec.c_str(), std::ios::binary);
-        ifs.read(reinterpret_cast<char*>(sbuf.get()), size);
+        ifs.read(reinterpret_cast<char*>(sbuf->data()), size);
 
         // TODO check initial bytes, and print warnings if they are fishy
 
@@ -923,12 +1018,13 @@ readSOL(VM& vm, const std::string& filespec)
             return data;
         }
 
-        amf::Reader rd(buf, end, gl);
+        amf::Reader rd = rcfile.getSOLLazyDecode() ?
+            amf::Reader(buf, sbuf, gl) : amf::Reader(buf, end, gl);
 
         while (buf != end) {
 
             log_debug("readSOL: reading property name at "
-                      "byte %s", buf - sbuf.get());
+                      "byte %s", buf - sbuf->data());
             // read property name
             
             if (end - buf < 2) {
@@ -953,20 +1049,15 @@ readSOL(VM& vm, const std::string& filespec)
             std::string prop_name(reinterpret_cast<const char*>(buf), len);
             buf += len;
 
-            // read value
-            as_value as;
-
-            if (!rd(as)) {
+            // read value and set it as a member of this (SharedObject)
+            // object
+            if (!rd.readMember(*data, getURI(vm, prop_name))) {
                 log_error(_("SharedObject: error parsing SharedObject '%s'"),
                         filespec);
                 return nullptr;
             }
 
-            log_debug("parsed sol member named '%s' (len %s),  value '%s'",
-                    prop_name, len, as);
-
-            // set name/value as a member of this (SharedObject) object
-            data->set_member(getURI(vm, prop_name), as);
+            log_debug("parsed sol member named '%s' (len %s)", prop_name, len);
             
             if (buf == end) break;;
 
@@ -990,6 +1081,59 @@ flushSOL(SharedObjectLibrary::SoLib::value_type& sol)
     sol.second->flush();
 }
 
+bool
+replaceFile(const std::string& filespec, const SimpleBuffer& data)
+{
+    const std::string tmp = filespec + ".tmp";
+
+    std::FILE* f = std::fopen(tmp.c_str(), "wb");
+    if (!f) {
+        log_error(_("SharedObject::flush(): Failed opening file '%s' in binary"
+                    " mode"), tmp);
+        return false;
+    }
+
+    // The data must be on the disk before the rename, or a power loss
+    // can leave an empty SOL file behind.
+    bool written = std::fwrite(data.data(), 1, data.size(), f) == data.size()
+        && std::fflush(f) == 0;
+#if !defined(_WIN32) && !defined(_MSC_VER)
+    written = written && fsync(fileno(f)) == 0;
+#endif
+    written = std::fclose(f) == 0 && written;
+
+    if (!written) {
+        log_error(_("Error writing AMF data to output file %s"), tmp);
+        if (std::remove(tmp.c_str()) != 0) {
+            log_error(_("Error removing SOL output file %s: %s"), tmp,
+                      strerror(errno));
+        }
+        return false;
+    }
+
+    if (std::rename(tmp.c_str(), filespec.c_str()) != 0) {
+        log_error(_("Error renaming %s to %s: %s"), tmp, filespec,
+                  strerror(errno));
+        std::remove(tmp.c_str());
+        return false;
+    }
+
+#if !defined(_WIN32) && !defined(_MSC_VER)
+    // The rename itself is only safe once the directory is synced.
+    const std::string::size_type slash = filespec.rfind('/');
+    const std::string dir = slash == std::string::npos ? "." :
+        filespec.substr(0, slash + 1);
+    const int fd = open(dir.c_str(), O_RDONLY);
+    if (fd >= 0) {
+        fsync(fd);
+        close(fd);
+    }
+#endif
+
+    log_security(_("SharedObject '%s' written to filesystem."), filespec);
+    return true;
+}
+
 SharedObject_as*
 createSharedObject(Global_as& gl)
 {
@@ -22,12 +22,15 @@
 
 #include <string>
 #include <map>
+#include <memory>
 
 // Forward declarations
 namespace gnash {
     class as_object;
     struct ObjectURI;
     class SharedObject_as;
+    class SimpleBuffer;
+    class SOLWriter;
     class VM;
 }
 
@@ -51,7 +54,17 @@ public:
 
     void markReachableResources() const;
 
-    // Drop all library items
+    /// Write a SOL file in the background
+    //
+    /// The file is replaced once the data is completely written. If the
+    /// same file is written again before that, only the newest data
+    /// is written.
+    ///
+    /// @param filespec The SOL file to write.
+    /// @param data     The complete contents of the file.
+    void writeSOL(const std::string& filespec, SimpleBuffer&& data);
+
+    // Drop all library items, writing their SOL files
     void clear();
 
 private:
@@ -67,6 +80,9 @@ private:
     /// Base SOL dir
     std::string _solSafeDir;
     SoLib	_soLib;
+
+    /// Started on the first write.
+    std::unique_ptr<SOLWriter> _writer;
 };
 
 /// Initialize the global SharedObject class
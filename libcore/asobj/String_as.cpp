@@ -22,6 +22,7 @@
 #include <boost/algorithm/string/case_conv.hpp>
 #include <algorithm>
 #include <locale>
+#include <memory>
 #include <stdexcept>
 
 #include "SWFCtype.h"
@@ -65,18 +66,100 @@ namespace {
     size_t validIndex(const std::wstring& subject, int index);
     void attachStringInterface(as_object& o);
 
+    /// Return the characters of a String value, decoding them only if
+    /// necessary.
+    std::shared_ptr<const DecodedString> decode(const as_value& str,
+            int version);
+
     inline bool checkArgs(const fn_call& fn, size_t min, size_t max,
             const std::string& function);
 
     inline int getStringVersioned(const fn_call& fn, const as_value& arg,
-            std::string& str);
+            as_value& str);
+
+}
+
+/// The characters of a string, as the String methods use them.
+//
+/// Most methods index strings by character rather than by byte, so they
+/// need the characters decoded from UTF-8 (or Latin-1 for SWF5). Scripts
+/// tend to call many methods on the same string, for instance charAt()
+/// in a loop, so decode() keeps the result with the characters of the
+/// value (see as_value::getDecodedCache()).
+class DecodedString
+{
+public:
+
+    DecodedString(const std::string& str, int version);
+
+    /// Whether these are the characters of the string for a SWF version.
+    bool decodes(int version) const {
+        return _ascii || version == _version;
+    }
+
+    const std::wstring& chars() const {
+        return _chars;
+    }
+
+    /// Whether the characters are those decodeNextUnicodeCharacter()
+    /// returns one by one.
+    //
+    /// This is not the case for SWF5, which decodes Latin-1, or if the
+    /// string has invalid UTF-8 sequences, which decoding drops.
+    bool unicode() const {
+        return _unicode;
+    }
+
+    /// Return characters of the string, encoded for the SWF version.
+    //
+    /// ASCII strings need no encoding: their bytes are the characters.
+    std::string substr(size_t start, size_t count) const {
+        const std::wstring chars = _chars.substr(start, count);
+        if (_ascii) return std::string(chars.begin(), chars.end());
+        return utf8::encodeCanonicalString(chars, _version);
+    }
+
+private:
+
+    const int _version;
+
+    /// Whether all bytes are ASCII characters (not 0).
+    const bool _ascii;
 
+    bool _unicode;
+
+    std::wstring _chars;
+};
+
+DecodedString::DecodedString(const std::string& str, int version)
+    :
+    _version(version),
+    _ascii(std::all_of(str.begin(), str.end(), [](char c) {
+                const unsigned char u = c;
+                return u && u < 0x80;
+            })),
+    _unicode(_ascii)
+{
+    if (_ascii) {
+        _chars.assign(str.begin(), str.end());
+        return;
+    }
+
+    _chars = utf8::decodeCanonicalString(str, _version);
+
+    if (_version > 5) {
+        size_t codes = 0;
+        std::string::const_iterator it = str.begin(), e = str.end();
+        while (utf8::decodeNextUnicodeCharacter(it, e)) ++codes;
+        _unicode = (codes == _chars.size());
+    }
 }
 
-String_as::String_as(std::string s)
+String_as::String_as(as_value s)
     :
-    _string(std::move(s))
+    _value(std::move(s))
 {
+    assert(_value.is_string());
 }
 
 void
@@ -154,9 +237,10 @@ string_concat(const fn_call& fn)
 {
     as_value val(fn.this_ptr);
 
-    std::string str;
-    const int version = getStringVersioned(fn, val, str);
+    as_value value;
+    const int version = getStringVersioned(fn, val, value);
 
+    std::string str = value.getStringChars();
     for (size_t i = 0; i < fn.nargs; i++) {
         str += fn.arg(i).to_string(version);
     }
@@ -171,10 +255,11 @@ string_slice(const fn_call& fn)
 {
     as_value val(fn.this_ptr);
     
-    std::string str;
+    as_value str;
     const int version = getStringVersioned(fn, val, str);
 
-    std::wstring wstr = utf8::decodeCanonicalString(str, version);
+    const std::shared_ptr<const DecodedString> decoded = decode(str, version);
+    const std::wstring& wstr = decoded->chars();
 
     if (!checkArgs(fn, 1, 2, "String.slice()")) return as_value();
 
@@ -197,8 +282,7 @@ string_slice(const fn_call& fn)
 
     //log_debug("start: %d, end: %d, retlen: %d", start, end, retlen);
 
-    return as_value(utf8::encodeCanonicalString(
-                wstr.substr(start, retlen), version));
+    return as_value(decoded->substr(start, retlen));
 }
 
 // String.split(delimiter[, limit])
@@ -226,10 +310,11 @@ string_split(const fn_call& fn)
 {
     as_value val(fn.this_ptr);
     
-    std::string str;
+    as_value str;
     const int version = getStringVersioned(fn, val, str);
     
-    std::wstring wstr = utf8::decodeCanonicalString(str, version);
+    const std::shared_ptr<const DecodedString> decoded = decode(str, version);
+    const std::wstring& wstr = decoded->chars();
 
     Global_as& gl = getGlobal(fn);
     as_object* array = gl.createArray();
@@ -306,8 +391,7 @@ string_split(const fn_call& fn)
         if (delim.empty()) {
             for (size_t i = 0, e = std::min<size_t>(wstr.size(), max);
                     i < e; ++i) {
-                callMethod(array, NSV::PROP_PUSH,
-                       utf8::encodeCanonicalString(wstr.substr(i, 1), version));
+                callMethod(array, NSV::PROP_PUSH, decoded->substr(i, 1));
             }
             return as_value(array);
         }
@@ -320,8 +404,8 @@ string_split(const fn_call& fn)
     while (num < max) {
         pos = wstr.find(delim, pos);
 
-        callMethod(array, NSV::PROP_PUSH, utf8::encodeCanonicalString(
-                       wstr.substr(prevpos, pos - prevpos), version));
+        callMethod(array, NSV::PROP_PUSH,
+                decoded->substr(prevpos, pos - prevpos));
 
         if (pos == std::wstring::npos) break;
         num++;
@@ -341,16 +425,17 @@ string_lastIndexOf(const fn_call& fn)
 {
     as_value val(fn.this_ptr);
     
-    std::string str;
+    as_value str;
     const int version = getStringVersioned(fn, val, str);
-    const std::wstring& wstr = utf8::decodeCanonicalString(str, version);
+    const std::shared_ptr<const DecodedString> decoded = decode(str, version);
+    const std::wstring& wstr = decoded->chars();
 
     if (!checkArgs(fn, 1, 2, "String.lastIndexOf()")) return as_value(-1);
 
     const std::wstring& toFind = utf8::decodeCanonicalString(
         fn.arg(0).to_string(version), version);
 
-    int start = str.size();
+    int start = str.getStringChars().size();
 
     if (fn.nargs >= 2) {
         start = toInt(fn.arg(1), getVM(fn));
@@ -379,10 +464,11 @@ string_substr(const fn_call& fn)
 {
     as_value val(fn.this_ptr);
     
-    std::string str;
+    as_value str;
     const int version = getStringVersioned(fn, val, str);
 
-    std::wstring wstr = utf8::decodeCanonicalString(str, version);
+    const std::shared_ptr<const DecodedString> decoded = decode(str, version);
+    const std::wstring& wstr = decoded->chars();
 
     if (!checkArgs(fn, 1, 2, "String.substr()")) return as_value(str);
     
@@ -404,7 +490,7 @@ string_substr(const fn_call& fn)
         }
     }
 
-    return as_value(utf8::encodeCanonicalString(wstr.substr(start, num), version));
+    return as_value(decoded->substr(start, num));
 }
 
 // string.substring(start[, end])
@@ -417,10 +503,11 @@ string_substring(const fn_call& fn)
 {
     as_value val(fn.this_ptr);
     
-    std::string str;
+    as_value str;
     const int version = getStringVersioned(fn, val, str);
 
-    const std::wstring& wstr = utf8::decodeCanonicalString(str, version);
+    const std::shared_ptr<const DecodedString> decoded = decode(str, version);
+    const std::wstring& wstr = decoded->chars();
 
     if (!checkArgs(fn, 1, 2, "String.substring()")) return as_value(str);
 
@@ -461,7 +548,7 @@ string_substring(const fn_call& fn)
     end -= start;
     //log_debug("Start: %d, End: %d", start, end);
 
-    return as_value(utf8::encodeCanonicalString(wstr.substr(start, end), version));
+    return as_value(decoded->substr(start, end));
 }
 
 as_value
@@ -471,12 +558,13 @@ string_indexOf(const fn_call& fn)
  
     /// Do not return before this, because the toString method should always
     /// be called. (TODO: test).   
-    std::string str;
+    as_value str;
     const int version = getStringVersioned(fn, val, str);
 
     if (!checkArgs(fn, 1, 2, "String.indexOf")) return as_value(-1);
 
-    const std::wstring& wstr = utf8::decodeCanonicalString(str, version);
+    const std::shared_ptr<const DecodedString> decoded = decode(str, version);
+    const std::wstring& wstr = decoded->chars();
 
     const as_value& tfarg = fn.arg(0); // to find arg
     const std::wstring& toFind =
@@ -559,10 +647,11 @@ string_charCodeAt(const fn_call& fn)
 {
     as_value val(fn.this_ptr);
     
-    std::string str;
+    as_value str;
     const int version = getStringVersioned(fn, val, str);
 
-    const std::wstring& wstr = utf8::decodeCanonicalString(str, version);
+    const std::shared_ptr<const DecodedString> decoded = decode(str, version);
+    const std::wstring& wstr = decoded->chars();
 
     if (fn.nargs == 0) {
         IF_VERBOSE_ASCODING_ERRORS(
@@ -595,7 +684,7 @@ string_charAt(const fn_call& fn)
 {
     as_value val(fn.this_ptr);
     
-    std::string str;
+    as_value str;
     const int version = getStringVersioned(fn, val, str);
 
     if (!checkArgs(fn, 1, 1, "String.charAt()")) return as_value("");
@@ -603,9 +692,18 @@ string_charAt(const fn_call& fn)
     // to_int() makes this safe from overflows.
     const size_t index = static_cast<size_t>(toInt(fn.arg(0), getVM(fn)));
 
+    const std::shared_ptr<const DecodedString> decoded = decode(str, version);
+    if (decoded->unicode()) {
+        if (index >= decoded->chars().size()) return as_value("");
+        return as_value(decoded->substr(index, 1));
+    }
+
+    // Otherwise this counts the characters differently from other
+    // methods.
     size_t currentIndex = 0;
 
-    std::string::const_iterator it = str.begin(), e = str.end();
+    const std::string& chars = str.getStringChars();
+    std::string::const_iterator it = chars.begin(), e = chars.end();
 
     while (std::uint32_t code = utf8::decodeNextUnicodeCharacter(it, e))
     {
@@ -629,10 +727,10 @@ string_toUpperCase(const fn_call& fn)
 {
     as_value val(fn.this_ptr);
 
-    std::string str;
+    as_value str;
     const int version = getStringVersioned(fn, val, str);
 
-    std::wstring wstr = utf8::decodeCanonicalString(str, version);
+    std::wstring wstr = decode(str, version)->chars();
 
 #if !defined(__HAIKU__) && !defined(__amigaos4__) && !defined(__ANDROID__)
     static const std::locale swfLocale((std::locale()), new SWFCtype());
@@ -655,10 +753,10 @@ string_toLowerCase(const fn_call& fn)
 {
     as_value val(fn.this_ptr);
     
-    std::string str;
+    as_value str;
     const int version = getStringVersioned(fn, val, str);
 
-    std::wstring wstr = utf8::decodeCanonicalString(str, version);
+    std::wstring wstr = decode(str, version)->chars();
 
 #if !defined(__HAIKU__) && !defined(__amigaos4__) && !defined(__ANDROID__)
     static const std::locale swfLocale((std::locale()), new SWFCtype());
@@ -704,6 +802,9 @@ string_oldToUpper(const fn_call& fn)
 as_value
 string_valueOf(const fn_call& fn)
 {
+    String_as* str;
+    if (isNativeType(fn.this_ptr, str)) return str->value();
+
     const int version = getSWFVersion(fn);
     return as_value(fn.this_ptr).to_string(version);
 }
@@ -712,7 +813,7 @@ as_value
 string_toString(const fn_call& fn)
 {
     String_as* str = ensure<ThisIsNative<String_as> >(fn);
-    return as_value(str->value());
+    return str->value();
 }
 
 
@@ -721,28 +822,31 @@ string_ctor(const fn_call& fn)
 {
     const int version = getSWFVersion(fn);
 
-    std::string str;
+    // A String argument is kept as it is, so that its characters (and
+    // their decoded form) are shared rather than copied.
+    as_value str("");
 
     if (fn.nargs) {
-        str = fn.arg(0).to_string(version);
+        const as_value& arg = fn.arg(0);
+        str = arg.is_string() ? arg : as_value(arg.to_string(version));
     }
 
     if (!fn.isInstantiation())
     {
-        return as_value(str);
+        return str;
     }
     
     as_object* obj = fn.this_ptr;
 
     obj->setRelay(new String_as(str));
-    std::wstring wstr = utf8::decodeCanonicalString(str, getSWFVersion(fn));
-    obj->init_member(NSV::PROP_LENGTH, wstr.size(), as_object::DefaultFlags);
+    const size_t length = decode(str, version)->chars().size();
+    obj->init_member(NSV::PROP_LENGTH, length, as_object::DefaultFlags);
 
     return as_value();
 }
     
 inline int
-getStringVersioned(const fn_call& fn, const as_value& val, std::string& str)
+getStringVersioned(const fn_call& fn, const as_value& val, as_value& str)
 {
 
     /// version to use is the one of the SWF containing caller code.
@@ -758,6 +862,13 @@ getStringVersioned(const fn_call& fn, const as_value& val, std::string& str)
 
     const int version = fn.callerDef ? fn.callerDef->get_version() :
         getSWFVersion(fn);
+
+    // A String object shares its value rather than converting it.
+    String_as* s;
+    if (isNativeType(val.get_object(), s)) {
+        str = s->value();
+        return version;
+    }
     
     str = val.to_string(version);
 
@@ -795,6 +906,21 @@ inline bool checkArgs(const fn_call& fn, size_t min, size_t max,
     return true;
 }
 
+std::shared_ptr<const DecodedString>
+decode(const as_value& str, int version)
+{
+    // The result is shared because the cache may be replaced while a
+    // method uses it, if ActionScript (valueOf, toString) decodes the
+    // same characters for another SWF version.
+    std::shared_ptr<const DecodedString>* cache = str.getDecodedCache();
+    if (cache && *cache && (*cache)->decodes(version)) return *cache;
+
+    std::shared_ptr<const DecodedString> d =
+        std::make_shared<const DecodedString>(str.getStringChars(), version);
+    if (cache) *cache = d;
+    return d;
+}
+
 size_t
 validIndex(const std::wstring& subject, int index)
 {
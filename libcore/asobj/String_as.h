@@ -21,8 +21,8 @@
 #ifndef GNASH_STRING_H
 #define GNASH_STRING_H
 
-#include <string>
 #include "Relay.h"
+#include "as_value.h"
 
 namespace gnash {
 
@@ -35,14 +35,15 @@ class String_as : public Relay
 
 public:
 
-    explicit String_as(std::string s);
+    /// @param s    A String value, whose characters the object shares.
+    explicit String_as(as_value s);
 
-    const std::string& value() {
-        return _string;
+    const as_value& value() const {
+        return _value;
     }
 
 private:
-    std::string _string;
+    const as_value _value;
 };
 
 /// Initialize the global String class
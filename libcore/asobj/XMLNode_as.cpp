@@ -43,7 +43,7 @@ namespace gnash {
 namespace {
     typedef std::pair<std::string, std::string> StringPair;
     typedef std::vector<StringPair> StringPairs;
-    void enumerateAttributes(const XMLNode_as& node,
+    void enumerateAttributes(const XMLNode_as& node, string_table& st,
             StringPairs& attributes);
     bool prefixMatches(const StringPairs::value_type& val,
             const std::string& prefix);
@@ -81,7 +81,7 @@ XMLNode_as::XMLNode_as(Global_as& gl)
     _global(gl),
     _object(nullptr),
     _parent(nullptr),
-    _attributes(new as_object(gl)),
+    _attributes(nullptr),
     _childNodes(nullptr),
     _type(Element)
 {
@@ -92,7 +92,7 @@ XMLNode_as::XMLNode_as(const XMLNode_as& tpl, bool deep)
     _global(tpl._global),
     _object(nullptr),
     _parent(nullptr),
-    _attributes(new as_object(_global)),
+    _attributes(nullptr),
     _childNodes(nullptr),
     _name(tpl._name),
     _value(tpl._value),
@@ -309,13 +309,27 @@ XMLNode_as::toString(std::ostream& xmlout, bool encode) const
     stringify(*this, xmlout, encode);
 }
 
+as_object*
+XMLNode_as::getAttributes() const
+{
+    if (!_attributes) {
+        _attributes = new as_object(_global);
+
+        // Properties are enumerated in the reverse order of creation.
+        for (Attributes::const_reverse_iterator i = _parsedAttributes.rbegin(),
+                e = _parsedAttributes.rend(); i != e; ++i) {
+            _attributes->set_member(i->first, i->second);
+        }
+        Attributes().swap(_parsedAttributes);
+    }
+    return _attributes;
+}
+
 void
 XMLNode_as::setAttribute(const std::string& name, const std::string& value)
 {
-    if (_attributes) {
-        VM& vm = getVM(_global);
-        _attributes->set_member(getURI(vm, name), value);
-    }
+    VM& vm = getVM(_global);
+    getAttributes()->set_member(getURI(vm, name), value);
 }
 
 bool
@@ -327,7 +341,7 @@ XMLNode_as::getPrefixForNamespace(const std::string& ns, std::string& prefix)
     StringPairs attrs;
     
     while (node) {
-        enumerateAttributes(*node, attrs);
+        enumerateAttributes(*node, getStringTable(_global), attrs);
         if (!attrs.empty())
         {
             it = std::find_if(attrs.begin(), attrs.end(), 
@@ -366,7 +380,7 @@ XMLNode_as::getNamespaceForPrefix(const std::string& prefix, std::string& ns)
     
     while (node) {
 
-        enumerateAttributes(*node, attrs);
+        enumerateAttributes(*node, getStringTable(_global), attrs);
 
         if (!attrs.empty()) {
 
@@ -438,7 +452,7 @@ XMLNode_as::stringify(const XMLNode_as& xml, std::ostream& xmlout, bool encode)
 
         // Process the attributes, if any
         StringPairs attrs;
-        enumerateAttributes(xml, attrs);
+        enumerateAttributes(xml, getStringTable(xml._global), attrs);
         if (!attrs.empty()) {
 
             for (auto& attr : attrs) { 
@@ -1029,13 +1043,23 @@ xmlnode_childNodes(const fn_call& fn)
 
 
 void
-enumerateAttributes(const XMLNode_as& node, StringPairs& pairs)
+enumerateAttributes(const XMLNode_as& node, string_table& st,
+        StringPairs& pairs)
 {
     pairs.clear();
 
+    // Attributes that have not been accessed need no object.
+    const XMLNode_as::Attributes* parsed = node.parsedAttributes();
+    if (parsed) {
+        for (const auto& attr : *parsed) {
+            pairs.push_back(std::make_pair(attr.first.toString(st),
+                        attr.second));
+        }
+        return;
+    }
+
     as_object* obj = node.getAttributes();
     if (obj) {
-        string_table& st = getStringTable(*obj);
         SortedPropertyList attrs = enumerateProperties(*obj);
         for (SortedPropertyList::const_reverse_iterator i = attrs.rbegin(), 
                 e = attrs.rend(); i != e; ++i) {
@@ -22,14 +22,16 @@
 
 #include <list>
 #include <string>
+#include <vector>
+#include <utility>
 #include <cassert>
 
 #include "Relay.h"
+#include "ObjectURI.h"
 
 namespace gnash {
     class as_object;
     class Global_as;
-    struct ObjectURI;
 }
 
 namespace gnash {
@@ -50,6 +52,8 @@ namespace gnash {
 /// 5. When an XMLNode is destroyed, any children without an associated object
 ///    are also deleted. Children with an associated object will be destroyed
 ///    when the GC destroys the object.
+/// 6. Parsed attributes are kept as strings. The attributes object is only
+///    created once it is needed.
 class XMLNode_as : public Relay
 {
 public:
@@ -88,12 +92,12 @@ public:
     }
 
     /// Set name of this node
-    void nodeNameSet(const std::string& name) { _name = name; }
+    void nodeNameSet(std::string name) { _name = std::move(name); }
 
     bool extractPrefix(std::string& prefix) const;
 
     /// Set value of this node
-    void nodeValueSet(const std::string& value) { _value = value; }
+    void nodeValueSet(std::string value) { _value = std::move(value); }
 
     /// Performs a recursive search of node attributes to find a match
     void getNamespaceForPrefix(const std::string& prefix, std::string& ns)
@@ -189,8 +193,30 @@ public:
     ///                 for XML.sendAndLoad.
     virtual void toString(std::ostream& str, bool encode = false) const;
 
+    /// Attribute names and values, in enumeration order.
+    typedef std::vector<std::pair<ObjectURI, std::string> > Attributes;
+
     /// Return the attributes object associated with this node.
-    as_object* getAttributes() const { return _attributes; }
+    //
+    /// The object is created on first access, from any parsed attributes.
+    as_object* getAttributes() const;
+
+    /// Return the parsed attributes if there is no attributes object yet.
+    //
+    /// @return     0 if the attributes object has been created; it is
+    ///             then the only record of the attributes.
+    const Attributes* parsedAttributes() const {
+        return _attributes ? nullptr : &_parsedAttributes;
+    }
+
+    /// Set the attributes of a newly parsed node.
+    //
+    /// @param attrs    The attributes, in enumeration order and without
+    ///                 duplicates. They replace any parsed attributes.
+    void setParsedAttributes(Attributes attrs) {
+        assert(!_attributes);
+        _parsedAttributes = std::move(attrs);
+    }
 
     /// Set a named attribute to a value.
     //
@@ -254,7 +280,11 @@ private:
 
     XMLNode_as* _parent;
 
-    as_object* _attributes;
+    /// Created on first access by getAttributes().
+    mutable as_object* _attributes;
+
+    /// Only used until the attributes object is created.
+    mutable Attributes _parsedAttributes;
 
     as_object* _childNodes;
 
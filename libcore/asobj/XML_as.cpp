@@ -23,6 +23,7 @@
 #include <sstream>
 #include <vector>
 #include <algorithm>
+#include <cstring>
 #include <boost/algorithm/string/compare.hpp>
 #include <boost/algorithm/string/replace.hpp>
 
@@ -58,11 +59,12 @@ namespace {
 
     typedef XML_as::xml_iterator xml_iterator;
 
+    inline bool isWhitespace(char c);
     bool textAfterWhitespace(xml_iterator& it, xml_iterator end);
     bool textMatch(xml_iterator& it, xml_iterator end,
-            const std::string& match, bool advance = true);
+            const char* match, bool advance = true);
     bool parseNodeWithTerminator( xml_iterator& it, xml_iterator end,
-            const std::string& terminator, std::string& content);
+            const char* terminator, std::string& content);
 
     void setIdMap(as_object& xml, XMLNode_as& childNode,
             const std::string& val);
@@ -114,6 +116,9 @@ escapeXML(std::string& text)
 void
 unescapeXML(std::string& text)
 {
+    // Most text has no entities at all.
+    if (text.find('&') == std::string::npos) return;
+
     const Entities& ent = getEntities();
 
     for (const auto& entity : ent) {
@@ -142,21 +147,14 @@ void
 XML_as::parseAttribute(XMLNode_as* node, xml_iterator& it,
         const xml_iterator end, Attributes& attributes)
 {
-    const std::string terminators("\r\t\n >=");
-
-    xml_iterator ourend = std::find_first_of(it, end,
-            terminators.begin(), terminators.end());
+    xml_iterator ourend = std::find_if(it, end,
+            [](char c) { return isWhitespace(c) || c == '>' || c == '='; });
 
-    if (ourend == end) {
-        _status = XML_UNTERMINATED_ELEMENT;
-        return;
-    }
-    std::string name(it, ourend);
-    
-    if (name.empty()) {
+    if (ourend == end || ourend == it) {
         _status = XML_UNTERMINATED_ELEMENT;
         return;
     }
+    const std::string name(it, ourend);
 
     // Point iterator to the DisplayObject after the name.
     it = ourend;
@@ -213,9 +211,14 @@ XML_as::parseAttribute(XMLNode_as* node, xml_iterator& it,
         node->setNamespaceURI(value);
     }
 
-    // This ensures values are not inserted twice, which is expected
-    // behaviour
-    attributes.insert(std::make_pair(name, value));
+    // Only the first of any attributes with the same name is kept, which is
+    // expected behaviour. Tags rarely have more than a few attributes.
+    VM& vm = getVM(_global);
+    string_table& st = vm.getStringTable();
+    for (const auto& attr : attributes) {
+        if (noCaseCompare(attr.first.toString(st), name)) return;
+    }
+    attributes.push_back(std::make_pair(getURI(vm, name), std::move(value)));
 
 }
 
@@ -279,10 +282,8 @@ XML_as::parseTag(XMLNode_as*& node, xml_iterator& it,
     if (closing) ++it;
 
     // These are for terminating the tag name, not (necessarily) the tag.
-    const std::string terminators("\r\n\t >");
-
-    xml_iterator endName = std::find_first_of(it, end, terminators.begin(),
-            terminators.end());
+    xml_iterator endName = std::find_if(it, end,
+            [](char c) { return isWhitespace(c) || c == '>'; });
 
     // Check that one of the terminators was found; otherwise it's malformed.
     if (endName == end) {
@@ -317,12 +318,12 @@ XML_as::parseTag(XMLNode_as*& node, xml_iterator& it,
         }
 
         XMLNode_as* childNode = new XMLNode_as(_global);
-        childNode->nodeNameSet(tagName);
+        childNode->nodeNameSet(std::move(tagName));
         childNode->nodeTypeSet(Element);
 
         // Parse any attributes in an opening tag only, stopping at "/>" or
-        // '>'
-        // Attributes are added in reverse order and without any duplicates.
+        // '>'. They are interned but only made into an object if ActionScript
+        // asks for them.
         Attributes attributes;
         while (it != end && *it != '>' && _status == XML_OK)
         {
@@ -349,10 +350,22 @@ XML_as::parseTag(XMLNode_as*& node, xml_iterator& it,
         // first.
         node->appendChild(childNode);
 
-        for (Attributes::const_reverse_iterator i = attributes.rbegin(),
-                e = attributes.rend(); i != e; ++i) {
-            childNode->setAttribute(i->first, i->second);
-            if (i->first == "id") setIdMap(*object(), *childNode, i->second);
+        // Attributes are enumerated in case-insensitive order of their names.
+        if (!attributes.empty()) {
+            string_table& st = getStringTable(_global);
+            std::sort(attributes.begin(), attributes.end(),
+                [&st](const Attributes::value_type& a,
+                      const Attributes::value_type& b) {
+                    return StringNoCaseLessThan()(a.first.toString(st),
+                        b.first.toString(st));
+                });
+
+            for (const auto& attr : attributes) {
+                if (attr.first.toString(st) == "id") {
+                    setIdMap(*object(), *childNode, attr.second);
+                }
+            }
+            childNode->setParsedAttributes(std::move(attributes));
         }
 
         if (*it == '/') ++it;
@@ -402,13 +415,16 @@ XML_as::parseText(XMLNode_as* node, xml_iterator& it,
         const xml_iterator end, bool iw)
 {
     xml_iterator ourend = std::find(it, end, '<');
+
+    // Whitespace is skipped before copying anything.
+    if (iw && std::all_of(it, ourend, isWhitespace)) {
+        it = ourend;
+        return;
+    }
+
     std::string content(it, ourend);
-    
     it = ourend;
 
-    if (iw && 
-        content.find_first_not_of("\t\r\n ") == std::string::npos) return;
-
     XMLNode_as* childNode = new XMLNode_as(_global);
 
     childNode->nodeTypeSet(XMLNode_as::Text);
@@ -416,7 +432,7 @@ XML_as::parseText(XMLNode_as* node, xml_iterator& it,
     // Replace any entitites.
     unescapeXML(content);
 
-    childNode->nodeValueSet(content);
+    childNode->nodeValueSet(std::move(content));
     node->appendChild(childNode);
 
 }
@@ -447,7 +463,7 @@ XML_as::parseCData(XMLNode_as* node, xml_iterator& it,
     }
 
     XMLNode_as* childNode = new XMLNode_as(_global);
-    childNode->nodeValueSet(content);
+    childNode->nodeValueSet(std::move(content));
     childNode->nodeTypeSet(Text);
     node->appendChild(childNode);
 }
@@ -849,19 +865,26 @@ xml_onData(const fn_call& fn)
 /// is not false, the iterator points to the DisplayObject after the match.
 bool
 textMatch(xml_iterator& it, const xml_iterator end,
-        const std::string& match, bool advance)
+        const char* match, bool advance)
 {
-    const std::string::size_type len = match.length();
+    const size_t len = std::strlen(match);
 
     if (static_cast<size_t>(end - it) < len) return false;
 
-    if (!std::equal(it, it + len, match.begin(), boost::is_iequal())) {
+    if (!std::equal(it, it + len, match, boost::is_iequal())) {
         return false;
     }
     if (advance) it += len;
     return true;
 }
 
+/// Whitespace as understood by the XML parser.
+inline bool
+isWhitespace(char c)
+{
+    return c == ' ' || c == '\n' || c == '\t' || c == '\r';
+}
+
 /// Advance past whitespace
 //
 /// @return true if there is text after the whitespace, false if we 
@@ -869,8 +892,7 @@ textMatch(xml_iterator& it, const xml_iterator end,
 bool
 textAfterWhitespace(xml_iterator& it, const xml_iterator end)
 {
-    const std::string whitespace("\r\t\n ");
-    while (it != end && whitespace.find(*it) != std::string::npos) ++it;
+    while (it != end && isWhitespace(*it)) ++it;
     return (it != end);
 }
 
@@ -886,17 +908,17 @@ textAfterWhitespace(xml_iterator& it, const xml_iterator end)
 /// @param xml      The complete XML string.
 bool
 parseNodeWithTerminator(xml_iterator& it, const xml_iterator end,
-        const std::string& terminator, std::string& content)
+        const char* terminator, std::string& content)
 {
-    xml_iterator ourend = std::search(it, end, terminator.begin(),
-            terminator.end());
+    const size_t len = std::strlen(terminator);
+    xml_iterator ourend = std::search(it, end, terminator, terminator + len);
 
     if (ourend == end) {
         return false;
     }
 
-    content = std::string(it, ourend);
-    it = ourend + terminator.length();
+    content.assign(it, ourend);
+    it = ourend + len;
 
     return true;
 }
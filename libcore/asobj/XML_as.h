@@ -148,8 +148,6 @@ public:
 
 private:
 
-    typedef std::map<std::string, std::string, StringNoCaseLessThan> Attributes;
-
     void parseTag(XMLNode_as*& node, xml_iterator& it, xml_iterator end);
 
     void parseAttribute(XMLNode_as* node, xml_iterator& it,
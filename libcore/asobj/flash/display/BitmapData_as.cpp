@@ -29,9 +29,13 @@
 #include <boost/tuple/tuple.hpp>
 #include <array>
 #include <cmath>
+#include <cassert>
+#include <cstring>
+#include <functional>
 
 #include "MovieClip.h"
 #include "GnashImage.h"
+#include "ImageIterators.h"
 #include "DisplayObject.h"
 #include "as_object.h"
 #include "log.h"
@@ -50,6 +54,7 @@
 #include "NativeFunction.h"
 #include "GnashNumeric.h"
 #include "Array_as.h"
+#include "Filters.h"
 
 namespace gnash {
 
@@ -84,19 +89,22 @@ namespace {
     as_value bitmapdata_width(const fn_call& fn);
     as_value bitmapdata_loadBitmap(const fn_call& fn);
     as_value bitmapdata_compare(const fn_call& fn);
+    as_value bitmapdata_lock(const fn_call& fn);
+    as_value bitmapdata_unlock(const fn_call& fn);
     as_value bitmapdata_ctor(const fn_call& fn);
 
     void attachBitmapDataInterface(as_object& o);
     void attachBitmapDataStaticProperties(as_object& o);
     as_value get_flash_display_bitmap_data_constructor(const fn_call& fn);
 
-    /// Get an iterator to the pixel at (x, y)
+    /// Get a pointer to the stored pixel at (x, y)
     //
     /// Please note: each invocation of this function must check for and
     /// retrieve the stored bitmap data, so if you need more than one pixel,
-    /// call this once and work out how much you need to move the iterator.
-    BitmapData_as::iterator pixelAt(const BitmapData_as& bd, size_t x,
-            size_t y);
+    /// call this once and work out how much you need to move the pointer.
+    //
+    /// @return     0 if (x, y) is outside the BitmapData.
+    std::uint32_t* pixelAt(const BitmapData_as& bd, size_t x, size_t y);
 
     /// Set the pixel at (x, y) to the specified ARGB colour.
     //
@@ -131,6 +139,10 @@ namespace {
 
     std::uint8_t getChannel(std::uint32_t src, std::uint8_t bitmask);
 
+    /// Fill the area of pixels equal to old around (startx, starty).
+    //
+    /// @param old      The stored pixel value to replace.
+    /// @param fill     The stored pixel value to fill with.
     void floodFill(const BitmapData_as& bd, size_t startx, size_t starty,
             std::uint32_t old, std::uint32_t fill);
 
@@ -150,6 +162,49 @@ namespace {
     inline bool oneBitSet(std::uint8_t mask) {
         return mask == (mask & -mask);
     }
+
+    /// Read the x, y, width and height of a Rectangle.
+    //
+    /// This can be any object with the right properties.
+    void getRect(as_object& rect, VM& vm, int& x, int& y, int& w, int& h);
+
+    /// Read the x and y of a Point.
+    //
+    /// This can be any object with the right properties.
+    void getPoint(as_object& point, VM& vm, int& x, int& y);
+
+    /// Get the part of a rectangle that can be copied between two bitmaps
+    //
+    /// On return, (sourceX, sourceY, w, h) is wholly inside source and
+    /// (destX, destY, w, h) wholly inside dest. If nothing can be copied,
+    /// either w or h will be 0.
+    void clipCopy(const BitmapData_as& source, const BitmapData_as& dest,
+            int& sourceX, int& sourceY, int& w, int& h, int& destX,
+            int& destY);
+
+    /// Read the source, source rectangle and destination point arguments
+    /// of a pixel operation.
+    //
+    /// The first three arguments must be present. The copied area is
+    /// clipped to both bitmaps as by clipCopy().
+    //
+    /// @return     The source BitmapData, or 0 if the arguments are invalid
+    ///             or there is nothing to copy.
+    BitmapData_as* getCopyArea(const fn_call& fn, const BitmapData_as& dest,
+            int& sourceX, int& sourceY, int& w, int& h, int& destX,
+            int& destY);
+
+    /// Create a flash.geom.Rectangle
+    //
+    /// @return     The new Rectangle or 0 if it could not be constructed.
+    as_object* createRectangle(const fn_call& fn, double x, double y,
+            double w, double h);
+
+    /// Create a BitmapData object with the same prototype as this one.
+    //
+    /// @param im   Premultiplied RGBA pixels, as stored by BitmapData_as.
+    as_object* createBitmapData(const fn_call& fn,
+            std::unique_ptr<image::GnashImage> im, bool transparent);
 }
 
 /// Local functors.
@@ -246,12 +301,8 @@ private:
 //
 /// Due to peculiarities in the Adobe implementation, this also supports
 /// setting them to black.
-template<typename Iterator>
 struct CopyChannel
 {
-    typedef boost::tuple<Iterator, Iterator> iterator_tuple;
-    typedef boost::zip_iterator<iterator_tuple> iterator_type;
-
     CopyChannel(bool multiple, std::uint8_t srcchans,
             std::uint8_t destchans)
         :
@@ -260,12 +311,12 @@ struct CopyChannel
         _destchans(destchans)
     {}
 
-    std::uint32_t operator()(typename iterator_type::value_type p) const {
+    /// Return the destination ARGB value with the copied channel.
+    std::uint32_t operator()(std::uint32_t src, std::uint32_t dest) const {
         // If multiple source channels, we set the destination channel
         // to black. Else to the value of the requested channel.
-        const std::uint8_t val = _multiple ?
-            0 : getChannel(boost::get<0>(p), _srcchans);
-        return setChannel(boost::get<1>(p), _destchans, val);
+        const std::uint8_t val = _multiple ? 0 : getChannel(src, _srcchans);
+        return setChannel(dest, _destchans, val);
     }
 
 private:
@@ -551,13 +602,13 @@ private:
     std::vector<Vector> _offsets;
 };
 
-/// Index iterators by x and y position
+/// Index pixels by x and y position
 //
 /// This is a helper for floodFill to avoid using the expensive
 /// pixelAt() many times.
 struct PixelIndexer
 {
-    PixelIndexer(size_t xpos, size_t ypos, BitmapData_as::iterator p)
+    PixelIndexer(size_t xpos, size_t ypos, std::uint32_t* p)
         :
         x(xpos),
         y(ypos),
@@ -565,7 +616,7 @@ struct PixelIndexer
     {}
     size_t x;
     size_t y;
-    BitmapData_as::iterator pix;
+    std::uint32_t* pix;
 };
 
 /// Convert an array to a vector of offsets.
@@ -594,16 +645,521 @@ private:
     VM& _vm;
 };
 
+/// Read and write the rows of a rectangle of a BitmapData.
+//
+/// The pixel operations below work on whole rows of 32-bit ARGB values,
+/// which the compiler can vectorize. The stored pixels are converted
+/// on reading and writing.
+class RowAccess
+{
+public:
+    RowAccess(const BitmapData_as& bd, int x, int y, int w)
+        :
+        _bd(bd),
+        _begin(pixelAt(bd, x, y)),
+        _stride(bd.width()),
+        _row(w)
+    {}
+
+    /// Read a row, counted from the top of the rectangle.
+    std::uint32_t* read(int y) {
+        const std::uint32_t* p = _begin + y * _stride;
+        std::transform(p, p + _row.size(), _row.begin(),
+                BitmapData_as::toARGB);
+        return _row.data();
+    }
+
+    /// Write a row, counted from the top of the rectangle.
+    void write(int y, const std::uint32_t* row) {
+        std::uint32_t* p = _begin + y * _stride;
+        for (size_t i = 0, e = _row.size(); i < e; ++i) {
+            p[i] = _bd.toPixel(row[i]);
+        }
+    }
+
+private:
+    const BitmapData_as& _bd;
+    std::uint32_t* const _begin;
+    const size_t _stride;
+    std::vector<std::uint32_t> _row;
+};
+
+/// Apply a row operation to an area copied from one bitmap to another.
+//
+/// The operation is called as op(dest, source, width) and changes the
+/// destination row in place. If both bitmaps are the same and the
+/// destination is below the source, the rows are processed from the
+/// bottom so that none is changed before it has been read.
+template<typename RowOp>
+void
+copyRows(const BitmapData_as& source, int sourceX, int sourceY,
+        const BitmapData_as& dest, int destX, int destY, int w, int h,
+        RowOp op)
+{
+    RowAccess src(source, sourceX, sourceY, w);
+    RowAccess dst(dest, destX, destY, w);
+
+    const bool upwards = (&source == &dest) && destY > sourceY;
+
+    for (int i = 0; i < h; ++i) {
+        const int y = upwards ? h - 1 - i : i;
+        // Each RowAccess has its own buffer, so the source row is intact
+        // even if it is the destination row.
+        const std::uint32_t* s = src.read(y);
+        std::uint32_t* d = dst.read(y);
+        op(d, s, w);
+        dst.write(y, d);
+    }
+}
+
+inline std::uint32_t
+transformChannel(std::uint32_t c, int mult, int add)
+{
+    const int v = ((static_cast<int>(c) * mult) >> 8) + add;
+    return v < 0 ? 0 : v > 255 ? 255 : v;
+}
+
+/// Apply a colour transform to a row of pixels.
+void
+colorTransformRow(std::uint32_t* p, size_t n, const SWFCxForm& cx)
+{
+    const int ra = cx.ra, ga = cx.ga, ba = cx.ba, aa = cx.aa;
+    const int rb = cx.rb, gb = cx.gb, bb = cx.bb, ab = cx.ab;
+
+    for (size_t i = 0; i < n; ++i) {
+        const std::uint32_t c = p[i];
+        p[i] = transformChannel(c >> 24, aa, ab) << 24 |
+               transformChannel((c >> 16) & 0xff, ra, rb) << 16 |
+               transformChannel((c >> 8) & 0xff, ga, gb) << 8 |
+               transformChannel(c & 0xff, ba, bb);
+    }
+}
+
+inline std::uint32_t
+mergeChannel(std::uint32_t s, std::uint32_t d, std::uint32_t m)
+{
+    return (s * m + d * (256 - m)) >> 8;
+}
+
+/// Blend a row of source pixels into a row of destination pixels.
+struct MergeRow
+{
+    MergeRow(std::uint32_t r, std::uint32_t g, std::uint32_t b,
+            std::uint32_t a)
+        :
+        _r(r), _g(g), _b(b), _a(a)
+    {}
+
+    void operator()(std::uint32_t* d, const std::uint32_t* s,
+            size_t n) const {
+        for (size_t i = 0; i < n; ++i) {
+            const std::uint32_t sp = s[i];
+            const std::uint32_t dp = d[i];
+            d[i] = mergeChannel(sp >> 24, dp >> 24, _a) << 24 |
+                   mergeChannel((sp >> 16) & 0xff, (dp >> 16) & 0xff, _r) << 16 |
+                   mergeChannel((sp >> 8) & 0xff, (dp >> 8) & 0xff, _g) << 8 |
+                   mergeChannel(sp & 0xff, dp & 0xff, _b);
+        }
+    }
+
+private:
+    const std::uint32_t _r, _g, _b, _a;
+};
+
+/// Replace the pixels of a row that pass a test against a threshold.
+//
+/// The number of pixels that passed is added to the count.
+template<typename Compare>
+struct ThresholdRow
+{
+    ThresholdRow(std::uint32_t threshold, std::uint32_t color,
+            std::uint32_t mask, bool copySource, size_t& count)
+        :
+        _threshold(threshold & mask),
+        _color(color),
+        _mask(mask),
+        _copySource(copySource),
+        _count(count)
+    {}
+
+    void operator()(std::uint32_t* d, const std::uint32_t* s,
+            size_t n) const {
+        const Compare cmp = Compare();
+        size_t count = 0;
+        for (size_t i = 0; i < n; ++i) {
+            const bool pass = cmp(s[i] & _mask, _threshold);
+            const std::uint32_t other = _copySource ? s[i] : d[i];
+            d[i] = pass ? _color : other;
+            count += pass;
+        }
+        _count += count;
+    }
+
+private:
+    const std::uint32_t _threshold;
+    const std::uint32_t _color;
+    const std::uint32_t _mask;
+    const bool _copySource;
+    size_t& _count;
+};
+
+/// Map each channel of a row of pixels through a table.
+//
+/// The result is the sum of the values found for each channel.
+struct PaletteRow
+{
+    typedef std::array<std::uint32_t, 256> Table;
+
+    PaletteRow(const Table& r, const Table& g, const Table& b,
+            const Table& a)
+        :
+        _r(r), _g(g), _b(b), _a(a)
+    {}
+
+    void operator()(std::uint32_t* d, const std::uint32_t* s,
+            size_t n) const {
+        for (size_t i = 0; i < n; ++i) {
+            const std::uint32_t p = s[i];
+            d[i] = _a[p >> 24] + _r[(p >> 16) & 0xff] +
+                   _g[(p >> 8) & 0xff] + _b[p & 0xff];
+        }
+    }
+
+private:
+    const Table& _r;
+    const Table& _g;
+    const Table& _b;
+    const Table& _a;
+};
+
+/// Fill a palette table from an array.
+//
+/// Missing elements map to 0.
+struct TablePusher
+{
+    TablePusher(PaletteRow::Table& table, VM& vm)
+        :
+        _table(table),
+        _vm(vm),
+        _index(0)
+    {
+        _table.fill(0);
+    }
+
+    void operator()(const as_value& val) {
+        if (_index == _table.size()) return;
+        _table[_index++] = toInt(val, _vm);
+    }
+
+private:
+    PaletteRow::Table& _table;
+    VM& _vm;
+    size_t _index;
+};
+
+inline std::int64_t
+gcd(std::int64_t a, std::int64_t b)
+{
+    while (b) {
+        const std::int64_t t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+/// Whether any pixel of a row has at least the given alpha.
+inline bool
+alphaHit(const std::uint32_t* p, size_t n, std::uint32_t threshold)
+{
+    bool hit = false;
+    for (size_t i = 0; i < n; ++i) {
+        hit |= (p[i] >> 24) >= threshold;
+    }
+    return hit;
+}
+
+/// Whether a pixel in the same place in two rows has at least the given
+/// alpha in both.
+inline bool
+alphaHit(const std::uint32_t* a, const std::uint32_t* b, size_t n,
+        std::uint32_t thresholdA, std::uint32_t thresholdB)
+{
+    bool hit = false;
+    for (size_t i = 0; i < n; ++i) {
+        hit |= ((a[i] >> 24) >= thresholdA) & ((b[i] >> 24) >= thresholdB);
+    }
+    return hit;
+}
+
+/// Write the difference between two rows of pixels, as compare() does.
+//
+/// @return     Whether any pixels differ.
+inline bool
+compareRow(const std::uint32_t* a, const std::uint32_t* b, std::uint32_t* d,
+        size_t n)
+{
+    std::uint32_t any = 0;
+    for (size_t i = 0; i < n; ++i) {
+        const std::uint32_t p = a[i];
+        const std::uint32_t q = b[i];
+        const std::uint32_t rgb =
+            ((((p >> 16) & 0xff) - ((q >> 16) & 0xff)) & 0xff) << 16 |
+            ((((p >> 8) & 0xff) - ((q >> 8) & 0xff)) & 0xff) << 8 |
+            (((p & 0xff) - (q & 0xff)) & 0xff);
+        const std::uint32_t alpha = (((p >> 24) - (q >> 24)) & 0xff) << 24;
+
+        // Colour differences are opaque; differences only in alpha
+        // are white.
+        d[i] = rgb ? (0xff000000 | rgb) : alpha ? (alpha | 0xffffff) : 0;
+        any |= d[i];
+    }
+    return any;
+}
+
+/// Apply a colour matrix to a row of ARGB pixels.
+//
+/// The matrix has a row of 5 values for each of red, green, blue and
+/// alpha: the factors of the source channels and an offset.
+class ColorMatrixRow
+{
+public:
+    explicit ColorMatrixRow(std::vector<float> m)
+        :
+        _m(std::move(m))
+    {
+        _m.resize(20);
+    }
+
+    void operator()(std::uint32_t* d, const std::uint32_t* s,
+            size_t n) const {
+        for (size_t i = 0; i < n; ++i) {
+            const std::uint32_t c = s[i];
+            const float r = (c >> 16) & 0xff;
+            const float g = (c >> 8) & 0xff;
+            const float b = c & 0xff;
+            const float a = c >> 24;
+            d[i] = channel(3, r, g, b, a) << 24 |
+                   channel(0, r, g, b, a) << 16 |
+                   channel(1, r, g, b, a) << 8 |
+                   channel(2, r, g, b, a);
+        }
+    }
+
+private:
+    std::uint32_t channel(int row, float r, float g, float b, float a) const {
+        const float* m = &_m[row * 5];
+        const float v = m[0] * r + m[1] * g + m[2] * b + m[3] * a + m[4];
+        return clamp<float>(v, 0, 255) + 0.5f;
+    }
+
+    std::vector<float> _m;
+};
+
+/// Read an area of a BitmapData that may reach outside it.
+//
+/// Pixels outside the BitmapData are copies of the nearest edge pixel if
+/// edges is true and outside otherwise. The stored pixels are returned
+/// as they are.
+std::vector<std::uint32_t>
+readArea(const BitmapData_as& bd, int x, int y, int w, int h, bool edges,
+        std::uint32_t outside)
+{
+    std::vector<std::uint32_t> area(w * h, outside);
+    const int width = bd.width();
+    const int height = bd.height();
+
+    for (int j = 0; j < h; ++j) {
+        int sy = y + j;
+        if (sy < 0 || sy >= height) {
+            if (!edges) continue;
+            sy = clamp(sy, 0, height - 1);
+        }
+        const std::uint32_t* row = bd.row(sy);
+        std::uint32_t* out = &area[j * w];
+
+        for (int i = 0; i < w; ++i) {
+            int sx = x + i;
+            if (sx < 0 || sx >= width) {
+                if (!edges) continue;
+                sx = clamp(sx, 0, width - 1);
+            }
+            out[i] = row[sx];
+        }
+    }
+    return area;
+}
+
+/// Convolve an area of one BitmapData into another.
+//
+/// The matrix is applied to the ARGB channels; off-image pixels are the
+/// edge pixels or the filter colour, depending on its clamp property.
+void
+convolveArea(const BitmapData_as& source, int sourceX, int sourceY,
+        const BitmapData_as& dest, int destX, int destY, int w, int h,
+        const ConvolutionFilter& f)
+{
+    const int mx = f.matrixX();
+    const int my = f.matrixY();
+    const std::vector<float>& m = f.matrix();
+    if (!mx || !my || m.size() < static_cast<size_t>(mx * my)) return;
+
+    const float divisor = f.divisor() ? f.divisor() : 1;
+    const float bias = f.bias();
+
+    // The source area with the margin the matrix reaches.
+    const int aw = w + mx - 1;
+    const std::uint32_t outside = BitmapData_as::premultiply(
+            static_cast<std::uint32_t>(f.alpha()) << 24 | f.color());
+    std::vector<std::uint32_t> area = readArea(source, sourceX - mx / 2,
+            sourceY - my / 2, aw, h + my - 1, f.clamp(), outside);
+    std::transform(area.begin(), area.end(), area.begin(),
+            BitmapData_as::toARGB);
+
+    for (int y = 0; y < h; ++y) {
+        std::uint32_t* out = pixelAt(dest, destX, destY + y);
+        for (int x = 0; x < w; ++x) {
+            float sum[4] = { 0, 0, 0, 0 };
+            for (int j = 0; j < my; ++j) {
+                const std::uint32_t* p = &area[(y + j) * aw + x];
+                const float* k = &m[j * mx];
+                for (int i = 0; i < mx; ++i) {
+                    for (int c = 0; c < 4; ++c) {
+                        sum[c] += k[i] * ((p[i] >> (c * 8)) & 0xff);
+                    }
+                }
+            }
+
+            std::uint32_t argb = 0;
+            for (int c = 0; c < 4; ++c) {
+                const float v = clamp<float>(sum[c] / divisor + bias, 0, 255);
+                argb |= static_cast<std::uint32_t>(v + 0.5f) << (c * 8);
+            }
+            if (f.preserveAlpha()) {
+                const std::uint32_t centre =
+                    area[(y + my / 2) * aw + x + mx / 2];
+                argb = (argb & 0xffffff) | (centre & 0xff000000);
+            }
+            out[x] = dest.toPixel(argb);
+        }
+    }
+}
+
+/// The number of pixels a blur reaches on each side in one pass.
+inline int
+blurRadius(float blur)
+{
+    return clamp<float>(blur, 0, 255) / 2;
+}
+
+/// The number of pixels a blur reaches on each side in all its passes.
+inline int
+blurReach(float blur, int quality)
+{
+    return blurRadius(blur) * clamp(quality, 0, 15);
+}
+
+/// Blur a line of premultiplied pixels with a box 2 * r + 1 pixels wide.
+//
+/// The pixels are step apart; those beyond the ends are transparent. The
+/// line buffer is only passed in to be reused.
+void
+boxBlur(std::uint32_t* p, int n, int step, int r,
+        std::vector<std::uint32_t>& line)
+{
+    line.resize(n);
+    for (int i = 0; i < n; ++i) line[i] = p[i * step];
+
+    const std::uint32_t size = 2 * r + 1;
+    std::uint32_t sum[4] = { 0, 0, 0, 0 };
+
+    for (int i = -r; i < n; ++i) {
+        if (i + r < n) {
+            const std::uint32_t in = line[i + r];
+            for (int c = 0; c < 4; ++c) sum[c] += (in >> (c * 8)) & 0xff;
+        }
+        if (i < 0) continue;
+
+        std::uint32_t px = 0;
+        for (int c = 0; c < 4; ++c) {
+            px |= ((sum[c] + size / 2) / size) << (c * 8);
+        }
+        p[i * step] = px;
+
+        if (i >= r) {
+            const std::uint32_t out = line[i - r];
+            for (int c = 0; c < 4; ++c) sum[c] -= (out >> (c * 8)) & 0xff;
+        }
+    }
+}
+
+/// Blur an area of one BitmapData into another.
+//
+/// Each pass is a horizontal and a vertical box blur, so three passes
+/// come close to a gaussian blur. The area is read with the margin the
+/// passes reach, so pixels around the rectangle are blurred into it.
+void
+blurArea(const BitmapData_as& source, int sourceX, int sourceY,
+        const BitmapData_as& dest, int destX, int destY, int w, int h,
+        float blurX, float blurY, int quality)
+{
+    quality = clamp(quality, 0, 15);
+    const int rx = blurRadius(blurX);
+    const int ry = blurRadius(blurY);
+    const int mx = blurReach(blurX, quality);
+    const int my = blurReach(blurY, quality);
+
+    const int aw = w + 2 * mx;
+    const int ah = h + 2 * my;
+    std::vector<std::uint32_t> area = readArea(source, sourceX - mx,
+            sourceY - my, aw, ah, false, 0);
+
+    std::vector<std::uint32_t> line;
+    for (int q = 0; q < quality; ++q) {
+        for (int y = 0; rx && y < ah; ++y) {
+            boxBlur(&area[y * aw], aw, 1, rx, line);
+        }
+        for (int x = 0; ry && x < aw; ++x) {
+            boxBlur(&area[x], ah, aw, ry, line);
+        }
+    }
+
+    const bool opaque = !dest.transparent();
+    for (int y = 0; y < h; ++y) {
+        const std::uint32_t* p = &area[(y + my) * aw + mx];
+        std::uint32_t* out = pixelAt(dest, destX, destY + y);
+        if (!opaque) {
+            std::copy(p, p + w, out);
+            continue;
+        }
+        for (int x = 0; x < w; ++x) {
+            out[x] = dest.toPixel(BitmapData_as::toARGB(p[x]));
+        }
+    }
+}
+
 } // anonymous namespace
 
 BitmapData_as::BitmapData_as(as_object* owner,
-        std::unique_ptr<image::GnashImage> im)
+        std::unique_ptr<image::GnashImage> im, bool transparent)
     :
     _owner(owner),
-    _cachedBitmap(nullptr)
+    _cachedBitmap(nullptr),
+    _locked(false),
+    _transparent(transparent && im->type() == image::TYPE_RGBA)
 {
     //assert(im->width() <= 2880);
     //assert(im->height() <= 2880);
+
+    // The pixels are always stored as RGBA so that rows can be accessed
+    // as 32-bit values.
+    if (im->type() != image::TYPE_RGBA) {
+        std::unique_ptr<image::GnashImage> rgba(
+                new image::ImageRGBA(im->width(), im->height()));
+        std::copy(image::begin<image::ARGB>(*im), image::end<image::ARGB>(*im),
+                image::begin<image::ARGB>(*rgba));
+        im = std::move(rgba);
+    }
     
     // If there is a renderer, cache the image there, otherwise we store it.
     Renderer* r = getRunResources(*_owner).renderer();
@@ -621,9 +1177,34 @@ BitmapData_as::setReachable()
 
 void
 BitmapData_as::updateObjects() const
+{
+    updateObjects(0, 0, width(), height());
+}
+
+void
+BitmapData_as::updateObjects(int x, int y, int w, int h) const
+{
+    if (w <= 0 || h <= 0) return;
+
+    _changed.expandTo(x, y);
+    _changed.expandTo(x + w - 1, y + h - 1);
+
+    if (!_locked) notifyObjects();
+}
+
+void
+BitmapData_as::notifyObjects() const
 {
     std::for_each(_attachedObjects.begin(), _attachedObjects.end(),
             std::mem_fun(&DisplayObject::update));
+    _changed.setNull();
+}
+
+void
+BitmapData_as::unlock()
+{
+    _locked = false;
+    if (!_changed.isNull()) notifyObjects();
 }
 
 void
@@ -632,7 +1213,8 @@ BitmapData_as::dispose()
     if (_cachedBitmap) _cachedBitmap->dispose();
     _cachedBitmap = nullptr;
     _image.reset();
-    updateObjects();
+    _changed.setNull();
+    notifyObjects();
 }
 
 void
@@ -709,54 +1291,102 @@ registerBitmapDataNative(as_object& global)
 
 namespace {
 
+// sourceBitmapData: BitmapData,
+// sourceRect: Rectangle,
+// destPoint: Point,
+// filter: BitmapFilter
 as_value
 bitmapdata_applyFilter(const fn_call& fn)
 {
     BitmapData_as* ptr = ensure<ThisIsNative<BitmapData_as> >(fn);
-    UNUSED(ptr);
-    LOG_ONCE(log_unimpl(__FUNCTION__) );
+
+    if (fn.nargs < 4 || ptr->disposed()) return as_value();
+
+    int sourceX, sourceY, w, h, destX, destY;
+    BitmapData_as* source = getCopyArea(fn, *ptr, sourceX, sourceY, w, h,
+            destX, destY);
+    if (!source) return as_value();
+
+    as_object* obj = toObject(fn.arg(3), getVM(fn));
+    const Relay* filter = obj ? obj->relay() : 0;
+
+    if (const BlurFilter* f = dynamic_cast<const BlurFilter*>(filter)) {
+        blurArea(*source, sourceX, sourceY, *ptr, destX, destY, w, h,
+                f->m_blurX, f->m_blurY, f->m_quality);
+    }
+    else if (const ColorMatrixFilter* f =
+            dynamic_cast<const ColorMatrixFilter*>(filter)) {
+        copyRows(*source, sourceX, sourceY, *ptr, destX, destY, w, h,
+                ColorMatrixRow(f->matrix()));
+    }
+    else if (const ConvolutionFilter* f =
+            dynamic_cast<const ConvolutionFilter*>(filter)) {
+        convolveArea(*source, sourceX, sourceY, *ptr, destX, destY, w, h, *f);
+    }
+    else {
+        LOG_ONCE(log_unimpl(_("BitmapData.applyFilter() with filters other "
+                        "than BlurFilter, ColorMatrixFilter and "
+                        "ConvolutionFilter")));
+        return as_value();
+    }
+
+    ptr->updateObjects(destX, destY, w, h);
+
     return as_value();
 }
 
 as_value
 bitmapdata_clone(const fn_call& fn)
 {
-    as_object* obj = ensure<ValidThis>(fn);
     BitmapData_as* bm = ensure<ThisIsNative<BitmapData_as> >(fn);
     if (bm->disposed()) return as_value();
 
     const size_t width = bm->width();
     const size_t height = bm->height();
 
-    std::unique_ptr<image::GnashImage> im;
-    if (bm->transparent()) {
-        im.reset(new image::ImageRGBA(width, height));
-    }
-    else {
-        im.reset(new image::ImageRGB(width, height));
-    }
-    // Note that it would be much faster to copy the pixels, but BitmapData
-    // currently doesn't expose a way to do this.
-    std::copy(bm->begin(), bm->end(), image::begin<image::ARGB>(*im));
+    std::unique_ptr<image::GnashImage> im(
+            new image::ImageRGBA(width, height));
+    std::memcpy(im->begin(), bm->row(0), width * height * 4);
 
-    Global_as& gl = getGlobal(fn);
-    as_object* ret = createObject(gl);
-    const as_value& proto = getMember(*obj, NSV::PROP_uuPROTOuu);
-    if (proto.is_object()) {
-        ret->set_member(NSV::PROP_uuPROTOuu, proto);
-    }
-
-    ret->setRelay(new BitmapData_as(ret, std::move(im)));
-
-    return as_value(ret);
+    return as_value(createBitmapData(fn, std::move(im), bm->transparent()));
 }
 
 as_value
 bitmapdata_colorTransform(const fn_call& fn)
 {
     BitmapData_as* ptr = ensure<ThisIsNative<BitmapData_as> >(fn);
-    UNUSED(ptr);
-    LOG_ONCE(log_unimpl(__FUNCTION__) );
+
+    if (fn.nargs < 2 || ptr->disposed()) return as_value();
+
+    as_object* rect = toObject(fn.arg(0), getVM(fn));
+    as_object* o = toObject(fn.arg(1), getVM(fn));
+    ColorTransform_as* tr;
+    if (!rect || !isNativeType(o, tr)) {
+        IF_VERBOSE_ASCODING_ERRORS(
+            std::ostringstream ss;
+            fn.dump_args(ss);
+            log_aserror(_("BitmapData.colorTransform(%s): needs a Rectangle "
+                          "and a ColorTransform"), ss.str());
+        );
+        return as_value();
+    }
+
+    int x, y, w, h;
+    getRect(*rect, getVM(fn), x, y, w, h);
+    adjustRect(x, y, w, h, *ptr);
+    if (w == 0 || h == 0) return as_value();
+
+    const SWFCxForm cx = toCxForm(*tr);
+
+    RowAccess rows(*ptr, x, y, w);
+    for (int i = 0; i < h; ++i) {
+        std::uint32_t* row = rows.read(i);
+        colorTransformRow(row, w, cx);
+        rows.write(i, row);
+    }
+
+    ptr->updateObjects(x, y, w, h);
+
     return as_value();
 }
 
@@ -859,8 +1489,8 @@ bitmapdata_copyChannel(const fn_call& fn)
         return as_value();
     }
 
-    BitmapData_as::iterator targ = pixelAt(*ptr, destX, destY);
-    BitmapData_as::iterator src = pixelAt(*source, sourceX, sourceY);
+    std::uint32_t* targ = pixelAt(*ptr, destX, destY);
+    const std::uint32_t* src = pixelAt(*source, sourceX, sourceY);
 
     // Just being careful...
     //assert(sourceX + destW <= static_cast<int>(source->width()));
@@ -871,8 +1501,7 @@ bitmapdata_copyChannel(const fn_call& fn)
     // Copy for the width and height of the *dest* image.
     // We have already ensured that the copied area
     // is inside both bitmapdatas
-    typedef CopyChannel<BitmapData_as::iterator> Copier;
-    Copier c(multiple, srcchans, destchans);
+    const CopyChannel c(multiple, srcchans, destchans);
 
     const size_t ourwidth = ptr->width();
     const size_t srcwidth = source->width();
@@ -882,13 +1511,15 @@ bitmapdata_copyChannel(const fn_call& fn)
     // range is changed while it is being copied. This is verified
     // to happen with the Adobe player too.
     for (int i = 0; i < destH; ++i) {
-        Copier::iterator_type zip(boost::make_tuple(src, targ));
-        std::transform(zip, zip + destW, targ, c);
+        for (int j = 0; j < destW; ++j) {
+            targ[j] = ptr->toPixel(c(BitmapData_as::toARGB(src[j]),
+                        BitmapData_as::toARGB(targ[j])));
+        }
         targ += ourwidth;
         src += srcwidth;
     }
 
-    ptr->updateObjects();
+    ptr->updateObjects(destX, destY, destW, destH);
 
     return as_value();
 }
@@ -986,63 +1617,38 @@ bitmapdata_copyPixels(const fn_call& fn)
         return as_value();
     }
 
-    BitmapData_as::iterator targ = pixelAt(*ptr, destX, destY);
-    BitmapData_as::iterator src = pixelAt(*source, sourceX, sourceY);
-
-    const bool sameImage = (ptr == source);
-    const bool copyToXRange = sameImage && 
-        (destX >= sourceX && destX < sourceX + destW);
-    const bool copyToYRange = sameImage &&
-        (destY >= sourceY && destY < sourceY + destH);
-
     // Just being careful...
     //assert(sourceX + destW <= static_cast<int>(source->width()));
     //assert(sourceY + destH <= static_cast<int>(source->height()));
     //assert(destX + destW <= static_cast<int>(ptr->width()));
     //assert(destY + destH <= static_cast<int>(ptr->height()));
 
-    const size_t ourwidth = ptr->width();
-    const size_t srcwidth = source->width();
-
     // Copy for the width and height of the *dest* image.
     // We have already ensured that the copied area
     // is inside both bitmapdatas.
     //
     // If the destination y-range starts within the source y-range, copy from
-    // bottom to top.
-    // If the destination x-range starts within the source x-range, copy from
-    // right to left.
-    if (copyToYRange) {
-        //assert(destH > 0);
-        targ += (destH - 1) * ourwidth;
-        src += (destH - 1) * srcwidth;
-        // Copy from bottom to top.
-        for (int i = destH; i > 0; --i) {
-            if (copyToXRange) {
-                std::copy_backward(src, src + destW, targ + destW);
-            }
-            else {
-                std::copy(src, src + destW, targ);
-            }
-            targ -= ourwidth;
-            src -= srcwidth;
-        }
-    }
-    else {
-        // Normal copy from top to bottom.
-        for (int i = 0; i < destH; ++i) {
-            if (copyToXRange) {
-                std::copy_backward(src, src + destW, targ + destW);
-            }
-            else {
-                std::copy(src, src + destW, targ);
+    // bottom to top. Overlapping x-ranges are handled by memmove.
+    const bool upwards = (ptr == source) &&
+        (destY >= sourceY && destY < sourceY + destH);
+
+    // Pixels are copied as they are unless an opaque BitmapData receives
+    // transparent ones, whose colours are then stored without the alpha.
+    const bool convert = source->transparent() && !ptr->transparent();
+
+    for (int i = 0; i < destH; ++i) {
+        const int y = upwards ? destH - 1 - i : i;
+        std::uint32_t* targ = ptr->row(destY + y) + destX;
+        const std::uint32_t* src = source->row(sourceY + y) + sourceX;
+        if (convert) {
+            for (int j = 0; j < destW; ++j) {
+                targ[j] = ptr->toPixel(BitmapData_as::toARGB(src[j]));
             }
-            targ += ourwidth;
-            src += srcwidth;
         }
+        else std::memmove(targ, src, destW * sizeof *targ);
     }
 
-    ptr->updateObjects();
+    ptr->updateObjects(destX, destY, destW, destH);
 
     return as_value();
 }
@@ -1176,30 +1782,116 @@ bitmapdata_floodFill(const fn_call& fn)
     }
 
     const std::uint32_t fill = toInt(fn.arg(2), getVM(fn));
-    const std::uint32_t old = *pixelAt(*ptr, x, y);
+    const std::uint32_t* old = pixelAt(*ptr, x, y);
+    if (!old) return as_value();
 
     // This checks whether the colours are the same.
-    floodFill(*ptr, x, y, old, fill);
+    floodFill(*ptr, x, y, *old, ptr->toPixel(fill));
     
     return as_value();
 }
 
+// sourceRect: Rectangle,
+// filter: BitmapFilter
 as_value
 bitmapdata_generateFilterRect(const fn_call& fn)
 {
     BitmapData_as* ptr = ensure<ThisIsNative<BitmapData_as> >(fn);
-    UNUSED(ptr);
-    LOG_ONCE(log_unimpl(__FUNCTION__) );
-    return as_value();
+
+    if (fn.nargs < 2 || ptr->disposed()) return as_value();
+
+    VM& vm = getVM(fn);
+    as_object* rect = toObject(fn.arg(0), vm);
+    as_object* obj = toObject(fn.arg(1), vm);
+    if (!rect || !obj) {
+        IF_VERBOSE_ASCODING_ERRORS(
+            std::ostringstream ss;
+            fn.dump_args(ss);
+            log_aserror(_("BitmapData.generateFilterRect(%s): needs a "
+                          "Rectangle and a BitmapFilter"), ss.str());
+        );
+        return as_value();
+    }
+
+    int x, y, w, h;
+    getRect(*rect, vm, x, y, w, h);
+
+    // How far the filter spreads the rectangle on each side. It is the
+    // reach of the blur passes, and a drop shadow is also offset.
+    int left = 0, top = 0, right = 0, bottom = 0;
+    const Relay* filter = obj->relay();
+
+    if (const BlurFilter* f = dynamic_cast<const BlurFilter*>(filter)) {
+        left = right = blurReach(f->m_blurX, f->m_quality);
+        top = bottom = blurReach(f->m_blurY, f->m_quality);
+    }
+    else if (const GlowFilter* f = dynamic_cast<const GlowFilter*>(filter)) {
+        left = right = blurReach(f->m_blurX, f->m_quality);
+        top = bottom = blurReach(f->m_blurY, f->m_quality);
+    }
+    else if (const DropShadowFilter* f =
+            dynamic_cast<const DropShadowFilter*>(filter)) {
+        const int rx = blurReach(f->m_blurX, f->m_quality);
+        const int ry = blurReach(f->m_blurY, f->m_quality);
+        const double angle = f->m_angle * M_PI / 180;
+        const int dx = std::lround(f->m_distance * std::cos(angle));
+        const int dy = std::lround(f->m_distance * std::sin(angle));
+        left = std::max(rx - dx, 0);
+        right = std::max(rx + dx, 0);
+        top = std::max(ry - dy, 0);
+        bottom = std::max(ry + dy, 0);
+    }
+
+    return as_value(createRectangle(fn, x - left, y - top,
+                w + left + right, h + top + bottom));
 }
 
+// mask: Number,
+// color: Number,
+// [findColor: Boolean]
 as_value
 bitmapdata_getColorBoundsRect(const fn_call& fn)
 {
     BitmapData_as* ptr = ensure<ThisIsNative<BitmapData_as> >(fn);
-    UNUSED(ptr);
-    LOG_ONCE(log_unimpl(__FUNCTION__) );
-    return as_value();
+
+    if (fn.nargs < 2 || ptr->disposed()) return as_value();
+
+    const std::uint32_t mask = toInt(fn.arg(0), getVM(fn));
+    const std::uint32_t color = toInt(fn.arg(1), getVM(fn));
+    const bool find = fn.nargs > 2 ? toBool(fn.arg(2), getVM(fn)) : true;
+
+    const int width = ptr->width();
+    const int height = ptr->height();
+
+    int minX = width;
+    int maxX = -1;
+    int minY = -1;
+    int maxY = -1;
+
+    RowAccess rows(*ptr, 0, 0, width);
+    for (int y = 0; y < height; ++y) {
+        const std::uint32_t* row = rows.read(y);
+
+        int first = 0;
+        while (first < width && ((row[first] & mask) == color) != find) {
+            ++first;
+        }
+        if (first == width) continue;
+
+        int last = width - 1;
+        while (((row[last] & mask) == color) != find) --last;
+
+        minX = std::min(minX, first);
+        maxX = std::max(maxX, last);
+        if (minY < 0) minY = y;
+        maxY = y;
+    }
+
+    // An empty Rectangle is returned if no pixel matches.
+    if (minY < 0) return as_value(createRectangle(fn, 0, 0, 0, 0));
+
+    return as_value(createRectangle(fn, minX, minY, maxX - minX + 1,
+                maxY - minY + 1));
 }
 
 as_value
@@ -1251,21 +1943,126 @@ bitmapdata_getPixel32(const fn_call& fn)
 }
 
 
+// firstPoint: Point,
+// firstAlphaThreshold: Number,
+// secondObject: Object,
+// [secondBitmapPoint: Point],
+// [secondAlphaThreshold: Number]
+//
+// The second object may be a Point, a Rectangle or a BitmapData.
 as_value
 bitmapdata_hitTest(const fn_call& fn)
 {
     BitmapData_as* ptr = ensure<ThisIsNative<BitmapData_as> >(fn);
-    UNUSED(ptr);
-    LOG_ONCE(log_unimpl(__FUNCTION__) );
-    return as_value();
+
+    if (fn.nargs < 3 || ptr->disposed()) return as_value();
+
+    VM& vm = getVM(fn);
+
+    as_object* first = toObject(fn.arg(0), vm);
+    as_object* second = toObject(fn.arg(2), vm);
+    if (!first || !second) {
+        IF_VERBOSE_ASCODING_ERRORS(
+            std::ostringstream ss;
+            fn.dump_args(ss);
+            log_aserror(_("BitmapData.hitTest(%s): needs a Point and an "
+                          "object to test"), ss.str());
+        );
+        return as_value();
+    }
+
+    int firstX, firstY;
+    getPoint(*first, vm, firstX, firstY);
+    const std::uint32_t firstAlpha = clamp(toInt(fn.arg(1), vm), 0, 255);
+
+    BitmapData_as* other;
+    if (isNativeType(second, other)) {
+
+        if (other->disposed()) return as_value();
+
+        int secondX = 0;
+        int secondY = 0;
+        as_object* point = fn.nargs > 3 ? toObject(fn.arg(3), vm) : 0;
+        if (point) getPoint(*point, vm, secondX, secondY);
+
+        const std::uint32_t secondAlpha = fn.nargs > 4 ?
+            clamp(toInt(fn.arg(4), vm), 0, 255) : 1;
+
+        // The other bitmap's area, relative to this one.
+        const int otherX = secondX - firstX;
+        const int otherY = secondY - firstY;
+
+        int x = otherX;
+        int y = otherY;
+        int w = other->width();
+        int h = other->height();
+        adjustRect(x, y, w, h, *ptr);
+        if (w == 0 || h == 0) return false;
+
+        RowAccess ours(*ptr, x, y, w);
+        RowAccess theirs(*other, x - otherX, y - otherY, w);
+        for (int i = 0; i < h; ++i) {
+            if (alphaHit(ours.read(i), theirs.read(i), w, firstAlpha,
+                        secondAlpha)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // A Rectangle, or else a Point.
+    int x, y;
+    int w = 1;
+    int h = 1;
+    as_value width;
+    if (second->get_member(NSV::PROP_WIDTH, &width)) {
+        getRect(*second, vm, x, y, w, h);
+    }
+    else {
+        getPoint(*second, vm, x, y);
+    }
+
+    x -= firstX;
+    y -= firstY;
+    adjustRect(x, y, w, h, *ptr);
+    if (w == 0 || h == 0) return false;
+
+    RowAccess rows(*ptr, x, y, w);
+    for (int i = 0; i < h; ++i) {
+        if (alphaHit(rows.read(i), w, firstAlpha)) return true;
+    }
+    return false;
 }
 
+// sourceBitmap: BitmapData,
+// sourceRect: Rectangle,
+// destPoint: Point,
+// redMult: Number,
+// greenMult: Number,
+// blueMult: Number,
+// alphaMult: Number
 as_value
 bitmapdata_merge(const fn_call& fn)
 {
     BitmapData_as* ptr = ensure<ThisIsNative<BitmapData_as> >(fn);
-    UNUSED(ptr);
-    LOG_ONCE(log_unimpl(__FUNCTION__) );
+
+    if (fn.nargs < 7 || ptr->disposed()) return as_value();
+
+    int sourceX, sourceY, w, h, destX, destY;
+    BitmapData_as* source = getCopyArea(fn, *ptr, sourceX, sourceY, w, h,
+            destX, destY);
+    if (!source) return as_value();
+
+    VM& vm = getVM(fn);
+    const MergeRow merge(clamp(toInt(fn.arg(3), vm), 0, 256),
+            clamp(toInt(fn.arg(4), vm), 0, 256),
+            clamp(toInt(fn.arg(5), vm), 0, 256),
+            clamp(toInt(fn.arg(6), vm), 0, 256));
+
+    copyRows(*source, sourceX, sourceY, *ptr, destX, destY, w, h, merge);
+
+    ptr->updateObjects(destX, destY, w, h);
+
     return as_value();
 }
 
@@ -1306,19 +2103,60 @@ bitmapdata_noise(const fn_call& fn)
 
     NoiseAdapter<Noise<> > n(noise, chans, greyscale);
 
-    std::generate(ptr->begin(), ptr->end(), n);
+    const size_t width = ptr->width();
+    for (size_t y = 0, e = ptr->height(); y < e; ++y) {
+        std::uint32_t* row = ptr->row(y);
+        for (size_t x = 0; x < width; ++x) {
+            row[x] = ptr->toPixel(n());
+        }
+    }
     
     ptr->updateObjects();
 
     return as_value();
 }
 
+// sourceBitmap: BitmapData,
+// sourceRect: Rectangle,
+// destPoint: Point,
+// [redArray: Array],
+// [greenArray: Array],
+// [blueArray: Array],
+// [alphaArray: Array]
 as_value
 bitmapdata_paletteMap(const fn_call& fn)
 {
     BitmapData_as* ptr = ensure<ThisIsNative<BitmapData_as> >(fn);
-    UNUSED(ptr);
-    LOG_ONCE(log_unimpl(__FUNCTION__) );
+
+    if (fn.nargs < 3 || ptr->disposed()) return as_value();
+
+    int sourceX, sourceY, w, h, destX, destY;
+    BitmapData_as* source = getCopyArea(fn, *ptr, sourceX, sourceY, w, h,
+            destX, destY);
+    if (!source) return as_value();
+
+    VM& vm = getVM(fn);
+
+    // Channels without an array are copied unchanged.
+    PaletteRow::Table tables[4];
+    for (size_t chan = 0; chan < 4; ++chan) {
+        PaletteRow::Table& table = tables[chan];
+        as_object* arr = fn.nargs > 3 + chan ?
+            toObject(fn.arg(3 + chan), vm) : 0;
+        if (arr) {
+            TablePusher pusher(table, vm);
+            foreachArray(*arr, pusher);
+            continue;
+        }
+        const size_t shift = chan == 3 ? 24 : 16 - chan * 8;
+        for (size_t i = 0; i < table.size(); ++i) table[i] = i << shift;
+    }
+
+    copyRows(*source, sourceX, sourceY, *ptr, destX, destY, w, h,
+            PaletteRow(tables[0], tables[1], tables[2], tables[3]));
+
+    ptr->updateObjects(destX, destY, w, h);
+
     return as_value();
 }
 
@@ -1378,7 +2216,9 @@ bitmapdata_perlinNoise(const fn_call& fn)
 
     if (!octave || (!channels && !greyscale)) {
         // Clear the image and return.
-        std::fill(ptr->begin(), ptr->end(), 0xff000000);
+        std::fill_n(ptr->row(0), ptr->width() * ptr->height(),
+                ptr->toPixel(0xff000000));
+        ptr->updateObjects();
         return as_value();
     }
 
@@ -1391,8 +2231,8 @@ bitmapdata_perlinNoise(const fn_call& fn)
     const bool transparent = ptr->transparent();
 
     size_t pixel = 0;
-    for (BitmapData_as::iterator it = ptr->begin(), e = ptr->end(); it != e;
-            ++it, ++pixel) {
+    for (std::uint32_t* it = ptr->row(0), *e = it + width * ptr->height();
+            it != e; ++it, ++pixel) {
 
         const size_t x = pixel % width;
         const size_t y = pixel / width;
@@ -1417,7 +2257,7 @@ bitmapdata_perlinNoise(const fn_call& fn)
             // Greyscale affects all colour channels equally. If alpha the
             // alpha channel is requested, that's done seperately; otherwise
             // it's full.
-            *it = (rv | rv << 8 | rv << 16 | av << 24);
+            *it = ptr->toPixel(rv | rv << 8 | rv << 16 | av << 24);
             continue;
         }
 
@@ -1435,7 +2275,7 @@ bitmapdata_perlinNoise(const fn_call& fn)
             const double b = pa(x, y, 2);
             bv = clamp(b, 0.0, 255.0);
         }
-        *it = (bv | gv << 8 | rv << 16 | av << 24);
+        *it = ptr->toPixel(bv | gv << 8 | rv << 16 | av << 24);
     }
     
     ptr->updateObjects();
@@ -1443,21 +2283,107 @@ bitmapdata_perlinNoise(const fn_call& fn)
     return as_value();
 }
 
+// sourceBitmap: BitmapData,
+// sourceRect: Rectangle,
+// destPoint: Point,
+// [randomSeed: Number],
+// [numberOfPixels: Number],
+// [fillColor: Number]
+//
+// Returns the seed to pass to the next call.
 as_value
 bitmapdata_pixelDissolve(const fn_call& fn)
 {
     BitmapData_as* ptr = ensure<ThisIsNative<BitmapData_as> >(fn);
-    UNUSED(ptr);
-    LOG_ONCE(log_unimpl(__FUNCTION__) );
-    return as_value();
+
+    if (fn.nargs < 3 || ptr->disposed()) return as_value();
+
+    int sourceX, sourceY, w, h, destX, destY;
+    BitmapData_as* source = getCopyArea(fn, *ptr, sourceX, sourceY, w, h,
+            destX, destY);
+    if (!source) return as_value();
+
+    VM& vm = getVM(fn);
+
+    const std::int64_t total = static_cast<std::int64_t>(w) * h;
+    const std::int64_t seed = fn.nargs > 3 ? toInt(fn.arg(3), vm) : 0;
+    const std::int64_t count = fn.nargs > 4 ?
+        clamp<std::int64_t>(toInt(fn.arg(4), vm), 0, total) : 0;
+    const std::uint32_t fill = fn.nargs > 5 ? toInt(fn.arg(5), vm) : 0;
+
+    // The seed is a position in a sequence that visits every pixel of the
+    // area once, so successive calls passing the returned seed dissolve
+    // new pixels. A step of about total / phi that is coprime with total
+    // spreads the pixels evenly. This is not the Adobe pattern.
+    // The step must stay below total, which it would not for two pixels.
+    std::int64_t step = static_cast<std::int64_t>(total * 0.6180339887 + 1) %
+        total;
+    if (!step) step = 1;
+    while (gcd(step, total) != 1) ++step;
+
+    const std::int64_t start = ((seed % total) + total) % total;
+    std::int64_t pos = start * step % total;
+
+    std::uint32_t* const dest = pixelAt(*ptr, destX, destY);
+    const std::uint32_t* const src = pixelAt(*source, sourceX, sourceY);
+    const size_t destStride = ptr->width();
+    const size_t srcStride = source->width();
+
+    // Dissolving a bitmap into itself fills the pixels.
+    const bool fillPixels = (source == ptr);
+    const std::uint32_t fillPixel = ptr->toPixel(fill);
+    const bool convert = source->transparent() && !ptr->transparent();
+
+    for (std::int64_t i = 0; i < count; ++i) {
+        assert(pos < total);
+        const size_t x = pos % w;
+        const size_t y = pos / w;
+        const std::uint32_t p = src[y * srcStride + x];
+        dest[y * destStride + x] = fillPixels ? fillPixel :
+            convert ? ptr->toPixel(BitmapData_as::toARGB(p)) : p;
+        pos += step;
+        if (pos >= total) pos -= total;
+    }
+
+    ptr->updateObjects(destX, destY, w, h);
+
+    return static_cast<std::int32_t>((start + count) % total);
 }
 
 as_value
 bitmapdata_scroll(const fn_call& fn)
 {
     BitmapData_as* ptr = ensure<ThisIsNative<BitmapData_as> >(fn);
-    UNUSED(ptr);
-    LOG_ONCE(log_unimpl(__FUNCTION__) );
+
+    if (fn.nargs < 2 || ptr->disposed()) return as_value();
+
+    const int x = toInt(fn.arg(0), getVM(fn));
+    const int y = toInt(fn.arg(1), getVM(fn));
+
+    const int width = ptr->width();
+    const int height = ptr->height();
+
+    // The area that is not scrolled over keeps its pixels.
+    if (x >= width || -x >= width || y >= height || -y >= height) {
+        return as_value();
+    }
+    if (!x && !y) return as_value();
+
+    const int w = width - std::abs(x);
+    const int h = height - std::abs(y);
+    const int sourceX = std::max(-x, 0);
+    const int sourceY = std::max(-y, 0);
+
+    // Rows are copied from the bottom when scrolling down so that none is
+    // overwritten before it has been read.
+    for (int i = 0; i < h; ++i) {
+        const int row = y > 0 ? h - 1 - i : i;
+        std::memmove(ptr->row(row + std::max(y, 0)) + std::max(x, 0),
+                ptr->row(row + sourceY) + sourceX, w * sizeof(std::uint32_t));
+    }
+
+    ptr->updateObjects(std::max(x, 0), std::max(y, 0), w, h);
+
     return as_value();
 }
 
@@ -1509,24 +2435,132 @@ bitmapdata_setPixel32(const fn_call& fn)
     return as_value();
 }
 
+// Returns 0 if the bitmaps are equal, a negative number if they can't
+// be compared, or else a BitmapData of the differences.
 as_value
 bitmapdata_compare(const fn_call& fn)
 {
     BitmapData_as* ptr = ensure<ThisIsNative<BitmapData_as> >(fn);
-    UNUSED(ptr);
-    LOG_ONCE(log_unimpl(__FUNCTION__) );
+
+    if (ptr->disposed()) return -2;
+
+    BitmapData_as* other;
+    if (!fn.nargs || !isNativeType(toObject(fn.arg(0), getVM(fn)), other)) {
+        return -1;
+    }
+    if (other->disposed()) return -2;
+
+    const size_t width = ptr->width();
+    const size_t height = ptr->height();
+    if (other->width() != width) return -3;
+    if (other->height() != height) return -4;
+
+    std::unique_ptr<image::GnashImage> im(
+            new image::ImageRGBA(width, height));
+
+    RowAccess ours(*ptr, 0, 0, width);
+    RowAccess theirs(*other, 0, 0, width);
+    std::vector<std::uint32_t> diff(width);
+    bool differ = false;
+
+    for (size_t y = 0; y < height; ++y) {
+        differ |= compareRow(ours.read(y), theirs.read(y), diff.data(),
+                width);
+        std::transform(diff.begin(), diff.end(),
+                reinterpret_cast<std::uint32_t*>(scanline(*im, y)),
+                BitmapData_as::premultiply);
+    }
+
+    if (!differ) return 0.0;
+
+    return as_value(createBitmapData(fn, std::move(im), true));
+}
+
+as_value
+bitmapdata_lock(const fn_call& fn)
+{
+    BitmapData_as* ptr = ensure<ThisIsNative<BitmapData_as> >(fn);
+    ptr->lock();
     return as_value();
 }
 
+// [changeRect: Rectangle]
 as_value
-bitmapdata_threshold(const fn_call& fn)
+bitmapdata_unlock(const fn_call& fn)
 {
     BitmapData_as* ptr = ensure<ThisIsNative<BitmapData_as> >(fn);
-    UNUSED(ptr);
-    LOG_ONCE(log_unimpl(__FUNCTION__) );
+
+    as_object* rect = fn.nargs ? toObject(fn.arg(0), getVM(fn)) : 0;
+    if (rect && !ptr->disposed()) {
+        int x, y, w, h;
+        getRect(*rect, getVM(fn), x, y, w, h);
+        adjustRect(x, y, w, h, *ptr);
+        ptr->updateObjects(x, y, w, h);
+    }
+
+    ptr->unlock();
     return as_value();
 }
 
+// sourceBitmap: BitmapData,
+// sourceRect: Rectangle,
+// destPoint: Point,
+// operation: String,
+// threshold: Number,
+// [color: Number],
+// [mask: Number],
+// [copySource: Boolean]
+//
+// Returns the number of pixels that passed the test.
+as_value
+bitmapdata_threshold(const fn_call& fn)
+{
+    BitmapData_as* ptr = ensure<ThisIsNative<BitmapData_as> >(fn);
+
+    if (fn.nargs < 5 || ptr->disposed()) return as_value();
+
+    int sourceX, sourceY, w, h, destX, destY;
+    BitmapData_as* source = getCopyArea(fn, *ptr, sourceX, sourceY, w, h,
+            destX, destY);
+    if (!source) return as_value();
+
+    VM& vm = getVM(fn);
+
+    const std::string op = fn.arg(3).to_string();
+    const std::uint32_t threshold = toInt(fn.arg(4), vm);
+    const std::uint32_t color = fn.nargs > 5 ? toInt(fn.arg(5), vm) : 0;
+    const std::uint32_t mask = fn.nargs > 6 ?
+        toInt(fn.arg(6), vm) : 0xffffffff;
+    const bool copySource = fn.nargs > 7 ? toBool(fn.arg(7), vm) : false;
+
+    size_t count = 0;
+
+#define THRESHOLD(cmp) \
+    copyRows(*source, sourceX, sourceY, *ptr, destX, destY, w, h, \
+            ThresholdRow<cmp<std::uint32_t> >(threshold, color, mask, \
+                copySource, count))
+
+    if (op == "<") THRESHOLD(std::less);
+    else if (op == "<=") THRESHOLD(std::less_equal);
+    else if (op == ">") THRESHOLD(std::greater);
+    else if (op == ">=") THRESHOLD(std::greater_equal);
+    else if (op == "==") THRESHOLD(std::equal_to);
+    else if (op == "!=") THRESHOLD(std::not_equal_to);
+    else {
+        IF_VERBOSE_ASCODING_ERRORS(
+            log_aserror(_("BitmapData.threshold(): unknown operation %s"),
+                op);
+        );
+        return 0.0;
+    }
+
+#undef THRESHOLD
+
+    ptr->updateObjects(destX, destY, w, h);
+
+    return count;
+}
+
 as_value
 bitmapdata_width(const fn_call& fn)
 {
@@ -1568,21 +2602,9 @@ bitmapdata_rectangle(const fn_call& fn)
     // has been called.
     if (ptr->disposed()) return -1;
 
-    // If it's not found construction will fail.
-    as_value rectangle(findObject(fn.env(), "flash.geom.Rectangle"));
-    as_function* rectCtor = rectangle.to_function();
-
-    if (!rectCtor) {
-        IF_VERBOSE_ASCODING_ERRORS(
-            log_aserror(_("Failed to construct flash.geom.Rectangle!"));
-        );
-        return -1;
-    }
-
-    fn_call::Args args;
-    args += 0.0, 0.0, ptr->width(), ptr->height();
-
-    as_object* newRect = constructInstance(*rectCtor, fn.env(), args);
+    as_object* newRect = createRectangle(fn, 0, 0, ptr->width(),
+            ptr->height());
+    if (!newRect) return -1;
 
     return as_value(newRect);
 }
@@ -1681,23 +2703,16 @@ bitmapdata_ctor(const fn_call& fn)
         throw ActionTypeError();
     }
 
-    std::unique_ptr<image::GnashImage> im;
-    if (transparent) {
-        im.reset(new image::ImageRGBA(width, height));
-    }
-    else {
-        im.reset(new image::ImageRGB(width, height));
-    }
+    std::unique_ptr<image::GnashImage> im(
+            new image::ImageRGBA(width, height));
 
-    // There is one special case for completely transparent colours. This
-    // might be a part of a more general pre-treatment as other colours
-    // vary slightly, but we haven't worked it out yet.
-    if (transparent && !(fillColor & 0xff000000)) fillColor = 0;
+    // The pixels are premultiplied, so completely transparent colours
+    // all become 0, and other colours vary slightly when read back.
+    if (!transparent) fillColor |= 0xff000000;
+    std::fill_n(reinterpret_cast<std::uint32_t*>(im->begin()),
+            width * height, BitmapData_as::premultiply(fillColor));
 
-    std::fill(image::begin<image::ARGB>(*im), image::end<image::ARGB>(*im),
-            fillColor);
-
-    ptr->setRelay(new BitmapData_as(ptr, std::move(im)));
+    ptr->setRelay(new BitmapData_as(ptr, std::move(im), transparent));
 
     return as_value(); 
 }
@@ -1732,6 +2747,16 @@ attachBitmapDataInterface(as_object& o)
     o.init_member("dispose", vm.getNative(1100, 22));
     o.init_member("generateFilterRect", vm.getNative(1100, 23));
     o.init_member("compare", vm.getNative(1100, 24));
+
+    // These are only in the AS3 API, so SWF8 movies don't see them. They
+    // let scripts make many changes without updating the attached objects
+    // each time.
+    const int flags9 = PropFlags::dontEnum | PropFlags::dontDelete |
+        PropFlags::onlySWF9Up;
+    Global_as& gl = getGlobal(o);
+    o.init_member("lock", gl.createFunction(bitmapdata_lock), flags9);
+    o.init_member("unlock", gl.createFunction(bitmapdata_unlock), flags9);
+
     o.init_readonly_property("width", *vm.getNative(1100, 100), flags);
     o.init_readonly_property("height", *vm.getNative(1100, 101), flags);
     o.init_readonly_property("rectangle", *vm.getNative(1100, 102), flags);
@@ -1751,19 +2776,18 @@ attachBitmapDataStaticProperties(as_object& o)
     o.init_member("ALPHA_CHANNEL", BitmapData_as::CHANNEL_ALPHA);
 }
     
-BitmapData_as::iterator
+std::uint32_t*
 pixelAt(const BitmapData_as& bd, size_t x, size_t y)
 {
-    const size_t width = bd.width();
-    if (x >= width || y >= bd.height()) return bd.end();
-    return (bd.begin() + y * width + x);
+    if (x >= bd.width() || y >= bd.height()) return 0;
+    return bd.row(y) + x;
 }
 
 std::uint32_t
 getPixel(const BitmapData_as& bd, size_t x, size_t y)
 {
     if (x >= bd.width() || y >= bd.height()) return 0;
-    return *pixelAt(bd, x, y);
+    return BitmapData_as::toARGB(*pixelAt(bd, x, y));
 }
 
 void
@@ -1772,9 +2796,10 @@ setPixel(const BitmapData_as& bd, size_t x, size_t y, std::uint32_t color)
     if (bd.disposed()) return;
     if (x >= bd.width() || y >= bd.height()) return;
 
-    BitmapData_as::iterator it = pixelAt(bd, x, y);
-    const std::uint32_t val = *it;
-    *it = (color & 0xffffff) | (val & 0xff000000);
+    std::uint32_t* p = pixelAt(bd, x, y);
+    const std::uint32_t val = BitmapData_as::toARGB(*p);
+    *p = bd.toPixel((color & 0xffffff) | (val & 0xff000000));
+    bd.updateObjects(x, y, 1, 1);
 }
 
 void
@@ -1783,8 +2808,8 @@ setPixel32(const BitmapData_as& bd, size_t x, size_t y, std::uint32_t color)
     if (bd.disposed()) return;
     if (x >= bd.width() || y >= bd.height()) return;
 
-    BitmapData_as::iterator it = pixelAt(bd, x, y);
-    *it = color;
+    *pixelAt(bd, x, y) = bd.toPixel(color);
+    bd.updateObjects(x, y, 1, 1);
 }
 
 void
@@ -1798,19 +2823,13 @@ fillRect(const BitmapData_as& bd, int x, int y, int w, int h,
     // the bitmap.    
     if (w == 0 || h == 0) return;
     
-    const size_t width = bd.width();
-
-    BitmapData_as::iterator it = bd.begin() + y * width;
-    BitmapData_as::iterator e = it + width * h;
-    
-    //assert(e <= bd.end());
+    const std::uint32_t pixel = bd.toPixel(color);
 
-    while (it != e) {
+    for (int i = 0; i < h; ++i) {
         // Fill from x for the width of the rectangle.
-        std::fill_n(it + x, w, color);
-        it += width;
+        std::fill_n(bd.row(y + i) + x, w, pixel);
     }
-    bd.updateObjects();
+    bd.updateObjects(x, y, w, h);
 }
 
 void
@@ -1822,19 +2841,20 @@ floodFill(const BitmapData_as& bd, size_t startx, size_t starty,
 
     if (startx >= width || starty >= height) return;
 
-    // We never compare alpha for RGB images.
-    if (!bd.transparent()) fill |= 0xff000000;
     if (old == fill) return;
 
     std::queue<PixelIndexer> pixelQueue;
     pixelQueue.push(PixelIndexer(startx, starty, pixelAt(bd, startx, starty)));
 
+    // The filled area.
+    geometry::Range2d<int> filled;
+
     while (!pixelQueue.empty()) {
 
         const PixelIndexer& p = pixelQueue.front();
         const size_t x = p.x;
         const size_t y = p.y;
-        BitmapData_as::iterator pix = p.pix;
+        std::uint32_t* pix = p.pix;
 
         pixelQueue.pop();
 
@@ -1843,10 +2863,10 @@ floodFill(const BitmapData_as& bd, size_t startx, size_t starty,
         if (*pix != old) continue;
 
         // Go east!
-        BitmapData_as::iterator east(pix);
+        std::uint32_t* east(pix);
         if (x + 1 < width) {
             ++east;
-            const BitmapData_as::iterator eaststop(pix + (width - x));
+            std::uint32_t* const eaststop(pix + (width - x));
             while (east != eaststop && *east == old) ++east;
             std::fill(pix, east, fill);
         }
@@ -1855,8 +2875,7 @@ floodFill(const BitmapData_as& bd, size_t startx, size_t starty,
 
         // Add north pixels
         if (y > 0) {
-            BitmapData_as::iterator north(pix - width);
-            BitmapData_as::iterator northend(north + edone);
+            std::uint32_t* north(pix - width);
             const size_t ny = y - 1;
             for (size_t nx = x; nx != (x + edone); ++nx, ++north) {
                 if (*north == old) {
@@ -1866,20 +2885,22 @@ floodFill(const BitmapData_as& bd, size_t startx, size_t starty,
         }
 
         // Go west!
-        BitmapData_as::iterator west(pix);
+        std::uint32_t* west(pix);
         if (x > 0) {
             --west;
-            const BitmapData_as::iterator weststop(pix - x);
+            std::uint32_t* const weststop(pix - x);
             while (west != weststop && *west == old) --west;
             std::fill(west + 1, pix, fill);
         }
         size_t wdone = (pix - west);
         if (!wdone) ++wdone;
+
+        filled.expandTo(x - wdone + 1, y);
+        filled.expandTo(x + edone - 1, y);
          
         // Add south pixels
         if (y + 1 < height) {
-            BitmapData_as::iterator south(pix + width);
-            BitmapData_as::iterator southend(south - wdone);
+            std::uint32_t* south(pix + width);
             const size_t sy = y + 1;
             for (size_t sx = x; sx != x - wdone; --sx, --south) {
                 if (*south == old) {
@@ -1890,7 +2911,9 @@ floodFill(const BitmapData_as& bd, size_t startx, size_t starty,
 
     }
 
-    bd.updateObjects();
+    if (filled.isNull()) return;
+    bd.updateObjects(filled.getMinX(), filled.getMinY(), filled.width() + 1,
+            filled.height() + 1);
 }
 
 void
@@ -1930,6 +2953,124 @@ adjustRect(int& x, int& y, int& w, int& h, const BitmapData_as& b)
 }
 
 
+void
+getRect(as_object& rect, VM& vm, int& x, int& y, int& w, int& h)
+{
+    as_value px, py, pw, ph;
+
+    rect.get_member(NSV::PROP_X, &px);
+    rect.get_member(NSV::PROP_Y, &py);
+    rect.get_member(NSV::PROP_WIDTH, &pw);
+    rect.get_member(NSV::PROP_HEIGHT, &ph);
+
+    x = toInt(px, vm);
+    y = toInt(py, vm);
+    w = toInt(pw, vm);
+    h = toInt(ph, vm);
+}
+
+void
+getPoint(as_object& point, VM& vm, int& x, int& y)
+{
+    as_value px, py;
+
+    point.get_member(NSV::PROP_X, &px);
+    point.get_member(NSV::PROP_Y, &py);
+
+    x = toInt(px, vm);
+    y = toInt(py, vm);
+}
+
+void
+clipCopy(const BitmapData_as& source, const BitmapData_as& dest,
+        int& sourceX, int& sourceY, int& w, int& h, int& destX, int& destY)
+{
+    // Any part of the source rect that is not in the image (i.e.
+    // above or left) is concatenated to the destination offset.
+    if (sourceX < 0) destX -= sourceX;
+    if (sourceY < 0) destY -= sourceY;
+
+    adjustRect(sourceX, sourceY, w, h, source);
+    if (w == 0 || h == 0) return;
+
+    // Any part of the dest rect that is cut off above or left is also
+    // cut off the source rect.
+    const int x = destX;
+    const int y = destY;
+    adjustRect(destX, destY, w, h, dest);
+    sourceX += destX - x;
+    sourceY += destY - y;
+}
+
+BitmapData_as*
+getCopyArea(const fn_call& fn, const BitmapData_as& dest, int& sourceX,
+        int& sourceY, int& w, int& h, int& destX, int& destY)
+{
+    VM& vm = getVM(fn);
+
+    BitmapData_as* source;
+    as_object* rect = toObject(fn.arg(1), vm);
+    as_object* point = toObject(fn.arg(2), vm);
+
+    if (!isNativeType(toObject(fn.arg(0), vm), source) || !rect || !point) {
+        IF_VERBOSE_ASCODING_ERRORS(
+            std::ostringstream ss;
+            fn.dump_args(ss);
+            log_aserror(_("BitmapData(%s): needs a BitmapData, a Rectangle "
+                          "and a Point"), ss.str());
+        );
+        return 0;
+    }
+
+    if (source->disposed()) return 0;
+
+    getRect(*rect, vm, sourceX, sourceY, w, h);
+    getPoint(*point, vm, destX, destY);
+    clipCopy(*source, dest, sourceX, sourceY, w, h, destX, destY);
+
+    if (w == 0 || h == 0) return 0;
+    return source;
+}
+
+as_object*
+createRectangle(const fn_call& fn, double x, double y, double w, double h)
+{
+    // If it's not found construction will fail.
+    as_value rectangle(findObject(fn.env(), "flash.geom.Rectangle"));
+    as_function* rectCtor = rectangle.to_function();
+
+    if (!rectCtor) {
+        IF_VERBOSE_ASCODING_ERRORS(
+            log_aserror(_("Failed to construct flash.geom.Rectangle!"));
+        );
+        return 0;
+    }
+
+    fn_call::Args args;
+    args += x, y, w, h;
+
+    return constructInstance(*rectCtor, fn.env(), args);
+}
+
+as_object*
+createBitmapData(const fn_call& fn, std::unique_ptr<image::GnashImage> im,
+        bool transparent)
+{
+    as_object* obj = ensure<ValidThis>(fn);
+
+    Global_as& gl = getGlobal(fn);
+    as_object* ret = createObject(gl);
+    const as_value& proto = getMember(*obj, NSV::PROP_uuPROTOuu);
+    if (proto.is_object()) {
+        ret->set_member(NSV::PROP_uuPROTOuu, proto);
+    }
+
+    ret->setRelay(new BitmapData_as(ret, std::move(im), transparent));
+
+    return ret;
+}
+
+
 std::uint8_t
 getChannel(std::uint32_t src, std::uint8_t bitmask)
 {
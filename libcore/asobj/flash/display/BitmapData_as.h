@@ -25,13 +25,15 @@
 #include <cstdint>
 #include <memory>
 #include <cassert>
+#include <cstring>
+#include <algorithm>
 #include <boost/intrusive_ptr.hpp>
 #include <memory>
 
 #include "Relay.h"
 #include "CachedBitmap.h"
 #include "GnashImage.h"
-#include "ImageIterators.h"
+#include "Range2d.h"
 
 namespace gnash {
     class as_object;
@@ -53,9 +55,15 @@ namespace gnash {
 /// in a Renderer, for instance, and only retrieved from there when a
 /// BitmapData instance requires access to it.
 //
-/// Because this retrieval can be expensive, it is advisable not to call
-/// member functions frequently, but rather to access the data through
-/// iterators. To facilitate this, iterators are random access.
+/// The pixels are always stored as premultiplied RGBA, one 32-bit word
+/// per pixel, which is the format the renderer draws from. Rows can be
+/// accessed directly, so that operations on whole areas are plain memory
+/// copies and fills; use toPixel() and toARGB() to convert single pixels
+/// to and from the ARGB colours used in ActionScript.
+//
+/// Because retrieval of the data can be expensive, it is advisable not to
+/// call member functions frequently, but rather to fetch a row once and
+/// work on it.
 //
 /// There is also overhead to calling functions such as width() and height(),
 /// again because the image data is retrieve from the Renderer. The size is
@@ -71,13 +79,18 @@ public:
         CHANNEL_ALPHA = 8
     };
 
-    typedef image::pixel_iterator<image::ARGB> iterator;
-
     /// Construct a BitmapData.
     //
     /// The constructor sets the immutable size of the
     /// bitmap, as well as whether it can handle transparency or not.
-	BitmapData_as(as_object* owner, std::unique_ptr<image::GnashImage> im);
+    //
+    /// @param im           The pixels. An RGBA image must be premultiplied
+    ///                     and is used as it is; an RGB image is converted
+    ///                     and makes an opaque BitmapData.
+    /// @param transparent  Whether the BitmapData has transparency. If not,
+    ///                     all alpha values of an RGBA image must be 0xff.
+	BitmapData_as(as_object* owner, std::unique_ptr<image::GnashImage> im,
+            bool transparent = true);
 
     virtual ~BitmapData_as() {}
 
@@ -102,7 +115,7 @@ public:
     /// Do not call if disposed!
     bool transparent() const {
         assert(data());
-        return (data()->type() == image::TYPE_RGBA);
+        return _transparent;
     }
 
     /// Return the image data
@@ -134,28 +147,69 @@ public:
     //
     /// Any callers requiring access to the data or any properties should
     /// check that this is false first. Particularly width(), height(), 
-    /// transparent(), begin(), end() may only be called if the BitmapData_as
+    /// transparent() and row() may only be called if the BitmapData_as
     /// has not been disposed.
     bool disposed() const {
         return !data();
     }
  
-    /// Return a BitmapData_as::iterator to the first pixel in the data.
-    iterator begin() const {
+    /// Return the stored pixels of a row.
+    //
+    /// Rows are contiguous, so the pixel below p is p + width().
+    //
+    /// Do not call if disposed!
+    std::uint32_t* row(size_t y) const {
         assert(!disposed());
-        return image::begin<image::ARGB>(*data());
+        return reinterpret_cast<std::uint32_t*>(scanline(*data(), y));
     }
-    
-    /// Return a BitmapData_as::iterator to a one-past-the end pixel.
-    iterator end() const {
-        assert(!disposed());
-        return image::end<image::ARGB>(*data());
+
+    /// Convert an ARGB colour to a stored pixel of this BitmapData.
+    //
+    /// Opaque BitmapDatas ignore the alpha value of the colour.
+    std::uint32_t toPixel(std::uint32_t argb) const {
+        return premultiply(_transparent ? argb : argb | 0xff000000);
     }
 
+    /// Convert an ARGB colour to a premultiplied RGBA pixel.
+    static std::uint32_t premultiply(std::uint32_t argb);
+
+    /// Convert a stored pixel to an ARGB colour.
+    static std::uint32_t toARGB(std::uint32_t pixel);
+
     /// Inform any attached objects that the data has changed.
     void updateObjects() const;
 
+    /// Inform any attached objects that an area of the data has changed.
+    //
+    /// The changed areas accumulate until the objects are informed, which
+    /// is done immediately unless the BitmapData_as is locked.
+    //
+    /// @param x    The x co-ordinate of the area's top left corner.
+    /// @param y    The y co-ordinate of the area's top left corner.
+    /// @param w    The width of the area.
+    /// @param h    The height of the area.
+    void updateObjects(int x, int y, int w, int h) const;
+
+    /// The area changed since the attached objects were last informed.
+    //
+    /// This is in pixels, and null if nothing changed. Attached objects
+    /// can query it from their update() function.
+    const geometry::Range2d<int>& changedArea() const {
+        return _changed;
+    }
+
+    /// Stop informing attached objects of changes until unlock().
+    void lock() {
+        _locked = true;
+    }
+
+    /// Inform attached objects of all changes made while locked.
+    void unlock();
+
 private:
+
+    /// Call update() on all attached objects and clear the changed area.
+    void notifyObjects() const;
     
     image::GnashImage* data() const {
         return _cachedBitmap.get() ? &_cachedBitmap->image() : _image.get();
@@ -170,8 +224,63 @@ private:
 
     std::list<DisplayObject*> _attachedObjects;
 
+    /// The area changed since the attached objects were last informed.
+    mutable geometry::Range2d<int> _changed;
+
+    /// Whether changes are held back until unlock().
+    bool _locked;
+
+    /// Whether the alpha values are used.
+    const bool _transparent;
+
 };
 
+inline std::uint32_t
+BitmapData_as::premultiply(std::uint32_t argb)
+{
+    const std::uint32_t a = argb >> 24;
+    if (a == 0xff) {
+        const std::uint8_t p[] = { static_cast<std::uint8_t>(argb >> 16),
+            static_cast<std::uint8_t>(argb >> 8),
+            static_cast<std::uint8_t>(argb), 0xff };
+        std::uint32_t pixel;
+        std::memcpy(&pixel, p, sizeof pixel);
+        return pixel;
+    }
+    if (!a) return 0;
+
+    const std::uint8_t p[] = {
+        static_cast<std::uint8_t>((((argb >> 16) & 0xff) * a + 127) / 255),
+        static_cast<std::uint8_t>((((argb >> 8) & 0xff) * a + 127) / 255),
+        static_cast<std::uint8_t>(((argb & 0xff) * a + 127) / 255),
+        static_cast<std::uint8_t>(a) };
+    std::uint32_t pixel;
+    std::memcpy(&pixel, p, sizeof pixel);
+    return pixel;
+}
+
+inline std::uint32_t
+BitmapData_as::toARGB(std::uint32_t pixel)
+{
+    std::uint8_t p[4];
+    std::memcpy(p, &pixel, sizeof pixel);
+    const std::uint32_t a = p[3];
+    if (a == 0xff) {
+        return 0xff000000 | (p[0] << 16) | (p[1] << 8) | p[2];
+    }
+    if (!a) return 0;
+
+    // Channels of a valid pixel are never above alpha, but images from
+    // SWF definitions are not checked.
+    const std::uint32_t r =
+        std::min<std::uint32_t>(0xff, (p[0] * 0xff + a / 2) / a);
+    const std::uint32_t g =
+        std::min<std::uint32_t>(0xff, (p[1] * 0xff + a / 2) / a);
+    const std::uint32_t b =
+        std::min<std::uint32_t>(0xff, (p[2] * 0xff + a / 2) / a);
+    return (a << 24) | (r << 16) | (g << 8) | b;
+}
+
 /// Initialize the global BitmapData class
 void bitmapdata_class_init(as_object& where, const ObjectURI& uri);
 
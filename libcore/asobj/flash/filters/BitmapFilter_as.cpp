@@ -18,12 +18,15 @@
 
 #include "BitmapFilter_as.h"
 
+#include <algorithm>
+
 #include "namedStrings.h"
 #include "as_object.h"
 #include "VM.h"
 #include "NativeFunction.h"
 #include "Global_as.h"
 #include "Filters.h"
+#include "Array_as.h"
 
 namespace gnash {
 
@@ -102,6 +105,31 @@ registerBitmapClass(as_object& where, Global_as::ASFunction ctor,
 
 }
 
+std::vector<float>
+readMatrix(const as_value& array, size_t size, VM& vm)
+{
+    std::vector<float> m(size, 0);
+    if (!array.is_object()) return m;
+
+    as_object* obj = array.get_object();
+    const size_t len = std::min(arrayLength(*obj), size);
+    for (size_t i = 0; i < len; ++i) {
+        const as_value* el = obj->getElement(i);
+        m[i] = toNumber(el ? *el : getOwnProperty(*obj, arrayKey(vm, i)), vm);
+    }
+    return m;
+}
+
+as_object*
+createMatrixArray(Global_as& gl, const std::vector<float>& m)
+{
+    as_object* array = gl.createArray();
+    for (float v : m) {
+        callMethod(array, NSV::PROP_PUSH, static_cast<double>(v));
+    }
+    return array;
+}
+
 namespace {
 
 void
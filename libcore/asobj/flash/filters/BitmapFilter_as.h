@@ -20,10 +20,14 @@
 #ifndef GNASH_ASOBJ_BITMAPFILTER_H
 #define GNASH_ASOBJ_BITMAPFILTER_H
 
+#include <vector>
+
 #include "Global_as.h"
 
 namespace gnash {
     class as_object;
+    class as_value;
+    class VM;
     struct ObjectURI;
 }
 
@@ -41,6 +45,14 @@ void registerBitmapFilterNative(as_object& global);
 void registerBitmapClass(as_object& where, Global_as::ASFunction ctor,
         Global_as::Properties p, const ObjectURI& uri);
 
+/// Read the numbers of an array, for the filters that have a matrix.
+//
+/// @param size     The number of values read: missing ones are 0.
+std::vector<float> readMatrix(const as_value& array, size_t size, VM& vm);
+
+/// Create an array holding the values of a filter matrix.
+as_object* createMatrixArray(Global_as& gl, const std::vector<float>& m);
+
 } // end of gnash namespace
 
 #endif
@@ -23,6 +23,7 @@
 #include "Global_as.h"
 #include "BitmapFilter_as.h"
 #include "Filters.h"
+#include "GnashNumeric.h"
 
 namespace gnash {
 
@@ -40,7 +41,10 @@ namespace {
 class BlurFilter_as : public Relay, public BlurFilter
 {
 public:
-    BlurFilter_as() {}
+    BlurFilter_as(float blurX, float blurY, std::uint8_t quality)
+        :
+        BlurFilter(blurX, blurY, quality)
+    {}
 };
 
 void
@@ -52,6 +56,14 @@ blurfilter_class_init(as_object& where, const ObjectURI& uri)
 
 namespace {
 
+/// The blur is applied from 0 to 15 times.
+std::uint8_t
+qualityByte(const as_value& val, const VM& vm)
+{
+    const double d = toNumber(val, vm);
+    return isNaN(d) ? 0 : clamp<double>(d, 0, 15);
+}
+
 void
 attachBlurFilterInterface(as_object& o)
 {
@@ -92,8 +104,7 @@ blurfilter_quality(const fn_call& fn)
     if (fn.nargs == 0) {
 		return as_value(ptr->m_quality );
     }
-    std::uint8_t sp_quality = toNumber(fn.arg(0), getVM(fn));
-    ptr->m_quality = sp_quality;
+    ptr->m_quality = qualityByte(fn.arg(0), getVM(fn));
     return as_value();
 }
 
@@ -101,7 +112,14 @@ as_value
 blurfilter_new(const fn_call& fn)
 {
     as_object* obj = ensure<ValidThis>(fn);
-    obj->setRelay(new BlurFilter_as);
+
+    // The defaults of the constructor arguments.
+    VM& vm = getVM(fn);
+    const float blurX = fn.nargs > 0 ? toNumber(fn.arg(0), vm) : 4;
+    const float blurY = fn.nargs > 1 ? toNumber(fn.arg(1), vm) : 4;
+    const std::uint8_t quality = fn.nargs > 2 ? qualityByte(fn.arg(2), vm) : 1;
+
+    obj->setRelay(new BlurFilter_as(blurX, blurY, quality));
     return as_value();
 }
 
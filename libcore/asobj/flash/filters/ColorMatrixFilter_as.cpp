@@ -40,7 +40,22 @@ namespace {
 class ColorMatrixFilter_as : public Relay, public ColorMatrixFilter
 {
 public:
-    ColorMatrixFilter_as() {}
+    /// The matrix starts as the identity.
+    ColorMatrixFilter_as()
+        :
+        ColorMatrixFilter(identity())
+    {}
+
+    void setMatrix(std::vector<float> m) {
+        m_matrix = std::move(m);
+    }
+
+private:
+    static std::vector<float> identity() {
+        std::vector<float> m(20, 0);
+        m[0] = m[6] = m[12] = m[18] = 1;
+        return m;
+    }
 };
 
 /// The prototype of flash.filters.ColorMatrixFilter is a new BitmapFilter.
@@ -65,7 +80,10 @@ as_value
 colormatrixfilter_matrix(const fn_call& fn)
 {
     ColorMatrixFilter_as* ptr = ensure<ThisIsNative<ColorMatrixFilter_as> >(fn);
-    UNUSED(ptr);
+    if (fn.nargs == 0) {
+        return createMatrixArray(getGlobal(fn), ptr->matrix());
+    }
+    ptr->setMatrix(readMatrix(fn.arg(0), 20, getVM(fn)));
     return as_value();
 }
 
@@ -73,7 +91,9 @@ as_value
 colormatrixfilter_new(const fn_call& fn)
 {
     as_object* obj = ensure<ValidThis>(fn);
-    obj->setRelay(new ColorMatrixFilter_as);
+    ColorMatrixFilter_as* filter = new ColorMatrixFilter_as;
+    if (fn.nargs) filter->setMatrix(readMatrix(fn.arg(0), 20, getVM(fn)));
+    obj->setRelay(filter);
     return as_value();
 }
 
@@ -20,11 +20,14 @@
 
 #include "ConvolutionFilter_as.h"
 
+#include <algorithm>
+
 #include "as_object.h"
 #include "VM.h"
 #include "Global_as.h"
 #include "BitmapFilter_as.h"
 #include "Filters.h"
+#include "GnashNumeric.h"
 
 namespace gnash {
 
@@ -48,7 +51,32 @@ namespace {
 class ConvolutionFilter_as : public Relay, public ConvolutionFilter
 {
 public:
-    ConvolutionFilter_as() {}
+    ConvolutionFilter_as() {
+        _divisor = 1;
+        _preserveAlpha = true;
+        _clamp = true;
+    }
+
+    /// Set the size of the matrix, keeping the values that still fit.
+    void setSize(std::uint8_t x, std::uint8_t y) {
+        std::vector<float> m(x * y, 0);
+        for (size_t j = 0; j < std::min(y, _matrixY); ++j) {
+            for (size_t i = 0; i < std::min(x, _matrixX); ++i) {
+                m[j * x + i] = _matrix[j * _matrixX + i];
+            }
+        }
+        _matrixX = x;
+        _matrixY = y;
+        _matrix.swap(m);
+    }
+
+    void setMatrix(std::vector<float> m) { _matrix = std::move(m); }
+    void setDivisor(float d) { _divisor = d; }
+    void setBias(float b) { _bias = b; }
+    void setPreserveAlpha(bool p) { _preserveAlpha = p; }
+    void setClamp(bool c) { _clamp = c; }
+    void setColor(std::uint32_t c) { _color = c & 0xffffff; }
+    void setAlpha(std::uint8_t a) { _alpha = a; }
 };
 
 /// The prototype of flash.filters.ConvolutionFilter is a new BitmapFilter.
@@ -61,6 +89,21 @@ convolutionfilter_class_init(as_object& where, const ObjectURI& uri)
 
 namespace {
 
+/// A matrix has at most 15 columns and rows.
+std::uint8_t
+matrixSize(const as_value& val, const VM& vm)
+{
+    return clamp<int>(toInt(val, vm), 0, 15);
+}
+
+/// The alpha of off-image pixels is set as a number from 0 to 1.
+std::uint8_t
+alphaByte(const as_value& val, const VM& vm)
+{
+    const double d = toNumber(val, vm);
+    return isNaN(d) ? 0 : clamp<double>(d, 0, 1) * 255;
+}
+
 void
 attachConvolutionFilterInterface(as_object& o)
 {
@@ -89,8 +132,10 @@ as_value
 convolutionfilter_matrixX(const fn_call& fn)
 {
     ConvolutionFilter_as* ptr = ensure<ThisIsNative<ConvolutionFilter_as> >(fn);
-    UNUSED(ptr);
-    log_unimpl(__PRETTY_FUNCTION__);
+    if (fn.nargs == 0) {
+        return as_value(ptr->matrixX());
+    }
+    ptr->setSize(matrixSize(fn.arg(0), getVM(fn)), ptr->matrixY());
     return as_value();
 }
 
@@ -98,8 +143,10 @@ as_value
 convolutionfilter_matrixY(const fn_call& fn)
 {
     ConvolutionFilter_as* ptr = ensure<ThisIsNative<ConvolutionFilter_as> >(fn);
-    UNUSED(ptr);
-    log_unimpl(__PRETTY_FUNCTION__);
+    if (fn.nargs == 0) {
+        return as_value(ptr->matrixY());
+    }
+    ptr->setSize(ptr->matrixX(), matrixSize(fn.arg(0), getVM(fn)));
     return as_value();
 }
 
@@ -107,8 +154,10 @@ as_value
 convolutionfilter_divisor(const fn_call& fn)
 {
     ConvolutionFilter_as* ptr = ensure<ThisIsNative<ConvolutionFilter_as> >(fn);
-    UNUSED(ptr);
-    log_unimpl(__PRETTY_FUNCTION__);
+    if (fn.nargs == 0) {
+        return as_value(ptr->divisor());
+    }
+    ptr->setDivisor(toNumber(fn.arg(0), getVM(fn)));
     return as_value();
 }
 
@@ -116,8 +165,10 @@ as_value
 convolutionfilter_bias(const fn_call& fn)
 {
     ConvolutionFilter_as* ptr = ensure<ThisIsNative<ConvolutionFilter_as> >(fn);
-    UNUSED(ptr);
-    log_unimpl(__PRETTY_FUNCTION__);
+    if (fn.nargs == 0) {
+        return as_value(ptr->bias());
+    }
+    ptr->setBias(toNumber(fn.arg(0), getVM(fn)));
     return as_value();
 }
 
@@ -125,8 +176,10 @@ as_value
 convolutionfilter_preserveAlpha(const fn_call& fn)
 {
     ConvolutionFilter_as* ptr = ensure<ThisIsNative<ConvolutionFilter_as> >(fn);
-    UNUSED(ptr);
-    log_unimpl(__PRETTY_FUNCTION__);
+    if (fn.nargs == 0) {
+        return as_value(ptr->preserveAlpha());
+    }
+    ptr->setPreserveAlpha(toBool(fn.arg(0), getVM(fn)));
     return as_value();
 }
 
@@ -134,8 +187,10 @@ as_value
 convolutionfilter_clamp(const fn_call& fn)
 {
     ConvolutionFilter_as* ptr = ensure<ThisIsNative<ConvolutionFilter_as> >(fn);
-    UNUSED(ptr);
-    log_unimpl(__PRETTY_FUNCTION__);
+    if (fn.nargs == 0) {
+        return as_value(ptr->clamp());
+    }
+    ptr->setClamp(toBool(fn.arg(0), getVM(fn)));
     return as_value();
 }
 
@@ -143,8 +198,10 @@ as_value
 convolutionfilter_color(const fn_call& fn)
 {
     ConvolutionFilter_as* ptr = ensure<ThisIsNative<ConvolutionFilter_as> >(fn);
-    UNUSED(ptr);
-    log_unimpl(__PRETTY_FUNCTION__);
+    if (fn.nargs == 0) {
+        return as_value(ptr->color());
+    }
+    ptr->setColor(toInt(fn.arg(0), getVM(fn)));
     return as_value();
 }
 
@@ -152,8 +209,10 @@ as_value
 convolutionfilter_alpha(const fn_call& fn)
 {
     ConvolutionFilter_as* ptr = ensure<ThisIsNative<ConvolutionFilter_as> >(fn);
-    UNUSED(ptr);
-    log_unimpl(__PRETTY_FUNCTION__);
+    if (fn.nargs == 0) {
+        return as_value(ptr->alpha() / 255.0);
+    }
+    ptr->setAlpha(alphaByte(fn.arg(0), getVM(fn)));
     return as_value();
 }
 
@@ -161,8 +220,11 @@ as_value
 convolutionfilter_matrix(const fn_call& fn)
 {
     ConvolutionFilter_as* ptr = ensure<ThisIsNative<ConvolutionFilter_as> >(fn);
-    UNUSED(ptr);
-    log_unimpl(__PRETTY_FUNCTION__);
+    if (fn.nargs == 0) {
+        return createMatrixArray(getGlobal(fn), ptr->matrix());
+    }
+    ptr->setMatrix(readMatrix(fn.arg(0),
+                ptr->matrixX() * ptr->matrixY(), getVM(fn)));
     return as_value();
 }
 
@@ -170,7 +232,24 @@ as_value
 convolutionfilter_new(const fn_call& fn)
 {
     as_object* obj = ensure<ValidThis>(fn);
-    obj->setRelay(new ConvolutionFilter_as);
+    ConvolutionFilter_as* filter = new ConvolutionFilter_as;
+
+    VM& vm = getVM(fn);
+    if (fn.nargs > 1) {
+        filter->setSize(matrixSize(fn.arg(0), vm), matrixSize(fn.arg(1), vm));
+    }
+    if (fn.nargs > 2) {
+        filter->setMatrix(readMatrix(fn.arg(2),
+                    filter->matrixX() * filter->matrixY(), vm));
+    }
+    if (fn.nargs > 3) filter->setDivisor(toNumber(fn.arg(3), vm));
+    if (fn.nargs > 4) filter->setBias(toNumber(fn.arg(4), vm));
+    if (fn.nargs > 5) filter->setPreserveAlpha(toBool(fn.arg(5), vm));
+    if (fn.nargs > 6) filter->setClamp(toBool(fn.arg(6), vm));
+    if (fn.nargs > 7) filter->setColor(toInt(fn.arg(7), vm));
+    if (fn.nargs > 8) filter->setAlpha(alphaByte(fn.arg(8), vm));
+
+    obj->setRelay(filter);
     return as_value();
 }
 
@@ -25,6 +25,7 @@
 #include <sstream>
 #include <map>
 #include <bitset>
+#include <limits>
 #include <cassert>
 #include <functional>
 #include <boost/algorithm/string/replace.hpp>
@@ -58,6 +59,7 @@
 #include "StreamProvider.h"
 #include "SystemClock.h"
 #include "as_function.h"
+#include "FrameTimes.h"
 
 #ifdef USE_SWFTREE
 # include "tree.hh"
@@ -165,6 +167,7 @@ movie_root::movie_root(VirtualClock& clock, const RunResources& runResources)
     _timeoutLimit(),   // set in ctor body
     _movieAdvancementDelay(83), // ~12 fps by default
     _lastMovieAdvancement(0),
+    _maxLateFrames(0),
     _unnamedInstance(0),
     _movieLoader(*this)
 {
@@ -190,7 +193,7 @@ movie_root::disableScripts()
 movie_root::~movie_root()
 {
     clear(_actionQueue);
-    _intervalTimers.clear();
+    clearIntervalTimers();
     _movieLoader.clear();
 
     //assert(testInvariant());
@@ -301,6 +304,8 @@ movie_root::handleActionLimitHit(const std::string& msg)
 void
 movie_root::cleanupAndCollect()
 {
+    GNASH_FRAME_PHASE(CLEANUP_AND_COLLECT);
+
     // Cleanup the stack.
     _vm.getStack().clear();
 
@@ -536,7 +541,7 @@ movie_root::reset()
     _movies.clear();
 
     // remove all intervals
-    _intervalTimers.clear();
+    clearIntervalTimers();
 
     // remove all loadMovie requests
     _movieLoader.clear();
@@ -819,6 +824,7 @@ movie_root::addIntervalTimer(std::unique_ptr<Timer> timer)
 
     //assert(_intervalTimers.find(id) == _intervalTimers.end());
 
+    _timerQueue.push(std::make_pair(timer->expiryTime(), id));
     _intervalTimers.insert(std::make_pair(id, std::move(timer)));
 
     return id;
@@ -834,12 +840,12 @@ movie_root::clearIntervalTimer(std::uint32_t x)
 
     // We do not remove the element here because
     // we might have been called during execution
-    // of another timer, thus during a scan of the _intervalTimers
-    // container. If we use erase() here, the iterators in executeTimers
-    // would be invalidated. Rather, executeTimers() would check container
-    // elements for being still active and remove the cleared one in a safe way
-    // at each iteration.
+    // of this or another timer. If we use erase() here, the Timer
+    // being executed by executeTimers() could be destroyed. Rather,
+    // executeTimers() removes the cleared ones in a safe way on its
+    // next call.
     it->second->clearInterval();
+    _clearedTimers.push_back(x);
 
     return true;
 }
@@ -931,7 +937,16 @@ movie_root::advance()
             if (elapsed >= _movieAdvancementDelay) {
                 advanced = true;
                 advanceMovie();
-                _lastMovieAdvancement = now;
+
+                // Stay on the frame rate grid if we can still catch up,
+                // otherwise drop the missed frames.
+                const size_t late = elapsed - _movieAdvancementDelay;
+                if (late < _maxLateFrames * _movieAdvancementDelay) {
+                    _lastMovieAdvancement += _movieAdvancementDelay;
+                }
+                else {
+                    _lastMovieAdvancement = now;
+                }
             }
 #ifdef USE_SOUND
         }
@@ -979,7 +994,10 @@ movie_root::advanceMovie()
 
     // Process queued actions
     // NOTE: can throw ActionLimitException
-    processActionQueue();
+    {
+        GNASH_FRAME_PHASE(PROCESS_ACTION_QUEUE);
+        processActionQueue();
+    }
 
     cleanupAndCollect();
 
@@ -994,10 +1012,32 @@ movie_root::timeToNextFrame() const
     return _movieAdvancementDelay - elapsed;
 }
 
+size_t
+movie_root::framesDue() const
+{
+    if (!_movieAdvancementDelay) return 0;
+    const size_t now = std::max<size_t>(_vm.getTime(), _lastMovieAdvancement);
+    return (now - _lastMovieAdvancement) / _movieAdvancementDelay;
+}
+
+int
+movie_root::timeToNextTimer() const
+{
+    if (_timerQueue.empty()) return -1;
+
+    const unsigned long now = _vm.getTime();
+    const unsigned long next = _timerQueue.top().first;
+    if (next <= now) return 0;
+
+    return std::min<unsigned long>(next - now,
+            std::numeric_limits<int>::max());
+}
+
 void
 movie_root::display()
 {
     // GNASH_REPORT_FUNCTION;
+    GNASH_FRAME_PHASE(DISPLAY);
 
     //assert(testInvariant());
 
@@ -1357,6 +1397,8 @@ movie_root::setStageDisplayState(const DisplayState ds)
 void
 movie_root::add_invalidated_bounds(InvalidatedRanges& ranges, bool force)
 {
+    GNASH_FRAME_PHASE(INVALIDATED_BOUNDS);
+
     if (isInvalidated()) {
         ranges.setWorld();
         return;
@@ -1703,50 +1745,77 @@ movie_root::processInvoke(ExternalInterface::invoke_t *invoke)
 void
 movie_root::executeTimers()
 {
+    GNASH_FRAME_PHASE(EXECUTE_TIMERS);
+
 #ifdef GNASH_DEBUG_TIMERS_EXPIRATION
     log_debug("Checking %d timers for expiry", _intervalTimers.size());
 #endif
 
+    // Drop timers cleared since last time; their queue entries
+    // will be discarded when they reach the front.
+    for (std::uint32_t id : _clearedTimers) {
+        _intervalTimers.erase(id);
+    }
+    _clearedTimers.clear();
+
     // Don't do anything if we have no timers, just return so we don't
     // waste cpu cycles.
     if (_intervalTimers.empty()) {
+        _timerQueue = TimerQueue();
         return;
     }
 
-    unsigned long now = _vm.getTime();
+    const unsigned long now = _vm.getTime();
 
-    typedef std::multimap<unsigned long, Timer*>
-        ExpiredTimers;
+    // Collect all expired timers first, so that none is executed twice
+    // and timers added by the callbacks wait for the next call. The
+    // queue gives them in order of expiration, then of creation.
+    typedef std::vector<std::pair<std::uint32_t, Timer*> > ExpiredTimers;
 
     ExpiredTimers expiredTimers;
 
-    for (TimerMap::iterator it = _intervalTimers.begin(),
-            itEnd = _intervalTimers.end(); it != itEnd; ) {
+    while (!_timerQueue.empty() && _timerQueue.top().first <= now) {
 
-        TimerMap::iterator nextIterator = it;
-        ++nextIterator;
+        const std::uint32_t id = _timerQueue.top().second;
+        _timerQueue.pop();
 
-        Timer* timer = it->second.get();
+        TimerMap::const_iterator it = _intervalTimers.find(id);
+        if (it == _intervalTimers.end()) continue;
 
+        Timer* timer = it->second.get();
         if (timer->cleared()) {
             // this timer was cleared, erase it
             _intervalTimers.erase(it);
+            continue;
         }
-        else {
-            unsigned long elapsed;
-            if (timer->expired(now, elapsed)) {
-                expiredTimers.insert(std::make_pair(elapsed, timer));
-            }
-        }
-
-        it = nextIterator;
+        expiredTimers.push_back(std::make_pair(id, timer));
     }
 
+    if (expiredTimers.empty()) return;
+
     foreachSecond(expiredTimers.begin(), expiredTimers.end(),
                   &Timer::executeAndReset);
 
-    if (!expiredTimers.empty())
-        processActionQueue();
+    // Reschedule the survivors.
+    for (const ExpiredTimers::value_type& e : expiredTimers) {
+        TimerMap::iterator it = _intervalTimers.find(e.first);
+        if (it == _intervalTimers.end()) continue;
+        if (it->second->cleared()) {
+            _intervalTimers.erase(it);
+            continue;
+        }
+        _timerQueue.push(std::make_pair(it->second->expiryTime(), e.first));
+    }
+
+    processActionQueue();
+}
+
+void
+movie_root::clearIntervalTimers()
+{
+    _intervalTimers.clear();
+    _timerQueue = TimerQueue();
+    _clearedTimers.clear();
 }
 
 void
@@ -2097,6 +2166,8 @@ movie_root::cleanupDisplayList()
 void
 movie_root::advanceLiveChars()
 {
+    GNASH_FRAME_PHASE(ADVANCE_LIVE_CHARS);
+
 #ifdef GNASH_DEBUG
     log_debug("---- movie_root::advance: %d live DisplayObjects in the global list",
                 _liveChars.size());
@@ -69,6 +69,7 @@
 #endif
 
 #include <map>
+#include <queue>
 #include <string>
 #include <vector>
 #include <forward_list>
@@ -371,6 +372,36 @@ public:
     ///
     int timeToNextFrame() const;
 
+    /// Return the number of timeline frames due for advancement
+    //
+    /// This is more than one if the hosting application is late, in
+    /// which case it may skip rendering of the intermediate frames.
+    ///
+    size_t framesDue() const;
+
+    /// Set how many frames the timeline may fall behind and still
+    /// catch up
+    //
+    /// When late by fewer frames, advance() stays on the frame rate
+    /// grid, so that successive calls advance the missed frames.
+    /// Otherwise, and by default (0), the timeline resynchronises
+    /// with the clock and the missed frames are lost.
+    ///
+    void setMaxLateFrames(size_t frames) {
+        _maxLateFrames = frames;
+    }
+
+    /// \brief
+    /// Return the number of milliseconds available before
+    /// the next interval timer is due to expire.
+    //
+    /// Return value is 0 if a timer is already late, and -1 if
+    /// there are no pending timers. Timers cleared since the last
+    /// advance may still be counted, so the hosting application
+    /// can at worst wake up early.
+    ///
+    int timeToNextTimer() const;
+
     /// Entry point for movie advancement
     //
     /// This function does:
@@ -892,8 +923,14 @@ private:
     void executeAdvanceCallbacks();
     
     /// Execute expired timers
+    //
+    /// Only timers at the front of the timer queue are touched, so
+    /// the cost does not depend on the number of pending timers.
     void executeTimers();
 
+    /// Remove all interval timers
+    void clearIntervalTimers();
+
     /// Cleanup references to unloaded DisplayObjects and run the GC.
     void cleanupAndCollect();
 
@@ -1018,6 +1055,23 @@ private:
 
     TimerMap _intervalTimers;
 
+    /// An expiration time and the id of the timer expiring then
+    typedef std::pair<unsigned long, std::uint32_t> TimerQueueEntry;
+
+    /// Min-heap of timer expirations, earliest first
+    //
+    /// There is exactly one entry for each active timer. Entries for
+    /// timers cleared in the meantime are discarded when popped.
+    typedef std::priority_queue<TimerQueueEntry, std::vector<TimerQueueEntry>,
+            std::greater<TimerQueueEntry> > TimerQueue;
+
+    TimerQueue _timerQueue;
+
+    /// Ids of timers cleared since the last executeTimers() call
+    //
+    /// They can't be erased immediately as they may be executing.
+    std::vector<std::uint32_t> _clearedTimers;
+
     size_t _lastTimerId;
 
     /// bit-array for recording the unreleased keys
@@ -1094,6 +1148,9 @@ private:
     // time of last movie advancement, in milliseconds
     size_t _lastMovieAdvancement;
 
+    // number of frames the timeline may be late and still catch up
+    size_t _maxLateFrames;
+
     /// The number of the last unnamed instance, used to name instances.
     size_t _unnamedInstance;
 
@@ -39,6 +39,9 @@
 #include "IOChannel.h"
 #include "SWFStream.h"
 #include "RunResources.h"
+#include "StreamProvider.h"
+#include "MovieFactory.h"
+#include "URL.h"
 #include "Font.h"
 #include "VM.h"
 #include "log.h"
@@ -382,6 +385,19 @@ SWFMovieDefinition::ensure_frame_loaded(size_t framenum) const
     return ( framenum <= _frames_loaded.load() );
 }
 
+void
+SWFMovieDefinition::prefetch(const std::string& url) const
+{
+    // Relative URLs are resolved as loadMovie does.
+    try {
+        const URL& base = _runResources.streamProvider().baseURL();
+        MovieFactory::prefetch(URL(url, base), _runResources);
+    }
+    catch (const GnashException& e) {
+        log_debug("Not prefetching %s: %s", url, e.what());
+    }
+}
+
 Movie*
 SWFMovieDefinition::createMovie(Global_as& gl, DisplayObject* parent)
 {
@@ -350,6 +350,9 @@ public:
     }
 
     virtual const std::string& get_url() const { return _url; }
+
+    /// Prefetch a movie or media file with the resources of this movie.
+    virtual void prefetch(const std::string& url) const;
     
     /// Get the id that corresponds to a symbol.
     //
@@ -22,12 +22,16 @@
 
 #include <string>
 #include <cstring> // for memcpy
+#include <algorithm>
 
 #include "log.h"
+#include "rc.h"
 #include "SWFStream.h"
 #include "SWF.h"
 #include "ASHandlers.h"
 #include "movie_definition.h"
+#include "StringPredicates.h"
+#include "GnashAlgorithm.h"
 
 namespace gnash {
 
@@ -35,6 +39,7 @@ namespace gnash {
 namespace {
     float convert_float_little(const void *p);
     double convert_double_wacky(const void *p);
+    bool isPrefetchable(const char* str, size_t len);
 }
 
 action_buffer::action_buffer(const movie_definition& md)
@@ -94,7 +99,77 @@ action_buffer::read(SWFStream& in, unsigned long endPos)
                     "end with an END tag"), startPos);
         );
     }
-    
+
+    if (RcInitFile::getDefaultInstance().getPrefetchBudget()) {
+        prefetchURLs();
+    }
+}
+
+void
+action_buffer::prefetchURLs() const
+{
+    const char* buf = reinterpret_cast<const char*>(m_buffer.data());
+    const size_t size = m_buffer.size();
+
+    // Prefetch the null-terminated string at pos if it names a file,
+    // and return the position after it.
+    auto prefetchString = [&](size_t pos, size_t end) -> size_t {
+        const char* str = buf + pos;
+        const char* nul =
+            static_cast<const char*>(std::memchr(str, 0, end - pos));
+        if (!nul) return end;
+        if (isPrefetchable(str, nul - str)) {
+            _src.prefetch(std::string(str, nul));
+        }
+        return pos + (nul - str) + 1;
+    };
+
+    size_t pc = 0;
+    while (pc < size) {
+
+        const std::uint8_t action = m_buffer[pc];
+        if (action == SWF::ACTION_END) break;
+        if (!(action & 0x80)) {
+            ++pc;
+            continue;
+        }
+        if (pc + 3 > size) break;
+
+        const size_t length = m_buffer[pc + 1] | (m_buffer[pc + 2] << 8);
+        const size_t end = std::min(pc + 3 + length, size);
+        size_t i = pc + 3;
+
+        switch (action) {
+
+            case SWF::ACTION_CONSTANTPOOL:
+                // Skip the number of strings.
+                i += 2;
+                // Fall through
+            case SWF::ACTION_GETURL:
+                while (i < end) i = prefetchString(i, end);
+                break;
+
+            case SWF::ACTION_PUSHDATA:
+                while (i < end) {
+                    const std::uint8_t type = m_buffer[i++];
+                    if (!type) {
+                        i = prefetchString(i, end);
+                        continue;
+                    }
+                    // Sizes of the other types of values.
+                    static const size_t sizes[] =
+                        { 0, 4, 0, 0, 1, 1, 8, 4, 1, 2 };
+                    if (type >= arraySize(sizes)) break;
+                    i += sizes[type];
+                }
+                break;
+
+            default:
+                break;
+        }
+
+        pc += 3 + length;
+    }
 }
 
 const ConstantPool&
@@ -617,6 +692,24 @@ convert_double_wacky(const void *p)
     return u.d;
 }
 
+/// Whether a string is the URL of a movie or media file.
+//
+/// Only the extension is checked, ignoring any query string.
+bool
+isPrefetchable(const char* str, size_t len)
+{
+    const char* query = static_cast<const char*>(std::memchr(str, '?', len));
+    if (query) len = query - str;
+
+    // The shortest one is "a.swf"; long strings are not file names.
+    if (len < 5 || len > 1024) return false;
+
+    const std::string ext(str + len - 4, 4);
+    StringNoCaseEqual noCaseCompare;
+    return noCaseCompare(ext, ".swf") || noCaseCompare(ext, ".mp3") ||
+        noCaseCompare(ext, ".flv");
+}
+
 } // unnamed namespace
 } // namespace gnash
 
@@ -188,6 +188,12 @@ public:
 
 private:
 
+	/// Prefetch the movies and media files named in the code.
+	//
+	/// The strings looked at are those of ConstantPool, PushData and
+	/// GetURL actions, including the ones in function bodies.
+	void prefetchURLs() const;
+
 	/// the code itself, as read from the SWF
 	std::vector<std::uint8_t> m_buffer;
 
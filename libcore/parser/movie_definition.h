@@ -422,6 +422,15 @@ public:
 		return true;
 	}
 
+	/// Prefetch a movie or media file that may be loaded later.
+	//
+	/// @param url	The URL as found in the actions of this definition,
+	///		relative to the base URL of the run.
+	///
+	/// By default nothing is prefetched.
+	virtual void prefetch(const std::string& /*url*/) const {
+	}
+
 	/// \brief
 	/// Ensure that frame number 'framenum' (1-based offset)
 	/// has been loaded (load on demand).
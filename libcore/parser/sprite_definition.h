@@ -259,6 +259,11 @@ private:
 		return m_movie_def.get_url();
 	}
 
+	virtual void prefetch(const std::string& url) const
+	{
+		m_movie_def.prefetch(url);
+	}
+
 	/// \brief
 	/// Ensure framenum frames of this sprite
 	/// have been loaded.
@@ -69,6 +69,22 @@ private:
     const double _ratio;
 };
 
+/// Interpolate the edges of two paths with as many edges.
+//
+/// This is the usual case, and a loop without branches that compilers
+/// can vectorize.
+void
+lerpEdges(Edge* e, const Edge* e1, const Edge* e2, size_t count,
+        const double ratio)
+{
+    for (size_t j = 0; j < count; ++j) {
+        e[j].cp.x = static_cast<int>(lerp<float>(e1[j].cp.x, e2[j].cp.x, ratio));
+        e[j].cp.y = static_cast<int>(lerp<float>(e1[j].cp.y, e2[j].cp.y, ratio));
+        e[j].ap.x = static_cast<int>(lerp<float>(e1[j].ap.x, e2[j].ap.x, ratio));
+        e[j].ap.y = static_cast<int>(lerp<float>(e1[j].ap.y, e2[j].ap.y, ratio));
+    }
+}
+
 } // anonymous namespace
 
 ShapeRecord::ShapeRecord(SWFStream& in, SWF::TagType tag, movie_definition& m,
@@ -179,6 +195,14 @@ ShapeRecord::setLerp(const ShapeRecord& aa, const ShapeRecord& bb,
         const size_t len = p1.size();
         p.m_edges.resize(len);
 
+        // The end path usually matches the start path.
+        if (len && !k && p2.size() == len) {
+            lerpEdges(p.m_edges.data(), p1.m_edges.data(), p2.m_edges.data(),
+                    len, ratio);
+            ++n;
+            continue;
+        }
+
         for (size_t j=0; j < p.size(); j++) {
             Edge& e = p[j];
             const Edge& e1 = j < p1.size() ? p1[j] : empty_edge;
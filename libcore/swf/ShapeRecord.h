@@ -83,6 +83,10 @@ public:
         _paths.push_back(path);
     }
 
+    void addPath(Path&& path) {
+        _paths.push_back(std::move(path));
+    }
+
     void addLineStyle(const LineStyle& ls) {
         _lineStyles.push_back(ls);
     }
@@ -159,10 +163,18 @@ public:
     	return _subshapes;
     }
 
+    Subshapes& subshapes() {
+    	return _subshapes;
+    }
+
     void addSubshape(const Subshape& subshape) {
     	_subshapes.push_back(subshape);
     }
 
+    void addSubshape(Subshape&& subshape) {
+    	_subshapes.push_back(std::move(subshape));
+    }
+
     const SWFRect& getBounds() const {
         return _bounds;
     }
@@ -28,6 +28,7 @@
 #include <vector>
 #include <boost/random.hpp>
 #include <algorithm> 
+#include <limits>
 
 #include "log.h"
 #include "SWF.h"
@@ -78,6 +79,14 @@ namespace {
     /// @return     null if the value cannot be converted to an object.
     as_object* safeToObject(VM& vm, const as_value& val);
 
+    /// Return the array index a member name stands for, if it is a number.
+    //
+    /// This spares converting numbers to strings for the usual a[i].
+    //
+    /// @return     The index, or -1 if the name is not a number or not an
+    ///             array index.
+    int arrayIndex(const as_value& name, const VM& vm);
+
     /// Common code for ActionGetUrl and ActionGetUrl2
     //
     /// @param target         the target window or _level1 to _level10
@@ -2355,16 +2364,6 @@ ActionVar(ActionExec& thread)
     env.drop(1);
 }
 
-namespace patch
-{
-    template < typename T > std::string to_string( const T& n )
-    {
-        std::ostringstream stm ;
-        stm << n ;
-        return stm.str() ;
-    }
-}
-
 void
 ActionInitArray(ActionExec& thread)
 {
@@ -2380,9 +2379,7 @@ ActionInitArray(ActionExec& thread)
     VM& vm = getVM(env);
     // Fill the elements with the initial values from the stack.
     for (int i = 0; i < array_size; i++) {
-        const ObjectURI& k = 
-            getURI(vm, patch::to_string(i));
-        ao->set_member(k, env.pop());
+        ao->set_member(vm.getIndexURI(i), env.pop());
     }
 
     env.push(ao);
@@ -2601,14 +2598,24 @@ ActionGetMember(ActionExec& thread)
                    target, static_cast<void*>(obj));
     );
 
-    const ObjectURI& k = getURI(getVM(env), member_name.to_string());
+    VM& vm = getVM(env);
+    const int index = arrayIndex(member_name, vm);
+    const as_value* element = index < 0 ? nullptr : obj->getElement(index);
+
+    if (element) {
+        env.top(1) = *element;
+    }
+    else {
+        const ObjectURI& k = index < 0 ?
+            getURI(vm, member_name.to_string()) : vm.getIndexURI(index);
 
-    if (!obj->get_member(k, &env.top(1))) {
-        IF_VERBOSE_ASCODING_ERRORS(
-            log_aserror("Reference to undefined member %s of object %s",
-                member_name, target);
-        );
-        env.top(1).set_undefined();
+        if (!obj->get_member(k, &env.top(1))) {
+            IF_VERBOSE_ASCODING_ERRORS(
+                log_aserror("Reference to undefined member %s of object %s",
+                    member_name, target);
+            );
+            env.top(1).set_undefined();
+        }
     }
 
     IF_VERBOSE_ACTION (
@@ -2624,10 +2631,24 @@ ActionSetMember(ActionExec& thread)
 {
     as_environment& env = thread.env;
 
-    as_object* obj = safeToObject(getVM(thread.env), env.top(2));
-    const std::string& member_name = env.top(1).to_string();
+    VM& vm = getVM(env);
+    as_object* obj = safeToObject(vm, env.top(2));
     const as_value& member_value = env.top(0);
 
+    const int index = arrayIndex(env.top(1), vm);
+    if (obj && index >= 0) {
+        obj->set_member(vm.getIndexURI(index), member_value);
+
+        IF_VERBOSE_ACTION (
+            log_action(_("-- set_member %s.%d=%s"), env.top(2), index,
+                member_value);
+        );
+        env.drop(3);
+        return;
+    }
+
+    const std::string& member_name = env.top(1).to_string();
+
     if (member_name.empty()) {
         IF_VERBOSE_ASCODING_ERRORS (
             // Invalid object, can't set.
@@ -2637,7 +2658,7 @@ ActionSetMember(ActionExec& thread)
         );
     }
     else if (obj) {
-        obj->set_member(getURI(getVM(env), member_name), member_value);
+        obj->set_member(getURI(vm, member_name), member_value);
 
         IF_VERBOSE_ACTION (
             log_action(_("-- set_member %s.%s=%s"),
@@ -3465,6 +3486,18 @@ safeToObject(VM& vm, const as_value& val)
     }
 }
 
+int
+arrayIndex(const as_value& name, const VM& vm)
+{
+    if (!name.is_number()) return -1;
+
+    const double d = toNumber(name, vm);
+    if (!(d >= 0 && d <= std::numeric_limits<int>::max())) return -1;
+
+    const int index = static_cast<int>(d);
+    return index == d ? index : -1;
+}
+
 // Utility: construct an object using given constructor.
 // This is used by both ActionNew and ActionNewMethod and
 // hides differences between builtin and actionscript-defined
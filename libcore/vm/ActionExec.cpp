@@ -256,6 +256,7 @@ ActionExec::operator()()
             }
 
             ash.execute(static_cast<SWF::ActionType>(action_id), *this);
+            vm.countAction();
 
             // Code round here has to do with bugs: #20974, #21069, #20996,
             // but since there is so much disabled code it's not clear exactly
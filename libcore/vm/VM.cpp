@@ -28,7 +28,9 @@
 #include <memory>
 #include <boost/random.hpp> // for random generator
 #include <cstdlib> 
+#include <cstdio>
 #include <cmath>
+#include <limits>
 #ifdef HAVE_SYS_UTSNAME_H
 # include <sys/utsname.h> // For system information
 #endif
@@ -50,6 +52,9 @@ gnash::RcInitFile& rcfile = gnash::RcInitFile::getDefaultInstance();
 
 namespace gnash {
 
+// Define static const members.
+const int VM::unknownIndex;
+
 VM::VM(movie_root& root, VirtualClock& clock)
 	:
 	_rootMovie(root),
@@ -57,9 +62,11 @@ VM::VM(movie_root& root, VirtualClock& clock)
 	_swfversion(6),
 	_clock(clock),
 	_stack(),
+    _indexGetterSetters(false),
     _shLib(new SharedObjectLibrary(*this)),
     _rng(clock.elapsed()),
-    _constantPool(nullptr)
+    _constantPool(nullptr),
+    _actionCount(0)
 {
 	NSV::loadStrings(_stringTable);
     _global->registerClasses();
@@ -295,6 +302,54 @@ VM::getNative(unsigned int x, unsigned int y) const
     return f;
 }
 
+ObjectURI
+VM::getIndexURI(size_t index)
+{
+    if (index < _indexURIs.size()) return _indexURIs[index];
+
+    // Names are cached as the indices are met, but a distant index doesn't
+    // fill the cache with all the names below it.
+    const size_t maxGrowth = 1024;
+    const bool cache = index < _indexURIs.size() + maxGrowth;
+
+    for (size_t i = cache ? _indexURIs.size() : index; i <= index; ++i) {
+        char buf[24];
+        std::snprintf(buf, sizeof buf, "%lu", static_cast<unsigned long>(i));
+        const ObjectURI uri = getURI(*this, buf, true);
+        if (!cache) return uri;
+
+        const string_table::key k = getName(uri);
+        if (k >= _arrayIndices.size()) {
+            _arrayIndices.resize(k + 1, unknownIndex);
+        }
+        _arrayIndices[k] = i;
+        _indexURIs.push_back(uri);
+    }
+    return _indexURIs[index];
+}
+
+int
+VM::findArrayIndex(string_table::key k)
+{
+    const std::string& name = _stringTable.value(k);
+
+    // Only decimal digits without leading zeros, within int range.
+    int index = -1;
+    if (!name.empty() && name.size() <= 10 &&
+            (name.size() == 1 || name[0] != '0') &&
+            name.find_first_not_of("0123456789") == std::string::npos) {
+        const unsigned long value = std::strtoul(name.c_str(), nullptr, 10);
+        if (value <= static_cast<unsigned long>(
+                    std::numeric_limits<int>::max())) {
+            index = value;
+        }
+    }
+
+    if (k >= _arrayIndices.size()) _arrayIndices.resize(k + 1, unknownIndex);
+    _arrayIndices[k] = index;
+    return index;
+}
+
 void
 VM::dumpState(std::ostream& out, size_t limit)
 {
@@ -26,6 +26,7 @@
 
 #include <map>
 #include <memory> 
+#include <vector>
 #include <array>
 #include <cstdint>
 #include <boost/random/mersenne_twister.hpp>  // for mt11213b
@@ -248,8 +249,46 @@ public:
 
     const ConstantPool *getConstantPool() const { return _constantPool; }
 
+    /// Count an executed action, for profiling.
+    void countAction() { ++_actionCount; }
+
+    /// Return the number of actions executed so far.
+    std::uint64_t actionCount() const { return _actionCount; }
+
+    /// Return the ObjectURI naming an array index.
+    //
+    /// The names are cached, so that array accesses don't need to format
+    /// and look up the index string each time.
+    ObjectURI getIndexURI(size_t index);
+
+    /// Return the array index named by an ObjectURI.
+    //
+    /// Only the canonical form of an index is recognized: "12" is index 12,
+    /// but "012" and "+12" are not array indices.
+    //
+    /// @return     The index, or -1 if the name is not an array index.
+    int getArrayIndex(const ObjectURI& uri) {
+        const string_table::key k = getName(uri);
+        if (k < _arrayIndices.size() && _arrayIndices[k] != unknownIndex) {
+            return _arrayIndices[k];
+        }
+        return findArrayIndex(k);
+    }
+
+    /// Note that a getter-setter named like an array index was added.
+    //
+    /// Until this happens, Arrays can store elements densely without
+    /// checking their prototypes for setters.
+    void addIndexGetterSetter() { _indexGetterSetters = true; }
+
+    /// Whether any object has a getter-setter named like an array index.
+    bool indexGetterSetters() const { return _indexGetterSetters; }
+
 private:
 
+    /// Parse and cache the array index named by a string_table key.
+    int findArrayIndex(string_table::key k);
+
 	/// Stage associated with this VM
 	movie_root& _rootMovie;
 
@@ -275,12 +314,29 @@ private:
 
 	CallStack _callStack;
 
+    /// Value of _arrayIndices for keys not parsed yet.
+    static const int unknownIndex = -2;
+
+    /// The array index named by each string_table key, or -1.
+    std::vector<int> _arrayIndices;
+
+    /// The names of the array indices met so far, in index order.
+    //
+    /// These come before _shLib, as flushing the SharedObjects when it
+    /// is destroyed encodes arrays by their index names.
+    std::vector<ObjectURI> _indexURIs;
+
+    bool _indexGetterSetters;
+
 	/// Library of SharedObjects. Owned by the VM.
     std::unique_ptr<SharedObjectLibrary> _shLib;
 
     RNG _rng;
 
     const ConstantPool* _constantPool;
+
+    /// Number of actions executed
+    std::uint64_t _actionCount;
 };
 
 // @param lowerCaseHint if true the caller guarantees
@@ -118,6 +118,13 @@
 /// It's really important to *always* call set_invalidated() *before* 
 /// any call that changes the character instance in a visible way.
 /// 
+/// set_invalidated() also records the character in its parent's list of
+/// changed children, and so on up to the root. Collecting the bounds
+/// then only visits those lists: unchanged subtrees and siblings are
+/// skipped, so the cost depends on what changed rather than on the size
+/// of the scene. Display lists with mask layers are still walked
+/// entirely, to clip the bounds of masked characters to their masks.
+/// 
 /// Even if no renderer really uses this information it has effects when
 /// skipping unchanged frames. If necessary, this feature can be switched
 /// off easily in gui.cpp (maybe using a runtime option?).
@@ -115,6 +115,7 @@ AGG resources
 #include <math.h> // We use round()!
 #include <climits>
 #include <functional>
+#include <unordered_map>
 
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wunused-parameter"
@@ -157,6 +158,7 @@ AGG resources
 #include "FillStyle.h"
 #include "Transform.h"
 #include "IOChannel.h"
+#include "FrameTimes.h"
 
 #ifdef HAVE_VA_VA_H
 #include "GnashVaapiImage.h"
@@ -279,6 +281,7 @@ public:
     {
         agg::path_storage& p = *_it;
 
+        p.remove_all();
         p.move_to(twipsToPixels(in.ap.x) + _shift, 
                   twipsToPixels(in.ap.y) + _shift);
 
@@ -298,10 +301,13 @@ private:
 /// Transposes Gnash paths to AGG paths, which can be used for both outlines
 /// and shapes. Subshapes are ignored (ie. all paths are converted). Converts 
 /// TWIPS to pixels on the fly.
+//
+/// AGG paths already in dest are reused, so dest may end up with more
+/// paths than were converted.
 inline void
 buildPaths(AggPaths& dest, const GnashPaths& paths) 
 {
-    dest.resize(paths.size());
+    if (dest.size() < paths.size()) dest.resize(paths.size());
     std::for_each(paths.begin(), paths.end(), GnashToAggPath(dest, 0.05));
 } 
 
@@ -391,6 +397,176 @@ private:
     
 };
 
+// --- GLYPH COVERAGE CACHE ----------------------------------------------------
+// Text is drawn one glyph at a time, and the same glyphs are drawn at the
+// same size frame after frame. As long as a glyph is only scaled and
+// translated, two draws of it differ by whole pixels once the subpixel
+// part of the translation is equal, so its anti-aliased coverage can be
+// rasterized once and blended with the text colour afterwards. Rotated or
+// skewed glyphs are still rendered as shapes.
+// The coverage masks are stored one after the other in a single buffer
+// that is emptied when full, so the memory used is bounded.
+
+class GlyphCache
+{
+public:
+
+    /// Identifies a glyph drawn at a given scale and subpixel offset.
+    struct Key
+    {
+        /// Hash of the glyph outline, see hashOutline().
+        std::uint64_t outline;
+
+        /// Scale factors of the matrix, 16.16 fixed point.
+        std::int32_t xscale;
+        std::int32_t yscale;
+
+        /// Subpixel part of the translation, 1/20 pixels.
+        std::int32_t xoffset;
+        std::int32_t yoffset;
+
+        bool operator==(const Key& o) const {
+            return outline == o.outline && xscale == o.xscale &&
+                yscale == o.yscale && xoffset == o.xoffset &&
+                yoffset == o.yoffset;
+        }
+    };
+
+    /// What is compared besides the hash, so that two outlines with the
+    /// same hash are not taken for each other.
+    struct Outline
+    {
+        /// The number of edges of the outline.
+        size_t edges;
+
+        /// The bounds of the glyph, in twips.
+        std::int32_t xmin;
+        std::int32_t ymin;
+        std::int32_t xmax;
+        std::int32_t ymax;
+
+        bool operator==(const Outline& o) const {
+            return edges == o.edges && xmin == o.xmin && ymin == o.ymin &&
+                xmax == o.xmax && ymax == o.ymax;
+        }
+    };
+
+    /// The coverage of a glyph, one byte per pixel.
+    struct Mask
+    {
+        /// The outline the mask was rasterized from.
+        Outline outline;
+
+        /// Position of the top left pixel, relative to the glyph origin.
+        int x;
+        int y;
+
+        int width;
+        int height;
+
+        /// Offset of the first row in the cache buffer.
+        size_t offset;
+    };
+
+    /// Glyphs larger than this (in pixels) are not cached.
+    static const int maxGlyphSize = 64;
+
+    /// Size of the coverage buffer, in bytes.
+    static const size_t capacity = 256 * 1024;
+
+    /// Return the mask of a glyph, or 0 if it's not cached.
+    //
+    /// A mask whose key matches but whose outline does not belongs to
+    /// another glyph; add() replaces it.
+    const Mask* find(const Key& key, const Outline& outline) const {
+        const Masks::const_iterator it = _masks.find(key);
+        if (it == _masks.end() || !(it->second.outline == outline)) {
+            return nullptr;
+        }
+        return &it->second;
+    }
+
+    /// Store the coverage of a glyph.
+    //
+    /// @param covers   width * height bytes, row by row.
+    const Mask& add(const Key& key, const Outline& outline, int x, int y,
+            int width, int height, const std::uint8_t* covers) {
+
+        const size_t size = width * height;
+        assert(size <= capacity);
+
+        if (_buffer.size() + size > capacity) {
+            _masks.clear();
+            _buffer.clear();
+        }
+        _buffer.reserve(capacity);
+
+        const Mask mask = { outline, x, y, width, height, _buffer.size() };
+        _buffer.insert(_buffer.end(), covers, covers + size);
+        return _masks[key] = mask;
+    }
+
+    /// Return the first row of a mask.
+    const std::uint8_t* covers(const Mask& mask) const {
+        return _buffer.data() + mask.offset;
+    }
+
+    /// Hash the outline of a glyph, and describe it for find().
+    //
+    /// Glyphs are identified by their outline rather than by their font
+    /// and index, so that a cached mask never outlives its glyph.
+    static std::uint64_t hashOutline(const GnashPaths& paths,
+            const SWFRect& bounds, Outline& outline) {
+        std::uint64_t h = 14695981039346656037ULL;
+        const auto mix = [&h](std::int32_t v) {
+            h = (h ^ static_cast<std::uint32_t>(v)) * 1099511628211ULL;
+        };
+        size_t edges = 0;
+        for (const Path& p : paths) {
+            mix(p.m_fill0);
+            mix(p.m_fill1);
+            mix(p.ap.x);
+            mix(p.ap.y);
+            for (const Edge& e : p.m_edges) {
+                mix(e.cp.x);
+                mix(e.cp.y);
+                mix(e.ap.x);
+                mix(e.ap.y);
+            }
+            edges += p.m_edges.size();
+        }
+        outline.edges = edges;
+        outline.xmin = bounds.get_x_min();
+        outline.ymin = bounds.get_y_min();
+        outline.xmax = bounds.get_x_max();
+        outline.ymax = bounds.get_y_max();
+        return h;
+    }
+
+private:
+
+    struct KeyHash
+    {
+        size_t operator()(const Key& k) const {
+            std::uint64_t h = k.outline;
+            h = h * 31 + static_cast<std::uint32_t>(k.xscale);
+            h = h * 31 + static_cast<std::uint32_t>(k.yscale);
+            h = h * 31 + static_cast<std::uint32_t>(k.xoffset);
+            h = h * 31 + static_cast<std::uint32_t>(k.yoffset);
+            return h;
+        }
+    };
+
+    typedef std::unordered_map<Key, Mask, KeyHash> Masks;
+
+    Masks _masks;
+
+    std::vector<std::uint8_t> _buffer;
+};
+
+const int GlyphCache::maxGlyphSize;
+const size_t GlyphCache::capacity;
+
 /// Class for rendering lines.
 template<typename PixelFormat>
 class LineRenderer
@@ -728,6 +904,7 @@ public:
     void drawVideoFrame(image::GnashImage* frame, const Transform& xform,
         const SWFRect* bounds, bool smooth)
     {
+        GNASH_FRAME_PHASE(RASTERIZE);
     
         // NOTE: Assuming that the source image is RGB 8:8:8
         // TODO: keep heavy instances alive accross frames for performance!
@@ -1019,6 +1196,8 @@ public:
   void drawGlyph(const SWF::ShapeRecord& shape, const rgba& color,
           const SWFMatrix& mat) 
   {
+    GNASH_FRAME_PHASE(RASTERIZE);
+
     if (shape.subshapes().empty()) return;
     //assert(shape.subshapes().size() == 1);
     
@@ -1029,6 +1208,11 @@ public:
     select_clipbounds(shape.getBounds(), mat);
     
     if (_clipbounds_selected.empty()) return; 
+
+    if (!m_drawing_mask && drawCachedGlyph(shape, color, mat)) {
+      _clipbounds_selected.clear();
+      return;
+    }
       
     GnashPaths paths;
     apply_matrix_to_path(shape.subshapes().front().paths(), paths, mat);
@@ -1058,6 +1242,141 @@ public:
   }
 
 
+  /// Draws a glyph from its cached coverage, rasterizing it on first use.
+  //
+  /// Uses _clipbounds_selected like draw_shape().
+  ///
+  /// @return false if the glyph has to be drawn as a shape instead: when
+  ///         it's rotated, skewed or too large, or when a mask is active.
+  bool drawCachedGlyph(const SWF::ShapeRecord& shape, const rgba& color,
+          const SWFMatrix& source_mat)
+  {
+    if (!_alphaMasks.empty()) return false;
+
+    // Same transformation as apply_matrix_to_path(), in 1/20 pixels.
+    SWFMatrix mat;
+    mat.concatenate_scale(20.0,  20.0);
+    mat.concatenate(stage_matrix);
+    mat.concatenate(source_mat);
+
+    if (mat.b() || mat.c()) return false;
+
+    // Split the translation into whole pixels and a subpixel offset.
+    const std::int32_t xoffset = ((mat.tx() % 20) + 20) % 20;
+    const std::int32_t yoffset = ((mat.ty() % 20) + 20) % 20;
+    const int x = (mat.tx() - xoffset) / 20;
+    const int y = (mat.ty() - yoffset) / 20;
+    mat.set_translation(xoffset, yoffset);
+
+    const GnashPaths& outline = shape.subshapes().front().paths();
+    GlyphCache::Outline glyph;
+    const GlyphCache::Key key = {
+        GlyphCache::hashOutline(outline, shape.getBounds(), glyph),
+        mat.a(), mat.d(), xoffset, yoffset };
+
+    const GlyphCache::Mask* mask = _glyphCache.find(key, glyph);
+
+    if (!mask) {
+
+      // Glyphs only have the one fill style. Anything else is drawn as
+      // a shape, so check before rasterizing it here for nothing.
+      for (const Path& path : outline) {
+        if (path.m_fill0 > 1 || path.m_fill1 > 1) return false;
+      }
+
+      // Leave a pixel on each side for the anti-aliased edges, so that
+      // the coverage fits when the bounds do.
+      SWFRect bounds = shape.getBounds();
+      mat.transform(bounds);
+      if (bounds.width() > (GlyphCache::maxGlyphSize - 2) * 20 ||
+              bounds.height() > (GlyphCache::maxGlyphSize - 2) * 20) {
+        return false;
+      }
+
+      GnashPaths paths = outline;
+      for (Path& path : paths) path.transform(mat);
+
+      AggPaths agg_paths;
+      buildPaths(agg_paths, paths);
+
+      // Rasterize as draw_shape_impl() does, but keep the coverage.
+      typedef agg::rasterizer_compound_aa<agg::rasterizer_sl_clip_int>
+          ras_type;
+      ras_type rasc;
+      rasc.filling_rule(agg::fill_non_zero);
+
+      for (size_t pno = 0; pno < paths.size(); ++pno) {
+        const Path& this_path_gnash = paths[pno];
+        if (!this_path_gnash.m_fill0 && !this_path_gnash.m_fill1) continue;
+        agg::conv_curve<agg::path_storage> curve(agg_paths[pno]);
+        rasc.styles(this_path_gnash.m_fill0 - 1, this_path_gnash.m_fill1 - 1);
+        rasc.add_path(curve);
+      }
+
+      if (!rasc.rewind_scanlines()) {
+        mask = &_glyphCache.add(key, glyph, 0, 0, 0, 0, nullptr);
+      }
+      else {
+        const int minx = rasc.min_x();
+        const int miny = rasc.min_y();
+        const int width = rasc.max_x() - minx + 1;
+        const int height = rasc.max_y() - miny + 1;
+        if (width > GlyphCache::maxGlyphSize ||
+                height > GlyphCache::maxGlyphSize) {
+          return false;
+        }
+
+        std::vector<std::uint8_t> covers(width * height);
+        agg::scanline_u8 sl;
+        sl.reset(minx, rasc.max_x());
+
+        unsigned num_styles;
+        while ((num_styles = rasc.sweep_styles()) > 0) {
+          // Checked above.
+          if (num_styles != 1 || rasc.style(0) != 0) return false;
+          if (!rasc.sweep_scanline(sl, 0)) continue;
+
+          std::uint8_t* row = &covers[(sl.y() - miny) * width];
+          agg::scanline_u8::const_iterator span = sl.begin();
+          for (unsigned n = sl.num_spans(); n; --n, ++span) {
+            std::copy(span->covers, span->covers + span->len,
+                    row + span->x - minx);
+          }
+        }
+        mask = &_glyphCache.add(key, glyph, minx, miny, width, height,
+                covers.data());
+      }
+    }
+
+    // Blend the covered runs of each row, as render_scanline_aa_solid()
+    // blends the spans of a scanline.
+    const agg::rgba8 c = agg::rgba8_pre(color.m_r, color.m_g, color.m_b,
+            color.m_a);
+    const std::uint8_t* covers = _glyphCache.covers(*mask);
+    const int left = x + mask->x;
+    const int top = y + mask->y;
+
+    for (const geometry::Range2d<int>* bounds : _clipbounds_selected) {
+
+      const int x0 = std::max(left, bounds->getMinX());
+      const int x1 = std::min(left + mask->width - 1, bounds->getMaxX());
+      const int y0 = std::max(top, bounds->getMinY());
+      const int y1 = std::min(top + mask->height - 1, bounds->getMaxY());
+
+      for (int py = y0; py <= y1; ++py) {
+        const std::uint8_t* row = covers + (py - top) * mask->width;
+        for (int px = x0; px <= x1; ++px) {
+          if (!row[px - left]) continue;
+          const int start = px;
+          while (px < x1 && row[px + 1 - left]) ++px;
+          m_rbase->blend_solid_hspan(start, py, px - start + 1, c,
+                  row + start - left);
+        }
+      }
+    }
+    return true;
+  }
+
   /// Fills _clipbounds_selected with pointers to _clipbounds members who
   /// intersect with the given character (transformed by mat). This avoids
   /// rendering of characters outside a particular clipping range.
@@ -1107,6 +1426,8 @@ public:
 
     void drawShape(const SWF::ShapeRecord& shape, const Transform& xform)
     {
+        GNASH_FRAME_PHASE(RASTERIZE);
+
         // check if the character needs to be rendered at all
         SWFRect cur_bounds;
 
@@ -1147,7 +1468,7 @@ public:
             return; 
         }
 
-        GnashPaths paths;
+        GnashPaths& paths = _paths;
         apply_matrix_to_path(objpaths, paths, mat);
 
         // Masks apparently do not use agg_paths, so return
@@ -1160,8 +1481,8 @@ public:
             return;
         }
 
-        AggPaths agg_paths;    
-        AggPaths agg_paths_rounded;    
+        AggPaths& agg_paths = _aggPaths;
+        AggPaths& agg_paths_rounded = _aggPathsRounded;
 
         // Flash only aligns outlines. Probably this is done at rendering
         // level.
@@ -1245,12 +1566,13 @@ public:
     
     const size_t pcount = paths.size();
 
-    dest.resize(pcount);    
+    if (dest.size() < pcount) dest.resize(pcount);
     
     for (size_t pno=0; pno<pcount; ++pno) {
       
       const Path& this_path = paths[pno];
       agg::path_storage& new_path = dest[pno];
+      new_path.remove_all();
       
       bool hinting=false, closed=false, hairline=false;
       
@@ -2020,6 +2342,17 @@ private:  // private variables
     /// Cached fill style list with just one entry used for font rendering
     std::vector<FillStyle> m_single_FillStyles;
 
+    /// Coverage of recently drawn glyphs.
+    GlyphCache _glyphCache;
+
+    /// Transformed and AGG paths of the shape being drawn.
+    //
+    /// These are kept between shapes so that their storage is reused
+    /// rather than allocated again for every shape in every frame.
+    GnashPaths _paths;
+    AggPaths _aggPaths;
+    AggPaths _aggPathsRounded;
+
 
 };
 